@@ -0,0 +1,29 @@
+#include <Base/MTQueue.h>
+#include <Base/benchmark.h>
+
+#include <thread>
+
+static void BM_MTQueuePushPop(Lute::bench::State& state) {
+    Lute::MTQueue<int> que;
+    while (state.keepRunning()) {
+        que.push(1);
+        int v = que.pop();
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK(BM_MTQueuePushPop);
+
+/// One producer thread, the benchmark thread consumes
+static void BM_MTQueueHandoff(Lute::bench::State& state) {
+    Lute::MTQueue<int> que;
+    const int64_t n = state.iterations();
+    std::thread producer([&que, n] {
+        for (int64_t i = 0; i < n; ++i) que.push(static_cast<int>(i));
+    });
+    while (state.keepRunning()) {
+        int v = que.pop();
+        Lute::bench::DoNotOptimize(v);
+    }
+    producer.join();
+}
+LUTE_BENCHMARK(BM_MTQueueHandoff);
@@ -0,0 +1,41 @@
+#include <Base/any.h>
+#include <Base/benchmark.h>
+
+#include <any>
+#include <memory>
+
+namespace {
+/// A task payload: too big for std::any's inline buffer
+struct Payload {
+    void* context;
+    int64_t id;
+    int64_t deadline;
+};
+}  // namespace
+
+static void BM_stdAny(Lute::bench::State& state) {
+    Payload payload{nullptr, 1, 2};
+    while (state.keepRunning()) {
+        std::any a = payload;
+        Lute::bench::DoNotOptimize(a);
+    }
+}
+LUTE_BENCHMARK(BM_stdAny);
+
+static void BM_basicAny(Lute::bench::State& state) {
+    Payload payload{nullptr, 1, 2};
+    while (state.keepRunning()) {
+        Lute::basic_any<> a = payload;
+        Lute::bench::DoNotOptimize(a);
+    }
+}
+LUTE_BENCHMARK(BM_basicAny);
+
+static void BM_uniqueAny(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        Lute::unique_any<> a = std::unique_ptr<int>();
+        Lute::unique_any<> b = std::move(a);
+        Lute::bench::DoNotOptimize(b);
+    }
+}
+LUTE_BENCHMARK(BM_uniqueAny);
@@ -0,0 +1,88 @@
+#include <Base/arena.h>
+#include <Base/benchmark.h>
+#include <Base/bytearray.h>
+
+#include <list>
+#include <vector>
+
+/// A request-scoped object: allocated, used, freed
+static void BM_newDelete64(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        char* p = new char[64];
+        Lute::bench::DoNotOptimize(p);
+        delete[] p;
+    }
+}
+LUTE_BENCHMARK(BM_newDelete64);
+
+static void BM_poolAllocate64(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        void* p = Lute::ThreadCachePool::allocate(64);
+        Lute::bench::DoNotOptimize(p);
+        Lute::ThreadCachePool::deallocate(p, 64);
+    }
+}
+LUTE_BENCHMARK(BM_poolAllocate64);
+
+static void BM_arenaAllocate64(Lute::bench::State& state) {
+    Lute::Arena arena(64 * 1024);
+    int64_t n = 0;
+    while (state.keepRunning()) {
+        void* p = arena.allocate(64);
+        Lute::bench::DoNotOptimize(p);
+        if (++n % 1024 == 0) arena.reset();
+    }
+}
+LUTE_BENCHMARK(BM_arenaAllocate64);
+
+/// Build and destroy a list of `arg` nodes
+static void BM_stdList(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        std::list<int64_t> list;
+        for (int64_t i = 0; i < state.arg(); ++i) list.push_back(i);
+        Lute::bench::DoNotOptimize(list);
+    }
+}
+LUTE_BENCHMARK_ARG(BM_stdList, 1000);
+
+static void BM_poolList(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        std::list<int64_t, Lute::PoolAllocator<int64_t>> list;
+        for (int64_t i = 0; i < state.arg(); ++i) list.push_back(i);
+        Lute::bench::DoNotOptimize(list);
+    }
+}
+LUTE_BENCHMARK_ARG(BM_poolList, 1000);
+
+static void BM_arenaList(Lute::bench::State& state) {
+    Lute::Arena arena(64 * 1024);
+    Lute::ArenaResource resource(&arena);
+    while (state.keepRunning()) {
+        {
+            std::pmr::list<int64_t> list(&resource);
+            for (int64_t i = 0; i < state.arg(); ++i) list.push_back(i);
+            Lute::bench::DoNotOptimize(list);
+        }
+        arena.reset();
+    }
+}
+LUTE_BENCHMARK_ARG(BM_arenaList, 1000);
+
+/// A ByteArray per request, spilling over a few nodes
+static void BM_ByteArrayRequest(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        Lute::ByteArray ba(256);
+        for (int i = 0; i < 256; ++i) ba.writeFint32(i);
+        Lute::bench::DoNotOptimize(ba);
+    }
+}
+LUTE_BENCHMARK(BM_ByteArrayRequest);
+
+static void BM_ByteArrayRequestPool(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        Lute::ByteArray ba(256, Lute::PoolResource::instance());
+        for (int i = 0; i < 256; ++i) ba.writeFint32(i);
+        Lute::bench::DoNotOptimize(ba);
+    }
+}
+LUTE_BENCHMARK(BM_ByteArrayRequestPool);
@@ -0,0 +1,51 @@
+#include <Base/benchmark.h>
+#include <Base/bytearray.h>
+
+#include <string>
+
+static void BM_ByteArrayFixed32(Lute::bench::State& state) {
+    Lute::ByteArray ba(4096);
+    const int kBatch = 1024;
+    while (state.keepRunning()) {
+        if (ba.position() >= kBatch * sizeof(int32_t)) {
+            state.pauseTiming();
+            ba.clear();
+            state.resumeTiming();
+        }
+        ba.writeFint32(0x12345678);
+    }
+    state.setBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(sizeof(int32_t)));
+}
+LUTE_BENCHMARK(BM_ByteArrayFixed32);
+
+static void BM_ByteArrayVarint64(Lute::bench::State& state) {
+    Lute::ByteArray ba(4096);
+    const int kBatch = 1024;
+    int64_t n = 0;
+    while (state.keepRunning()) {
+        if (++n % kBatch == 0) {
+            state.pauseTiming();
+            ba.clear();
+            state.resumeTiming();
+        }
+        ba.writeInt64(n * 0x9E3779B97F4A7C15LL);
+    }
+}
+LUTE_BENCHMARK(BM_ByteArrayVarint64);
+
+static void BM_ByteArrayRoundTrip(Lute::bench::State& state) {
+    Lute::ByteArray ba(static_cast<size_t>(state.arg()));
+    while (state.keepRunning()) {
+        ba.writeUint32(42);
+        ba.writeStringVint("Hello ByteArray");
+        ba.setPosition(0);
+        uint32_t v = ba.readUint32();
+        std::string s = ba.readStringVint();
+        Lute::bench::DoNotOptimize(v);
+        Lute::bench::DoNotOptimize(s);
+        ba.clear();
+    }
+}
+LUTE_BENCHMARK_ARG(BM_ByteArrayRoundTrip, 64);
+LUTE_BENCHMARK_ARG(BM_ByteArrayRoundTrip, 4096);
@@ -0,0 +1,65 @@
+#include <Base/benchmark.h>
+#include <Base/concurrentHashMap.h>
+#include <Base/thread.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+const int kKeys = 4096;
+
+/// `arg - 1` background threads look up while the measured one does too
+template <typename Lookup>
+void lookups(Lute::bench::State& state, Lookup&& lookup) {
+    std::atomic<bool> stop(false);
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int64_t t = 1; t < state.arg(); ++t) {
+        threads.emplace_back(new Lute::Thread([&stop, &lookup] {
+            int key = 0;
+            while (!stop.load(std::memory_order_relaxed))
+                lookup(key++ & (kKeys - 1));
+        }));
+        threads.back()->start();
+    }
+    int key = 0;
+    while (state.keepRunning()) lookup(key++ & (kKeys - 1));
+    stop = true;
+    for (auto& thread : threads) thread->join();
+}
+}  // namespace
+
+static void BM_mutexMapFind(Lute::bench::State& state) {
+    Lute::MutexLock mutex;
+    std::unordered_map<int, int64_t> map;
+    for (int i = 0; i < kKeys; ++i) map[i] = i;
+    lookups(state, [&mutex, &map](int key) {
+        Lute::MutexLockGuard lock(mutex);
+        auto it = map.find(key);
+        Lute::bench::DoNotOptimize(it->second);
+    });
+}
+LUTE_BENCHMARK_ARG(BM_mutexMapFind, 1);
+LUTE_BENCHMARK_ARG(BM_mutexMapFind, 4);
+
+static void BM_concurrentMapFind(Lute::bench::State& state) {
+    Lute::ConcurrentHashMap<int, int64_t> map;
+    for (int i = 0; i < kKeys; ++i) map.insertOrAssign(i, i);
+    lookups(state, [&map](int key) {
+        int64_t value = 0;
+        map.find(key, &value);
+        Lute::bench::DoNotOptimize(value);
+    });
+}
+LUTE_BENCHMARK_ARG(BM_concurrentMapFind, 1);
+LUTE_BENCHMARK_ARG(BM_concurrentMapFind, 4);
+
+static void BM_concurrentMapInsertOrAssign(Lute::bench::State& state) {
+    Lute::ConcurrentHashMap<int, int64_t> map;
+    int64_t n = 0;
+    while (state.keepRunning()) {
+        map.insertOrAssign(static_cast<int>(n & (kKeys - 1)), n);
+        ++n;
+    }
+}
+LUTE_BENCHMARK(BM_concurrentMapInsertOrAssign);
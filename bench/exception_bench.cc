@@ -0,0 +1,37 @@
+#include <Base/benchmark.h>
+#include <Base/exception.h>
+
+#include <stdexcept>
+
+namespace {
+/// A parser bailing out from a few frames down, like the callers that use
+/// exceptions for control flow
+template <typename E>
+__attribute__((noinline)) void parseLevel(int depth) {
+    if (depth == 0) throw E("unexpected token");
+    parseLevel<E>(depth - 1);
+    Lute::bench::ClobberMemory();
+}
+}  // namespace
+
+static void BM_throwStdException(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        try {
+            parseLevel<std::runtime_error>(4);
+        } catch (const std::exception& e) {
+            Lute::bench::DoNotOptimize(e);
+        }
+    }
+}
+LUTE_BENCHMARK(BM_throwStdException);
+
+static void BM_throwLuteException(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        try {
+            parseLevel<Lute::Exception>(4);
+        } catch (const Lute::Exception& e) {
+            Lute::bench::DoNotOptimize(e);
+        }
+    }
+}
+LUTE_BENCHMARK(BM_throwLuteException);
@@ -0,0 +1,44 @@
+#include <Base/MTQueue.h>
+#include <Base/benchmark.h>
+#include <Base/function.h>
+
+#include <functional>
+
+namespace {
+/// A task capturing a few words, beyond std::function's 16-byte buffer
+struct Task {
+    int64_t* sum;
+    int64_t a;
+    int64_t b;
+    void operator()() const { *sum += a + b; }
+};
+}  // namespace
+
+template <typename Func>
+static void submitAndRun(Lute::bench::State& state) {
+    Lute::MTQueue<Func> que;
+    int64_t sum = 0;
+    while (state.keepRunning()) {
+        que.push(Func(Task{&sum, 1, 2}));
+        que.pop()();
+    }
+    Lute::bench::DoNotOptimize(sum);
+}
+
+static void BM_stdFunctionSubmit(Lute::bench::State& state) {
+    submitAndRun<std::function<void()> >(state);
+}
+LUTE_BENCHMARK(BM_stdFunctionSubmit);
+
+static void BM_uniqueFunctionSubmit(Lute::bench::State& state) {
+    submitAndRun<Lute::UniqueFunction<void()> >(state);
+}
+LUTE_BENCHMARK(BM_uniqueFunctionSubmit);
+
+static void BM_inplaceFunctionCall(Lute::bench::State& state) {
+    int64_t sum = 0;
+    Lute::InplaceFunction<void()> f = Task{&sum, 1, 2};
+    while (state.keepRunning()) f();
+    Lute::bench::DoNotOptimize(sum);
+}
+LUTE_BENCHMARK(BM_inplaceFunctionCall);
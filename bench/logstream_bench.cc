@@ -0,0 +1,74 @@
+#include <Base/benchmark.h>
+#include <Base/logger.h>
+
+#include <cstring>
+#include <string>
+
+static void BM_LogStreamInt(Lute::bench::State& state) {
+    Lute::LogStream os;
+    int64_t i = 0;
+    while (state.keepRunning()) {
+        if (os.buffer().avail() < 64) os.resetBuffer();
+        os << ++i;
+    }
+    Lute::bench::DoNotOptimize(os.buffer().data());
+}
+LUTE_BENCHMARK(BM_LogStreamInt);
+
+static void BM_LogStreamDouble(Lute::bench::State& state) {
+    Lute::LogStream os;
+    double d = 0.0;
+    while (state.keepRunning()) {
+        if (os.buffer().avail() < 64) os.resetBuffer();
+        os << (d += 1.25);
+    }
+    Lute::bench::DoNotOptimize(os.buffer().data());
+}
+LUTE_BENCHMARK(BM_LogStreamDouble);
+
+static void BM_LogStreamLine(Lute::bench::State& state) {
+    Lute::LogStream os;
+    const std::string msg = "Hello 0123456789 abcdefghijklmnopqrstuvwxyz";
+    while (state.keepRunning()) {
+        os.resetBuffer();
+        os << "2023/01/01 00:00:00 " << 12345 << " INFO  " << msg << ' '
+           << 3.14 << '\n';
+        Lute::bench::DoNotOptimize(os.buffer().data());
+    }
+}
+LUTE_BENCHMARK(BM_LogStreamLine);
+
+namespace {
+char g_sink[2 * Lute::detail::kSmallBuffer];
+void nullOutput(const char* msg, int len) {
+    ::memcpy(g_sink, msg, static_cast<size_t>(len));
+}
+bool sinkReserve(int maxLen, Lute::Logger::Reservation* line) {
+    line->data = g_sink;
+    line->capacity = maxLen;
+    line->token = nullptr;
+    return true;
+}
+void sinkCommit(const Lute::Logger::Reservation&, int len) {
+    Lute::bench::DoNotOptimize(len);
+}
+}  // namespace
+
+/// A LOG_INFO line formatted aside and copied to the output
+static void BM_LoggerLineCopy(Lute::bench::State& state) {
+    Lute::Logger::setOutput(nullOutput);
+    int64_t i = 0;
+    while (state.keepRunning())
+        LOG_INFO << "Hello 0123456789 abcdefghijklmnopqrstuvwxyz " << ++i;
+}
+LUTE_BENCHMARK(BM_LoggerLineCopy);
+
+/// The same line formatted straight into the output's reservation
+static void BM_LoggerLineReserve(Lute::bench::State& state) {
+    Lute::Logger::setReserve(sinkReserve, sinkCommit);
+    int64_t i = 0;
+    while (state.keepRunning())
+        LOG_INFO << "Hello 0123456789 abcdefghijklmnopqrstuvwxyz " << ++i;
+    Lute::Logger::setOutput(nullOutput);
+}
+LUTE_BENCHMARK(BM_LoggerLineReserve);
@@ -0,0 +1,9 @@
+///
+/// @brief Microbenchmarks of the library hot paths
+/// @usage
+///     ./bench [--filter=SUBSTR] [--min_time=SEC] [--samples=N] [--json=FILE]
+///
+
+#include <Base/benchmark.h>
+
+LUTE_BENCHMARK_MAIN();
@@ -0,0 +1,37 @@
+#include <Base/benchmark.h>
+#include <Base/mutex.h>
+
+#include <atomic>
+#include <thread>
+
+static void BM_MutexLockUncontended(Lute::bench::State& state) {
+    Lute::MutexLock mutex;
+    int64_t counter = 0;
+    while (state.keepRunning()) {
+        Lute::MutexLockGuard lock(mutex);
+        ++counter;
+    }
+    Lute::bench::DoNotOptimize(counter);
+}
+LUTE_BENCHMARK(BM_MutexLockUncontended);
+
+/// One background thread hammers the same lock
+static void BM_MutexLockContended(Lute::bench::State& state) {
+    Lute::MutexLock mutex;
+    int64_t counter = 0;
+    std::atomic<bool> done(false);
+    std::thread other([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            Lute::MutexLockGuard lock(mutex);
+            ++counter;
+        }
+    });
+    while (state.keepRunning()) {
+        Lute::MutexLockGuard lock(mutex);
+        ++counter;
+    }
+    done = true;
+    other.join();
+    Lute::bench::DoNotOptimize(counter);
+}
+LUTE_BENCHMARK(BM_MutexLockContended);
@@ -0,0 +1,55 @@
+#include <Base/benchmark.h>
+#include <Base/perCpu.h>
+#include <Base/thread.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+using Counter = std::atomic<int64_t>;
+
+/// `arg` threads increment through `inc` for the whole sample
+template <typename Inc>
+void contended(Lute::bench::State& state, Inc&& inc) {
+    std::atomic<bool> stop(false);
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int64_t t = 1; t < state.arg(); ++t) {
+        threads.emplace_back(new Lute::Thread([&stop, &inc] {
+            while (!stop.load(std::memory_order_relaxed)) inc();
+        }));
+        threads.back()->start();
+    }
+    while (state.keepRunning()) inc();
+    stop = true;
+    for (auto& thread : threads) thread->join();
+}
+}  // namespace
+
+static void BM_sharedAtomicInc(Lute::bench::State& state) {
+    Counter counter(0);
+    contended(state, [&counter] {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    });
+}
+LUTE_BENCHMARK_ARG(BM_sharedAtomicInc, 1);
+LUTE_BENCHMARK_ARG(BM_sharedAtomicInc, 4);
+
+static void BM_perCpuInc(Lute::bench::State& state) {
+    Lute::PerCpu<Counter> counter(0);
+    contended(state, [&counter] {
+        counter.local().fetch_add(1, std::memory_order_relaxed);
+    });
+}
+LUTE_BENCHMARK_ARG(BM_perCpuInc, 1);
+LUTE_BENCHMARK_ARG(BM_perCpuInc, 4);
+
+static void BM_perThreadInc(Lute::bench::State& state) {
+    Lute::PerThread<Counter> counter(0);
+    contended(state, [&counter] {
+        Counter& c = counter.local();
+        c.store(c.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    });
+}
+LUTE_BENCHMARK_ARG(BM_perThreadInc, 1);
+LUTE_BENCHMARK_ARG(BM_perThreadInc, 4);
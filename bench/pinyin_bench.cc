@@ -0,0 +1,88 @@
+#include <Base/benchmark.h>
+#include <Base/pinyinParser.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+const Lute::PinyinParser& parser() {
+    static Lute::PinyinParser p;
+    return p;
+}
+
+std::vector<std::string> makeLines(size_t n) {
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < n; ++i)
+        lines.push_back(i % 2 ? "用户名 zhang_san 登录成功, id=12345"
+                              : "中华人民共和国 mixed with some ASCII text");
+    return lines;
+}
+}  // namespace
+
+/// Cold start: parsing the text file vs the builtin tables
+static void BM_pinyinLoad(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        Lute::PinyinParser p;
+        p.InitPinyinMap(LUTE_SOURCE_DIR "/include/Base/pinyin.txt");
+        Lute::bench::DoNotOptimize(p);
+    }
+}
+LUTE_BENCHMARK(BM_pinyinLoad);
+
+static void BM_pinyinBuiltin(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        Lute::PinyinParser p;
+        Lute::bench::DoNotOptimize(p);
+    }
+}
+LUTE_BENCHMARK(BM_pinyinBuiltin);
+
+static void BM_ConvertZh2Pinyin(Lute::bench::State& state) {
+    auto& p = const_cast<Lute::PinyinParser&>(parser());
+    std::vector<std::string> lines = makeLines(1000);
+    int64_t bytes = 0;
+    for (const auto& line : lines) bytes += static_cast<int64_t>(line.size());
+    while (state.keepRunning()) {
+        for (auto& line : lines) {
+            std::string out;
+            p.ConvertZh2Pinyin(line, out);
+            Lute::bench::DoNotOptimize(out);
+        }
+    }
+    state.setBytesProcessed(bytes * state.iterations());
+}
+LUTE_BENCHMARK(BM_ConvertZh2Pinyin);
+
+static void BM_pinyinBatch(Lute::bench::State& state) {
+    std::vector<std::string> lines = makeLines(100000);
+    int64_t bytes = 0;
+    for (const auto& line : lines) bytes += static_cast<int64_t>(line.size());
+    Lute::PinyinArena arena;
+    while (state.keepRunning()) {
+        arena.clear();
+        parser().convertBatch(lines, &arena, static_cast<int>(state.arg()));
+        Lute::bench::DoNotOptimize(arena);
+    }
+    state.setBytesProcessed(bytes * state.iterations());
+}
+LUTE_BENCHMARK_ARG(BM_pinyinBatch, 1);
+LUTE_BENCHMARK_ARG(BM_pinyinBatch, 0);
+
+static void BM_pinyinAllModes(Lute::bench::State& state) {
+    std::vector<std::string> lines = makeLines(1000);
+    int64_t bytes = 0;
+    for (const auto& line : lines) bytes += static_cast<int64_t>(line.size());
+    Lute::PinyinResult result;
+    const unsigned modes =
+        Lute::PinyinParser::kPlain | Lute::PinyinParser::kTone |
+        Lute::PinyinParser::kInitials | Lute::PinyinParser::kSegments;
+    while (state.keepRunning()) {
+        for (const auto& line : lines) {
+            result.clear();
+            parser().convert(line, modes, &result);
+            Lute::bench::DoNotOptimize(result);
+        }
+    }
+    state.setBytesProcessed(bytes * state.iterations());
+}
+LUTE_BENCHMARK(BM_pinyinAllModes);
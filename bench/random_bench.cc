@@ -0,0 +1,59 @@
+#include <Base/benchmark.h>
+#include <Base/random.h>
+#include <Base/utils.h>
+
+#include <vector>
+
+static void BM_randomUniform(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        int v = Lute::randomUniform<int, 0, 999>();
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK(BM_randomUniform);
+
+static void BM_randomBounded(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        uint64_t v = Lute::randomBounded(1000);
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK(BM_randomBounded);
+
+static void BM_randomDouble(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        double v = Lute::randomDouble();
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK(BM_randomDouble);
+
+static void BM_wyrand(Lute::bench::State& state) {
+    Lute::WyRand rng(42);
+    while (state.keepRunning()) {
+        uint64_t v = Lute::boundedRandom(rng, 1000);
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK(BM_wyrand);
+
+static void BM_fillRandom(Lute::bench::State& state) {
+    std::vector<uint64_t> words(static_cast<size_t>(state.arg()));
+    while (state.keepRunning()) {
+        Lute::fillRandom(words.data(), words.size());
+        Lute::bench::ClobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * state.arg() * 8);
+}
+LUTE_BENCHMARK_ARG(BM_fillRandom, 4096);
+
+static void BM_fillRandomScalar(Lute::bench::State& state) {
+    std::vector<uint64_t> words(static_cast<size_t>(state.arg()));
+    Lute::Xoshiro256ss& rng = Lute::threadRandom();
+    while (state.keepRunning()) {
+        for (uint64_t& w : words) w = rng();
+        Lute::bench::ClobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * state.arg() * 8);
+}
+LUTE_BENCHMARK_ARG(BM_fillRandomScalar, 4096);
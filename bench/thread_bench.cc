@@ -0,0 +1,36 @@
+#include <Base/benchmark.h>
+#include <Base/currentThread.h>
+#include <Base/thread.h>
+
+static void BM_threadStartJoin(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        Lute::Thread thread([] {});
+        thread.start();
+        thread.join();
+    }
+}
+LUTE_BENCHMARK(BM_threadStartJoin);
+
+static void BM_currentThreadIndex(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        int index = Lute::CurrentThread::index();
+        Lute::bench::DoNotOptimize(index);
+    }
+}
+LUTE_BENCHMARK(BM_currentThreadIndex);
+
+static void BM_currentThreadCpu(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        int cpu = Lute::CurrentThread::cpu();
+        Lute::bench::DoNotOptimize(cpu);
+    }
+}
+LUTE_BENCHMARK(BM_currentThreadCpu);
+
+static void BM_schedGetcpu(Lute::bench::State& state) {
+    while (state.keepRunning()) {
+        int cpu = ::sched_getcpu();
+        Lute::bench::DoNotOptimize(cpu);
+    }
+}
+LUTE_BENCHMARK(BM_schedGetcpu);
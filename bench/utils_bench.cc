@@ -0,0 +1,196 @@
+#include <Base/ahoCorasick.h>
+#include <Base/benchmark.h>
+#include <Base/split.h>
+#include <Base/utils.h>
+
+#include <string>
+
+static const char kText[] =
+    "  Hello 0123456789 abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ "
+    "Hello 0123456789 abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ  ";
+
+static void BM_toUpper(Lute::bench::State& state) {
+    std::string s = kText;
+    while (state.keepRunning()) {
+        Lute::toUpper(s);
+        Lute::bench::DoNotOptimize(s);
+    }
+    state.setBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(s.size()));
+}
+LUTE_BENCHMARK(BM_toUpper);
+
+static void BM_toLower(Lute::bench::State& state) {
+    std::string s = kText;
+    while (state.keepRunning()) {
+        Lute::toLower(s);
+        Lute::bench::DoNotOptimize(s);
+    }
+    state.setBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(s.size()));
+}
+LUTE_BENCHMARK(BM_toLower);
+
+static void BM_toUpperView(Lute::bench::State& state) {
+    const std::string src = kText;
+    char buf[sizeof kText];
+    while (state.keepRunning()) {
+        Lute::string_view v = Lute::toUpper(src, buf);
+        Lute::bench::DoNotOptimize(v);
+        Lute::bench::ClobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(src.size()));
+}
+LUTE_BENCHMARK(BM_toUpperView);
+
+static void BM_trim(Lute::bench::State& state) {
+    const std::string src = kText;
+    std::string s;
+    while (state.keepRunning()) {
+        s = src;
+        Lute::trim(s);
+        Lute::bench::DoNotOptimize(s);
+    }
+}
+LUTE_BENCHMARK(BM_trim);
+
+static void BM_trimView(Lute::bench::State& state) {
+    const std::string src =
+        std::string(static_cast<size_t>(state.arg()), ' ') + kText;
+    while (state.keepRunning()) {
+        Lute::string_view v = Lute::trimView(src);
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK_ARG(BM_trimView, 0);
+LUTE_BENCHMARK_ARG(BM_trimView, 64);
+
+static void BM_replace(Lute::bench::State& state) {
+    const std::string src = kText;
+    std::string s;
+    while (state.keepRunning()) {
+        s = src;
+        Lute::replace(s, "Hello", "Bye");
+        Lute::bench::DoNotOptimize(s);
+    }
+}
+LUTE_BENCHMARK(BM_replace);
+
+static void BM_replaceGrow(Lute::bench::State& state) {
+    const std::string src = kText;
+    std::string s;
+    while (state.keepRunning()) {
+        s = src;
+        Lute::replace(s, "o", "<o>");
+        Lute::bench::DoNotOptimize(s);
+    }
+}
+LUTE_BENCHMARK(BM_replaceGrow);
+
+static void BM_split(Lute::bench::State& state) {
+    const std::string csv = "id,name,age,city,,score,rank,level,tags,extra";
+    while (state.keepRunning()) {
+        size_t n = 0;
+        for (Lute::string_view field : Lute::split(csv, ','))
+            n += field.size();
+        Lute::bench::DoNotOptimize(n);
+    }
+}
+LUTE_BENCHMARK(BM_split);
+
+static void BM_tokenize(Lute::bench::State& state) {
+    const std::string src = kText;
+    while (state.keepRunning()) {
+        size_t n = 0;
+        for (Lute::string_view word : Lute::tokenize(src)) n += word.size();
+        Lute::bench::DoNotOptimize(n);
+    }
+}
+LUTE_BENCHMARK(BM_tokenize);
+
+static void BM_ahoCorasick(Lute::bench::State& state) {
+    const Lute::AhoCorasick ac({{"${host}", "lute-polaris-01"},
+                                {"${pid}", "12345"},
+                                {"${level}", "INFO"},
+                                {"${thread}", "worker-3"}});
+    const std::string tmpl =
+        "${level} [${host}:${pid}] ${thread} " + std::string(kText);
+    std::string out;
+    while (state.keepRunning()) {
+        out.clear();
+        ac.replace(tmpl, &out);
+        Lute::bench::DoNotOptimize(out);
+    }
+    state.setBytesProcessed(state.iterations() *
+                            static_cast<int64_t>(tmpl.size()));
+}
+LUTE_BENCHMARK(BM_ahoCorasick);
+
+static void BM_formatSI(Lute::bench::State& state) {
+    int64_t v = 1;
+    while (state.keepRunning()) {
+        std::string s = Lute::formatSI(v);
+        Lute::bench::DoNotOptimize(s);
+        v = v * 7 % 1000000000000007LL;
+    }
+}
+LUTE_BENCHMARK(BM_formatSI);
+
+static void BM_formatIEC(Lute::bench::State& state) {
+    int64_t v = 1;
+    while (state.keepRunning()) {
+        std::string s = Lute::formatIEC(v);
+        Lute::bench::DoNotOptimize(s);
+        v = v * 7 % 1000000000000007LL;
+    }
+}
+LUTE_BENCHMARK(BM_formatIEC);
+
+static void BM_formatSIBuffer(Lute::bench::State& state) {
+    char buf[Lute::kFormatUnitsSize];
+    int64_t v = 1;
+    while (state.keepRunning()) {
+        size_t len = Lute::formatSI(buf, v);
+        Lute::bench::DoNotOptimize(len);
+        Lute::bench::ClobberMemory();
+        v = v * 7 % 1000000000000007LL;
+    }
+}
+LUTE_BENCHMARK(BM_formatSIBuffer);
+
+static void BM_formatIECBuffer(Lute::bench::State& state) {
+    char buf[Lute::kFormatUnitsSize];
+    int64_t v = 1;
+    while (state.keepRunning()) {
+        size_t len = Lute::formatIEC(buf, v);
+        Lute::bench::DoNotOptimize(len);
+        Lute::bench::ClobberMemory();
+        v = v * 7 % 1000000000000007LL;
+    }
+}
+LUTE_BENCHMARK(BM_formatIECBuffer);
+
+static void BM_parseIEC(Lute::bench::State& state) {
+    static const char* const kInputs[] = {"1072741824", "1.5Gi", "512M",
+                                          "64 KiB"};
+    size_t i = 0;
+    while (state.keepRunning()) {
+        int64_t v = 0;
+        bool ok = Lute::parseIEC(kInputs[i++ & 3], &v);
+        Lute::bench::DoNotOptimize(ok);
+        Lute::bench::DoNotOptimize(v);
+    }
+}
+LUTE_BENCHMARK(BM_parseIEC);
+
+static void BM_integer2Str(Lute::bench::State& state) {
+    char buf[32];
+    int64_t v = 1;
+    while (state.keepRunning()) {
+        size_t len = Lute::integer2Str(buf, v);
+        Lute::bench::DoNotOptimize(len);
+        v = v * 7 % 1000000000000007LL;
+    }
+}
+LUTE_BENCHMARK(BM_integer2Str);
@@ -21,6 +21,7 @@
 
 #include <condition_variable>
 #include <mutex>
+#include <utility>  // forward
 #include <vector>
 
 namespace Lute {
@@ -76,6 +77,18 @@ public:
         cv_.notify_one();
     }
 
+    /// @brief Construct the element in place, e.g. a task from a lambda
+    template <typename... Args>
+    void emplace(Args&&... args) {
+#if __cplusplus >= 201703L
+        std::unique_lock lock(mtx_);
+#else
+        std::unique_lock<std::mutex> lock(mtx_);
+#endif
+        queue_.emplace_back(std::forward<Args>(args)...);
+        cv_.notify_one();
+    }
+
     void pushMany(std::initializer_list<T> vals) {
 #if __cplusplus >= 201703L
         std::unique_lock lock(mtx_);
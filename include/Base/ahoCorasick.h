@@ -0,0 +1,74 @@
+///
+/// @brief Multi-pattern search and replace (Aho-Corasick)
+/// @note Matches are leftmost-longest and don't overlap, like applying the
+///       rules in one left-to-right pass, so a replacement is never
+///       rescanned. The automaton is a dense DFA over the byte classes that
+///       occur in the patterns, each text byte costs one table lookup.
+/// @usage
+///     Lute::AhoCorasick ac({{"${host}", "lute"}, {"${pid}", "42"}});
+///     std::string line = ac.replace("${host}:${pid}");  // "lute:42"
+///
+
+#pragma once
+
+#include <Base/string_view.h>  // string_view
+
+#include <cstdint>  // int32_t uint8_t
+#include <string>   // string
+#include <utility>  // pair
+#include <vector>   // vector
+
+namespace Lute {
+
+class AhoCorasick {
+public:
+    using Rules = std::vector<std::pair<std::string, std::string>>;
+
+    struct Match {
+        size_t start;
+        size_t length;
+        /// index of the pattern in the rules, -1 if nothing matched
+        int index;
+
+        bool found() const { return index >= 0; }
+    };
+
+    ///
+    /// @brief Build the automaton for `rules` (pattern -> replacement).
+    ///        Empty patterns are ignored; for duplicates the first wins.
+    ///
+    explicit AhoCorasick(const Rules& rules);
+
+    /// @brief Leftmost-longest match starting at or after `pos`
+    Match find(const string_view& text, size_t pos = 0) const;
+
+    /// @brief Number of non-overlapping matches
+    size_t count(const string_view& text) const;
+
+    /// @brief Append `text` with every match replaced to `*out`
+    void replace(const string_view& text, std::string* out) const;
+    std::string replace(const string_view& text) const;
+
+    size_t patterns() const { return rules_.size(); }
+    size_t states() const { return depth_.size(); }
+
+private:
+    int32_t step(int32_t state, char c) const {
+        return next_[static_cast<size_t>(state) * classes_ +
+                     classOf_[static_cast<uint8_t>(c)]];
+    }
+
+    Rules rules_;
+    /// byte -> column of next_, 0 for bytes in no pattern
+    uint8_t classOf_[256];
+    size_t classes_;
+    /// states() x classes_ transitions, failure links folded in
+    std::vector<int32_t> next_;
+    std::vector<int32_t> depth_;
+    /// longest pattern that is a suffix of the state, -1 if none
+    std::vector<int32_t> output_;
+    /// the first byte of every pattern if they share it, -1 otherwise
+    int firstByte_;
+};
+
+}  // namespace Lute
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <cstddef>  // size_t max_align_t
+#include <memory>   // allocator allocator_traits
+#include <new>      // placement new
 #include <stdexcept>
 #include <type_traits>
 #include <typeinfo>
@@ -497,4 +500,349 @@ inline ValueType* any_cast(any* operand) noexcept {
         return nullptr;
 }
 #endif
+
+//
+// basic_any<N, Copyable, Alloc>: an any with an N-byte inline buffer, an
+// optional copy (unique_any holds move-only types such as unique_ptr or
+// lambdas capturing them) and a stateless allocator for values that don't
+// fit inline. Lute::any above stays std::any.
+//
+//   Lute::unique_any<64> task = [p = std::move(ptr)] { ... };  // no malloc
+//   auto* f = Lute::any_cast<decltype(lambda)>(&task);
+//
+
+/// Default inline capacity of basic_any / unique_any, 4 pointers
+const std::size_t kAnyInlineCapacity = 4 * sizeof(void*);
+
+namespace detail {
+    /// Deletes the copy operations of basic_any<N, false>
+    template <bool Copyable>
+    struct AnyCopyable {};
+
+    template <>
+    struct AnyCopyable<false> {
+        AnyCopyable() = default;
+        AnyCopyable(const AnyCopyable&) = delete;
+        AnyCopyable(AnyCopyable&&) = default;
+        AnyCopyable& operator=(const AnyCopyable&) = delete;
+        AnyCopyable& operator=(AnyCopyable&&) = default;
+    };
+
+    ///
+    /// @brief Storage and type-erased operations of basic_any, copyable
+    ///        whenever the value is; basic_any deletes the copy when it
+    ///        must not be.
+    ///
+    template <std::size_t N, bool Copyable, typename Alloc>
+    class AnyStorage {
+    public:
+        static_assert(N >= sizeof(void*), "inline capacity below a pointer");
+        static_assert(std::allocator_traits<Alloc>::is_always_equal::value,
+                      "the allocator must be stateless");
+
+        static const std::size_t kCapacity = N;
+        static const std::size_t kAlign = alignof(std::max_align_t);
+
+        /// Stored in the buffer: fits, and can be moved without throwing
+        template <typename T>
+        struct fits_inline
+            : std::integral_constant<
+                  bool, sizeof(T) <= N && alignof(T) <= kAlign &&
+                            std::is_nothrow_move_constructible<T>::value> {};
+
+        AnyStorage() noexcept : vtable_(nullptr) {}
+
+        AnyStorage(const AnyStorage& rhs) : vtable_(nullptr) {
+            if (rhs.vtable_ != nullptr) {
+                rhs.vtable_->copy(rhs.storage_, storage_);
+                vtable_ = rhs.vtable_;
+            }
+        }
+
+        AnyStorage(AnyStorage&& rhs) noexcept : vtable_(rhs.vtable_) {
+            if (vtable_ != nullptr) {
+                vtable_->move(rhs.storage_, storage_);
+                rhs.vtable_ = nullptr;
+            }
+        }
+
+        ~AnyStorage() { reset(); }
+
+        AnyStorage& operator=(const AnyStorage& rhs) {
+            AnyStorage(rhs).swap(*this);
+            return *this;
+        }
+
+        AnyStorage& operator=(AnyStorage&& rhs) noexcept {
+            if (this != &rhs) {
+                reset();
+                if (rhs.vtable_ != nullptr) {
+                    rhs.vtable_->move(rhs.storage_, storage_);
+                    vtable_ = rhs.vtable_;
+                    rhs.vtable_ = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        /// Destroys the contained value, if any
+        void reset() noexcept {
+            if (vtable_ != nullptr) {
+                vtable_->destroy(storage_);
+                vtable_ = nullptr;
+            }
+        }
+
+        bool has_value() const noexcept { return vtable_ != nullptr; }
+
+        /// typeid of the contained value, typeid(void) if empty
+        const std::type_info& type() const noexcept {
+            return vtable_ == nullptr ? typeid(void) : vtable_->type();
+        }
+
+        /// True if the value lives in the inline buffer (no allocation)
+        bool is_inline() const noexcept {
+            return vtable_ != nullptr && vtable_->inlined;
+        }
+
+        void swap(AnyStorage& rhs) noexcept {
+            AnyStorage tmp(std::move(rhs));
+            rhs = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        /// Whether the contained value is a T
+        template <typename T>
+        bool holds() const noexcept {
+            return vtable_ != nullptr &&
+                   (vtable_ == vtable_for<T>() || vtable_->type() == typeid(T));
+        }
+
+        /// The contained value as a T, unchecked
+        template <typename T>
+        T* get() noexcept {
+            return fits_inline<T>::value
+                       ? reinterpret_cast<T*>(storage_.buffer)
+                       : static_cast<T*>(storage_.dynamic);
+        }
+
+        template <typename T>
+        const T* get() const noexcept {
+            return fits_inline<T>::value
+                       ? reinterpret_cast<const T*>(storage_.buffer)
+                       : static_cast<const T*>(storage_.dynamic);
+        }
+
+    protected:
+        /// Constructs a T from args, the storage must be empty
+        template <typename T, typename... Args>
+        T& construct(Args&&... args) {
+            construct_impl<T>(fits_inline<T>(), std::forward<Args>(args)...);
+            vtable_ = vtable_for<T>();
+            return *get<T>();
+        }
+
+    private:
+        union Storage {
+            void* dynamic;
+            alignas(kAlign) unsigned char buffer[N];
+        };
+
+        struct VTable {
+            const std::type_info& (*type)() noexcept;
+            void (*destroy)(Storage&) noexcept;
+            /// nullptr when not Copyable
+            void (*copy)(const Storage& src, Storage& dst);
+            /// Relocates src into the uninitialized dst
+            void (*move)(Storage& src, Storage& dst) noexcept;
+            bool inlined;
+        };
+
+        template <typename T>
+        using TAlloc =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+        template <typename T>
+        using TTraits = std::allocator_traits<TAlloc<T> >;
+
+        template <typename T, typename... Args>
+        static T* allocate(Args&&... args) {
+            TAlloc<T> alloc;
+            T* p = TTraits<T>::allocate(alloc, 1);
+            try {
+                TTraits<T>::construct(alloc, p, std::forward<Args>(args)...);
+            } catch (...) {
+                TTraits<T>::deallocate(alloc, p, 1);
+                throw;
+            }
+            return p;
+        }
+
+        template <typename T>
+        static void deallocate(T* p) noexcept {
+            TAlloc<T> alloc;
+            TTraits<T>::destroy(alloc, p);
+            TTraits<T>::deallocate(alloc, p, 1);
+        }
+
+        template <typename T, typename... Args>
+        void construct_impl(std::true_type, Args&&... args) {
+            new (storage_.buffer) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T, typename... Args>
+        void construct_impl(std::false_type, Args&&... args) {
+            storage_.dynamic = allocate<T>(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        struct InlineOps {
+            static T* ptr(Storage& s) noexcept {
+                return reinterpret_cast<T*>(s.buffer);
+            }
+            static void destroy(Storage& s) noexcept { ptr(s)->~T(); }
+            static void copy(const Storage& src, Storage& dst) {
+                new (dst.buffer) T(*reinterpret_cast<const T*>(src.buffer));
+            }
+            static void move(Storage& src, Storage& dst) noexcept {
+                new (dst.buffer) T(std::move(*ptr(src)));
+                destroy(src);
+            }
+        };
+
+        template <typename T>
+        struct DynamicOps {
+            static void destroy(Storage& s) noexcept {
+                deallocate(static_cast<T*>(s.dynamic));
+            }
+            static void copy(const Storage& src, Storage& dst) {
+                dst.dynamic = allocate<T>(*static_cast<const T*>(src.dynamic));
+            }
+            static void move(Storage& src, Storage& dst) noexcept {
+                dst.dynamic = src.dynamic;
+                src.dynamic = nullptr;
+            }
+        };
+
+        template <typename T>
+        static const std::type_info& type_of() noexcept {
+            return typeid(T);
+        }
+
+        template <typename Ops>
+        static constexpr void (*copy_of(std::true_type))(const Storage&, Storage&) {
+            return Ops::copy;
+        }
+
+        template <typename Ops>
+        static constexpr void (*copy_of(std::false_type))(const Storage&, Storage&) {
+            return nullptr;
+        }
+
+        template <typename T>
+        static const VTable* vtable_for() noexcept {
+            using Ops = typename std::conditional<fits_inline<T>::value,
+                                                  InlineOps<T>,
+                                                  DynamicOps<T> >::type;
+            static const VTable table = {
+                type_of<T>, Ops::destroy,
+                copy_of<Ops>(std::integral_constant<bool, Copyable>()),
+                Ops::move, fits_inline<T>::value};
+            return &table;
+        }
+
+        Storage storage_;
+        const VTable* vtable_;
+    };
+}  // namespace detail
+
+template <std::size_t N = kAnyInlineCapacity, bool Copyable = true,
+          typename Alloc = std::allocator<char> >
+class basic_any : public detail::AnyStorage<N, Copyable, Alloc>,
+                  private detail::AnyCopyable<Copyable> {
+    using Base = detail::AnyStorage<N, Copyable, Alloc>;
+
+    template <typename ValueType>
+    using enable_if_value = typename std::enable_if<!std::is_same<
+        typename std::decay<ValueType>::type, basic_any>::value>::type;
+
+public:
+    basic_any() = default;
+    basic_any(const basic_any&) = default;
+    basic_any(basic_any&&) = default;
+    basic_any& operator=(const basic_any&) = default;
+    basic_any& operator=(basic_any&&) = default;
+
+    /// Holds decay_t<ValueType> constructed from value
+    template <typename ValueType, typename = enable_if_value<ValueType> >
+    basic_any(ValueType&& value) {
+        using T = typename std::decay<ValueType>::type;
+        static_assert(!Copyable || std::is_copy_constructible<T>::value,
+                      "use unique_any for move-only types");
+        this->template construct<T>(std::forward<ValueType>(value));
+    }
+
+    template <typename ValueType, typename = enable_if_value<ValueType> >
+    basic_any& operator=(ValueType&& value) {
+        basic_any(std::forward<ValueType>(value)).swap(*this);
+        return *this;
+    }
+
+    /// Replaces the contained value with a T constructed in place
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        static_assert(!Copyable || std::is_copy_constructible<T>::value,
+                      "use unique_any for move-only types");
+        this->reset();
+        return this->template construct<T>(std::forward<Args>(args)...);
+    }
+
+    void swap(basic_any& rhs) noexcept { Base::swap(rhs); }
+};
+
+/// basic_any holding move-only types
+template <std::size_t N = kAnyInlineCapacity,
+          typename Alloc = std::allocator<char> >
+using unique_any = basic_any<N, false, Alloc>;
+
+/// The contained T, or nullptr if operand doesn't hold a T
+template <typename ValueType, std::size_t N, bool C, typename A>
+inline const ValueType* any_cast(const basic_any<N, C, A>* operand) noexcept {
+    using T = typename std::decay<ValueType>::type;
+    return operand && operand->template holds<T>()
+               ? operand->template get<T>()
+               : nullptr;
+}
+
+template <typename ValueType, std::size_t N, bool C, typename A>
+inline ValueType* any_cast(basic_any<N, C, A>* operand) noexcept {
+    using T = typename std::decay<ValueType>::type;
+    return operand && operand->template holds<T>()
+               ? operand->template get<T>()
+               : nullptr;
+}
+
+/// The contained value, throws bad_any_cast if it isn't a ValueType
+template <typename ValueType, std::size_t N, bool C, typename A>
+inline ValueType any_cast(const basic_any<N, C, A>& operand) {
+    using T = typename std::remove_reference<ValueType>::type;
+    auto p = any_cast<const T>(&operand);
+    if (p == nullptr) throw bad_any_cast();
+    return *p;
+}
+
+template <typename ValueType, std::size_t N, bool C, typename A>
+inline ValueType any_cast(basic_any<N, C, A>& operand) {
+    using T = typename std::remove_reference<ValueType>::type;
+    auto p = any_cast<T>(&operand);
+    if (p == nullptr) throw bad_any_cast();
+    return *p;
+}
+
+template <typename ValueType, std::size_t N, bool C, typename A>
+inline ValueType any_cast(basic_any<N, C, A>&& operand) {
+    using T = typename std::remove_reference<ValueType>::type;
+    auto p = any_cast<T>(&operand);
+    if (p == nullptr) throw bad_any_cast();
+    return std::forward<ValueType>(*p);
+}
 }  // namespace Lute
@@ -0,0 +1,208 @@
+///
+/// @brief Allocators for hot, short-lived objects
+///   - Arena: bump allocator, everything is released at once by `reset()`.
+///     For request-scoped data; destructors are NOT run.
+///   - ThreadCachePool: process-wide size-class pool with a per-thread cache
+///     of free objects, so the common allocate / deallocate never locks.
+///   - ArenaResource / PoolResource: std::pmr::memory_resource adapters,
+///     PoolAllocator<T>: STL allocator over the pool.
+/// @usage
+///     Lute::Arena arena;
+///     Lute::ArenaResource resource(&arena);
+///     std::pmr::vector<int> v(&resource);
+///     ...
+///     arena.reset();  // v must be gone by now
+///
+///     std::list<Task, Lute::PoolAllocator<Task>> tasks;
+///
+
+#pragma once
+
+#include <cstddef>          // size_t, max_align_t
+#include <cstdint>          // uintptr_t
+#include <memory_resource>  // memory_resource
+#include <new>              // bad_alloc
+#include <utility>          // forward
+#include <vector>           // vector
+
+namespace Lute {
+
+///
+/// @brief Bump allocator. Memory comes from blocks of `blockSize` bytes,
+///        `reset()` rewinds to the first block and keeps the blocks for reuse,
+///        requests larger than a quarter block get a block of their own that
+///        `reset()` frees.
+/// @note Not thread safe
+///
+class Arena {
+public:
+    /// non-copyable
+    Arena(const Arena&) = delete;
+    Arena& operator=(Arena&) = delete;
+
+    explicit Arena(size_t blockSize = 4096);
+    ~Arena() { release(); }
+
+    ///
+    /// @brief `size` bytes aligned to `align` (a power of 2)
+    /// @throw std::bad_alloc
+    ///
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        const uintptr_t p = (reinterpret_cast<uintptr_t>(ptr_) + align - 1) &
+                            ~static_cast<uintptr_t>(align - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(end_);
+        if (__builtin_expect(p + size <= end, 1)) {
+            ptr_ = reinterpret_cast<char*>(p + size);
+            allocated_ += size;
+            return reinterpret_cast<void*>(p);
+        }
+        return allocateSlow(size, align);
+    }
+
+    /// @brief Construct a T in the arena, its destructor is never called
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    /// @brief Uninitialized array of `n` T
+    template <typename T>
+    T* allocateArray(size_t n) {
+        return static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    /// @brief Invalidate every allocation, keep the blocks for reuse
+    void reset();
+    /// @brief Invalidate every allocation and free all memory
+    void release();
+
+    /// @brief Bytes handed out since the last reset
+    size_t allocatedBytes() const { return allocated_; }
+    /// @brief Bytes held by the arena
+    size_t reservedBytes() const { return reserved_; }
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void* allocateSlow(size_t size, size_t align);
+    void setBlock(const Block& block) {
+        ptr_ = block.data;
+        end_ = block.data + block.size;
+    }
+
+    const size_t blockSize_;
+    char* ptr_;
+    char* end_;
+    /// index of the block `ptr_` points into
+    size_t current_;
+    size_t allocated_;
+    size_t reserved_;
+    std::vector<Block> blocks_;
+    /// oversized allocations, freed by reset()
+    std::vector<Block> large_;
+};
+
+///
+/// @brief Process-wide pool of fixed size classes (16 bytes .. kMaxSize).
+///        Each thread keeps a few free objects per class, batches move
+///        between the thread caches and a central free list under a mutex.
+///        Larger requests go to ::operator new.
+/// @note Memory is never returned to the system, freed objects are reused
+///       for the same size class. An object may be freed by any thread, the
+///       size passed to deallocate() must be the one given to allocate().
+///
+class ThreadCachePool {
+public:
+    static const size_t kMaxSize = 32 * 1024;
+    static const size_t kAlignment = 16;
+
+    static void* allocate(size_t size);
+    static void deallocate(void* p, size_t size);
+
+    /// @brief Size actually reserved for a request of `size` bytes
+    static size_t roundUp(size_t size);
+
+    /// @brief Move the calling thread's cached objects to the central lists,
+    ///        done automatically when a thread exits
+    static void flushThreadCache();
+
+    /// @brief Bytes obtained from the system for the size classes
+    static size_t reservedBytes();
+};
+
+///
+/// @brief std::pmr adapter over an Arena, deallocate is a no-op
+///
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(Arena* arena) : arena_(arena) {}
+
+    Arena* arena() const { return arena_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override {
+        return arena_->allocate(bytes, align);
+    }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    Arena* arena_;
+};
+
+///
+/// @brief std::pmr adapter over the ThreadCachePool
+///
+class PoolResource : public std::pmr::memory_resource {
+public:
+    /// @brief Shared instance, the pool itself has no per-resource state
+    static PoolResource* instance();
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void* p, size_t bytes, size_t align) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return dynamic_cast<const PoolResource*>(&other) != nullptr;
+    }
+};
+
+///
+/// @brief STL allocator over the ThreadCachePool
+///
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    static_assert(alignof(T) <= ThreadCachePool::kAlignment,
+                  "over-aligned types are not supported");
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > static_cast<size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+        return static_cast<T*>(ThreadCachePool::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        ThreadCachePool::deallocate(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
+    return false;
+}
+
+}  // namespace Lute
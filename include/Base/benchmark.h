@@ -0,0 +1,145 @@
+///
+/// @brief Microbenchmark harness, the nanosecond-scale successor of PING/PONG
+/// @note Each benchmark is warmed up, its iteration count is scaled until a
+///       sample lasts `--min_time` seconds, then `--samples` samples are
+///       taken. Reports mean / stddev / percentiles of ns per iteration and,
+///       when perf_event_open is permitted, cycles, instructions and cache
+///       misses per iteration. `--json=FILE` writes the results for
+///       regression tracking, `--filter=SUBSTR` selects benchmarks.
+/// @usage
+///     void BM_toUpper(Lute::bench::State& state) {
+///         std::string s = "abcDefGH";
+///         while (state.keepRunning()) {
+///             Lute::toUpper(s);
+///             Lute::bench::DoNotOptimize(s);
+///         }
+///     }
+///     LUTE_BENCHMARK(BM_toUpper);
+///     LUTE_BENCHMARK_MAIN();
+///
+
+#pragma once
+
+#include <cstdint>     // int64_t
+#include <functional>  // function
+#include <string>      // string
+
+namespace Lute {
+namespace bench {
+
+    ///
+    /// @brief Prevent the compiler from optimizing `value` away, or from
+    ///        assuming anything about its contents.
+    ///
+    template <typename T>
+    inline void DoNotOptimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    template <typename T>
+    inline void DoNotOptimize(T& value) {
+#if defined(__clang__)
+        asm volatile("" : "+r,m"(value) : : "memory");
+#else
+        asm volatile("" : "+m,r"(value) : : "memory");
+#endif
+    }
+
+    /// @brief Force all pending writes to memory
+    inline void ClobberMemory() { asm volatile("" : : : "memory"); }
+
+    class PerfCounters;
+
+    ///
+    /// @brief Handed to each benchmark run; drives the timed loop
+    ///
+    class State {
+    public:
+        /// non-copyable
+        State(const State&) = delete;
+        State& operator=(State&) = delete;
+
+        State(int64_t iterations, int64_t arg, PerfCounters* counters);
+
+        ///
+        /// @brief `while (state.keepRunning()) { ... }`. The clock starts on
+        ///        the first call and stops on the last one, so setup before
+        ///        the loop isn't measured.
+        ///
+        bool keepRunning() {
+            if (__builtin_expect(remaining_ > 0, 1)) {
+                --remaining_;
+                return true;
+            }
+            return startOrStop();
+        }
+
+        /// @brief Exclude a section of the loop body from the measurement
+        void pauseTiming();
+        void resumeTiming();
+
+        int64_t iterations() const { return iterations_; }
+        /// @brief Argument given by LUTE_BENCHMARK_ARG, 0 otherwise
+        int64_t arg() const { return arg_; }
+
+        /// @brief Report throughput as bytes per second
+        void setBytesProcessed(int64_t bytes) { bytes_ = bytes; }
+
+        // for internal usage
+        int64_t elapsedNanos() const { return elapsedNanos_; }
+        int64_t bytesProcessed() const { return bytes_; }
+        const uint64_t* counterValues() const { return counterValues_; }
+
+        static const int kMaxCounters = 3;
+
+    private:
+        bool startOrStop();
+
+        const int64_t iterations_;
+        const int64_t arg_;
+        int64_t remaining_;
+        bool started_;
+        bool finished_;
+        int64_t startNanos_;
+        int64_t elapsedNanos_;
+        int64_t bytes_;
+        PerfCounters* counters_;
+        uint64_t counterValues_[kMaxCounters];
+    };
+
+    using Function = std::function<void(State&)>;
+
+    /// @brief Register a benchmark; returns a dummy for static initializers
+    int registerBenchmark(const std::string& name, Function func,
+                          int64_t arg = 0);
+
+    ///
+    /// @brief Run registered benchmarks
+    ///   --filter=SUBSTR  only names containing SUBSTR
+    ///   --min_time=SEC   duration of one sample (default 0.01)
+    ///   --samples=N      samples per benchmark (default 20)
+    ///   --json=FILE      also write results as JSON ("-" for stdout)
+    ///   --no_perf        don't read hardware counters
+    /// @return 0 on success
+    ///
+    int runBenchmarks(int argc, char** argv);
+
+}  // namespace bench
+}  // namespace Lute
+
+#define LUTE_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define LUTE_BENCHMARK_CONCAT(a, b) LUTE_BENCHMARK_CONCAT_IMPL(a, b)
+
+#define LUTE_BENCHMARK(func)                                              \
+    static int LUTE_BENCHMARK_CONCAT(luteBenchmark_, __LINE__)            \
+        __attribute__((unused)) = Lute::bench::registerBenchmark(#func, func)
+
+#define LUTE_BENCHMARK_ARG(func, arg)                                     \
+    static int LUTE_BENCHMARK_CONCAT(luteBenchmark_, __LINE__)            \
+        __attribute__((unused)) = Lute::bench::registerBenchmark(         \
+            #func "/" #arg, func, arg)
+
+#define LUTE_BENCHMARK_MAIN()                          \
+    int main(int argc, char** argv) {                  \
+        return Lute::bench::runBenchmarks(argc, argv); \
+    }
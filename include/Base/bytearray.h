@@ -34,9 +34,10 @@
 #include <Base/string_view.h>  // string_view
 #include <sys/socket.h>        // iovec
 
-#include <cstdint>  // int32_t, int64_t, uint32_t, uint64_t
-#include <memory>   // shared_ptr
-#include <vector>   // vector
+#include <cstdint>          // int32_t, int64_t, uint32_t, uint64_t
+#include <memory>           // shared_ptr
+#include <memory_resource>  // memory_resource
+#include <vector>           // vector
 
 namespace Lute {
 ///
@@ -53,7 +54,7 @@ public:
         /// @brief 默认构造函数
         Node();
         /// @brief 构造函数 - 构造指定大小为 s 字节的内存块
-        explicit Node(size_t size = 4096);
+        explicit Node(size_t size);
         /// @brief 析构函数 - 释放内存
         ~Node();
 
@@ -68,8 +69,11 @@ public:
     ///
     /// @brief 使用指定长度的内存块构造 ByteArray
     /// @param[in] base_size 内存块大小
+    /// @param[in] resource 内存块的来源，默认 std::pmr::get_default_resource()，
+    ///            例如 Lute::PoolResource::instance() 或 Lute::ArenaResource
     ///
-    explicit ByteArray(size_t base_size = 4096);
+    explicit ByteArray(size_t base_size = 4096,
+                       std::pmr::memory_resource* resource = nullptr);
     ~ByteArray();
 
     ///
@@ -413,6 +417,11 @@ private:
     /// @brief 当前剩余可写容量
     ///
     size_t writableCapacity() const { return capacity_ - position_; }
+    ///
+    /// @brief 从 resource_ 分配节点，节点头与内存块在同一次分配中
+    ///
+    Node* newNode();
+    void deleteNode(Node* node);
 
     /// 内存块大小
     size_t baseSize_;
@@ -428,5 +437,7 @@ private:
     Node* root_;
     /// 当前操作的内存块指针
     Node* curr_;
+    /// 内存块的来源
+    std::pmr::memory_resource* resource_;
 };
 }  // namespace Lute
\ No newline at end of file
@@ -0,0 +1,282 @@
+///
+/// @brief Hash map for shared lookup tables, read-mostly
+/// @note Chained buckets. Readers take no lock: find() walks the chain
+///       under an Epoch::Guard, which only writes the reader's own cache
+///       line, so lookups from many threads don't contend. Writers lock one
+///       of kStripes mutexes picked by the hash, never modify a published
+///       node and replace it instead; unlinked nodes go to Epoch::retire().
+///       The table doubles when a stripe averages more than one entry per
+///       bucket: growing locks every stripe and copies the nodes into a new
+///       table, readers keep using the old one until they look again.
+///       Key and Value must be copy constructible.
+/// @usage
+///     Lute::ConcurrentHashMap<std::string, int> ports;
+///     ports.insertOrAssign("http", 80);
+///     int port;
+///     if (ports.find("http", &port)) ...
+///
+
+#pragma once
+
+#include <Base/epoch.h>   // Epoch
+#include <Base/mutex.h>   // MutexLock
+#include <Base/perCpu.h>  // kCacheLineSize
+
+#include <atomic>      // atomic
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <functional>  // hash equal_to
+#include <utility>     // pair
+#include <vector>      // vector
+
+namespace Lute {
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class ConcurrentHashMap {
+public:
+    /// writer locks, a power of 2
+    static const size_t kStripes = 64;
+
+    /// non-copyable
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    /// @brief `buckets` is rounded up to a power of 2, at least kStripes
+    explicit ConcurrentHashMap(size_t buckets = kStripes)
+        : table_(new Table(roundUp(buckets))) {}
+
+    /// @brief No other thread may use the map any more
+    ~ConcurrentHashMap() { delete table_.load(); }
+
+    ///
+    /// @brief Copy the value of `key` into `*value`
+    /// @return false if there is no such key
+    ///
+    bool find(const Key& key, Value* value) const {
+        const size_t h = hashOf(key);
+        Epoch::Guard guard;
+        const Node* n = lookup(key, h);
+        if (n == nullptr) return false;
+        *value = n->value;
+        return true;
+    }
+
+    bool contains(const Key& key) const {
+        const size_t h = hashOf(key);
+        Epoch::Guard guard;
+        return lookup(key, h) != nullptr;
+    }
+
+    ///
+    /// @brief Insert `key`, or replace its value
+    /// @return true if the key was inserted
+    ///
+    bool insertOrAssign(const Key& key, const Value& value) {
+        const size_t h = hashOf(key);
+        Stripe& stripe = stripes_[h & (kStripes - 1)];
+        Node* fresh = new Node(key, value, h);
+        Node* old = nullptr;
+        Table* grown = nullptr;
+        {
+            MutexLockGuard lock(stripe.mutex);
+            /// stable while the stripe is locked, see grow()
+            Table* table = table_.load(std::memory_order_relaxed);
+            std::atomic<Node*>* link = findLink(table, key, h);
+            old = link->load(std::memory_order_relaxed);
+            if (old != nullptr) {
+                fresh->next.store(old->next.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+            } else {
+                const size_t count =
+                    stripe.count.load(std::memory_order_relaxed) + 1;
+                stripe.count.store(count, std::memory_order_relaxed);
+                if (count > (table->mask + 1) / kStripes) grown = table;
+            }
+            link->store(fresh, std::memory_order_release);
+        }
+        if (old != nullptr) Epoch::retire(old);
+        if (grown != nullptr) grow(grown);
+        return old == nullptr;
+    }
+
+    ///
+    /// @brief Remove `key`
+    /// @return false if there was no such key
+    ///
+    bool erase(const Key& key) {
+        const size_t h = hashOf(key);
+        Stripe& stripe = stripes_[h & (kStripes - 1)];
+        Node* old = nullptr;
+        {
+            MutexLockGuard lock(stripe.mutex);
+            std::atomic<Node*>* link =
+                findLink(table_.load(std::memory_order_relaxed), key, h);
+            old = link->load(std::memory_order_relaxed);
+            if (old == nullptr) return false;
+            link->store(old->next.load(std::memory_order_relaxed),
+                        std::memory_order_release);
+            stripe.count.store(
+                stripe.count.load(std::memory_order_relaxed) - 1,
+                std::memory_order_relaxed);
+        }
+        Epoch::retire(old);
+        return true;
+    }
+
+    ///
+    /// @brief Call `f(key, value)` for every entry, without locking.
+    ///        Every entry present for the whole call is visited once,
+    ///        entries inserted or erased meanwhile may be missed.
+    ///
+    template <typename F>
+    void forEach(F&& f) const {
+        Epoch::Guard guard;
+        const Table* table = table_.load(std::memory_order_acquire);
+        for (size_t b = 0; b <= table->mask; ++b) {
+            for (const Node* n =
+                     table->buckets[b].load(std::memory_order_acquire);
+                 n != nullptr; n = n->next.load(std::memory_order_acquire))
+                f(n->key, n->value);
+        }
+    }
+
+    /// @brief The entries as forEach() sees them
+    std::vector<std::pair<Key, Value>> snapshot() const {
+        std::vector<std::pair<Key, Value>> entries;
+        entries.reserve(size());
+        forEach([&entries](const Key& key, const Value& value) {
+            entries.emplace_back(key, value);
+        });
+        return entries;
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Stripe& stripe : stripes_)
+            total += stripe.count.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t bucketCount() const {
+        return table_.load(std::memory_order_acquire)->mask + 1;
+    }
+
+private:
+    struct Node {
+        Node(const Key& k, const Value& v, size_t h)
+            : key(k), value(v), hash(h), next(nullptr) {}
+        const Key key;
+        const Value value;
+        const size_t hash;
+        std::atomic<Node*> next;
+    };
+
+    struct Table {
+        explicit Table(size_t buckets)
+            : mask(buckets - 1), buckets(new std::atomic<Node*>[buckets]) {
+            for (size_t b = 0; b < buckets; ++b)
+                this->buckets[b].store(nullptr, std::memory_order_relaxed);
+        }
+        /// also frees the nodes still linked
+        ~Table() {
+            for (size_t b = 0; b <= mask; ++b) {
+                Node* n = buckets[b].load(std::memory_order_relaxed);
+                while (n != nullptr) {
+                    Node* next = n->next.load(std::memory_order_relaxed);
+                    delete n;
+                    n = next;
+                }
+            }
+            delete[] buckets;
+        }
+        const size_t mask;
+        std::atomic<Node*>* const buckets;
+    };
+
+    struct alignas(detail::kCacheLineSize) Stripe {
+        MutexLock mutex;
+        /// written under the mutex, read by size() without it
+        std::atomic<size_t> count{0};
+    };
+
+    static size_t roundUp(size_t buckets) {
+        size_t n = kStripes;
+        while (n < buckets) n <<= 1;
+        return n;
+    }
+
+    /// std::hash of an integer is the identity, spread it over the bits
+    /// used for the stripe and the bucket
+    size_t hashOf(const Key& key) const {
+        uint64_t h = static_cast<uint64_t>(hash_(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    /// @brief Under an Epoch::Guard
+    const Node* lookup(const Key& key, size_t h) const {
+        const Table* table = table_.load(std::memory_order_acquire);
+        const std::atomic<Node*>& head = table->buckets[h & table->mask];
+        for (const Node* n = head.load(std::memory_order_acquire);
+             n != nullptr; n = n->next.load(std::memory_order_acquire)) {
+            if (n->hash == h && equal_(n->key, key)) return n;
+        }
+        return nullptr;
+    }
+
+    ///
+    /// @brief Under the stripe lock of `h`
+    /// @return the link holding the node of `key`, or the null link at the
+    ///         end of its chain
+    ///
+    std::atomic<Node*>* findLink(Table* table, const Key& key, size_t h) {
+        std::atomic<Node*>* link = &table->buckets[h & table->mask];
+        for (Node* n = link->load(std::memory_order_relaxed); n != nullptr;
+             n = link->load(std::memory_order_relaxed)) {
+            if (n->hash == h && equal_(n->key, key)) break;
+            link = &n->next;
+        }
+        return link;
+    }
+
+    /// @brief Double `table` unless another writer already replaced it
+    void grow(Table* table) NO_THREAD_SAFETY_ANALYSIS {
+        for (Stripe& stripe : stripes_) stripe.mutex.lock();
+        const bool current = table_.load(std::memory_order_relaxed) == table;
+        if (current) {
+            /// the stripe of a hash doesn't change: its low bits pick both
+            Table* bigger = new Table((table->mask + 1) * 2);
+            for (size_t b = 0; b <= table->mask; ++b) {
+                Node* n = table->buckets[b].load(std::memory_order_relaxed);
+                for (; n != nullptr;
+                     n = n->next.load(std::memory_order_relaxed)) {
+                    Node* copy = new Node(n->key, n->value, n->hash);
+                    std::atomic<Node*>& head =
+                        bigger->buckets[n->hash & bigger->mask];
+                    copy->next.store(head.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+                    head.store(copy, std::memory_order_relaxed);
+                }
+            }
+            table_.store(bigger, std::memory_order_release);
+        }
+        for (Stripe& stripe : stripes_) stripe.mutex.unlock();
+        /// readers may still walk the old chains
+        if (current) Epoch::retire(table);
+    }
+
+    /// read by every lookup, kept off the stripes' lines
+    alignas(detail::kCacheLineSize) std::atomic<Table*> table_;
+    Hash hash_;
+    KeyEqual equal_;
+    Stripe stripes_[kStripes];
+};
+
+}  // namespace Lute
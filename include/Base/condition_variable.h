@@ -32,10 +32,14 @@ public:
     Condition(const Condition&) = delete;
     Condition& operator=(Condition&) = delete;
 
-    /// @brief 对动态分配的条件变量进行初始化，使用默认属性
+    /// @brief 对动态分配的条件变量进行初始化，超时等待使用 CLOCK_MONOTONIC
     /// @param mutex
     explicit Condition(MutexLock& mutex) : mutex_(mutex) {
-        MCHECK(pthread_cond_init(&pcond_, nullptr));
+        pthread_condattr_t attr;
+        MCHECK(pthread_condattr_init(&attr));
+        MCHECK(pthread_condattr_setclock(&attr, CLOCK_MONOTONIC));
+        MCHECK(pthread_cond_init(&pcond_, &attr));
+        MCHECK(pthread_condattr_destroy(&attr));
     }
 
     /// 对条件变量进行反初始化
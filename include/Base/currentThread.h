@@ -1,38 +1,94 @@
 /**
  * @brief The useful information of Current thread.
- * t_cacheTid - current thread ID
- * t_tidString
- * t_tidStringLength
- * t_threadName - current thread name
+ * t_context - everything below in one TLS block
+ *   tid - current thread ID
+ *   tidString
+ *   tidStringLength
+ *   name - current thread name
+ *   index - small dense index, see ThreadRegistry
  */
 
 #pragma once
 
+#include <sched.h>  // sched_getcpu
+
 #include <string>
+#include <vector>
+
+#if defined(__GLIBC__) && defined(__has_include)
+#if __has_include(<sys/rseq.h>) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+#include <sys/rseq.h>  // __rseq_offset __rseq_size
+#define LUTE_HAVE_RSEQ 1
+#endif
+#endif
 
 namespace Lute {
 namespace CurrentThread {
+    ///
+    /// @brief Per-thread state, one cache line
+    ///
+    struct Context {
+        /// cached gettid(), 0 until the first tid()
+        int tid;
+        /// dense index, -1 until the thread is registered
+        int index;
+        int tidStringLength;
+        const char* name;
+        char tidString[32];
+    };
+
     // internal
-    extern __thread int t_cachedTid;
-    extern __thread char t_tidString[32];
-    extern __thread int t_tidStringLength;
-    extern __thread const char* t_threadName;
+    /// initial-exec: one %fs-relative load, no __tls_get_addr call
+    extern __thread Context t_context __attribute__((tls_model("initial-exec")));
 
     // impl in Thread.cc
     void cacheTid();
+    // impl in currentThread.cc
+    int registerThread();
 
     inline int tid() {
         // t_cacheTid == 0 is likely to be false
-        if (__builtin_expect(t_cachedTid == 0, 0)) cacheTid();
-        return t_cachedTid;
+        if (__builtin_expect(t_context.tid == 0, 0)) cacheTid();
+        return t_context.tid;
     }
 
     // for logging
-    inline const char* tidString() { return t_tidString; }
+    inline const char* tidString() { return t_context.tidString; }
     // for logging
-    inline int tidStringLength() { return t_tidStringLength; }
+    inline int tidStringLength() { return t_context.tidStringLength; }
+
+    inline const char* name() { return t_context.name; }
+
+    /// @brief `name` must outlive the thread or the next setName()
+    void setName(const char* name);
+
+    ///
+    /// @brief Small integer unique among live threads, reused after a thread
+    ///        exits, so per-thread slots can be an array indexed by it.
+    ///        The thread registers itself on the first call.
+    ///
+    inline int index() {
+        if (__builtin_expect(t_context.index < 0, 0)) return registerThread();
+        return t_context.index;
+    }
 
-    inline const char* name() { return t_threadName; }
+    ///
+    /// @brief CPU the thread is running on, possibly stale by the time it is
+    ///        used. Read from the rseq area glibc registers, sched_getcpu()
+    ///        where that isn't available.
+    ///
+    inline int cpu() {
+#ifdef LUTE_HAVE_RSEQ
+        if (__builtin_expect(__rseq_size != 0, 1)) {
+            const auto* rs = reinterpret_cast<const volatile struct rseq*>(
+                static_cast<char*>(__builtin_thread_pointer()) + __rseq_offset);
+            const int cpu = static_cast<int>(rs->cpu_id);
+            if (__builtin_expect(cpu >= 0, 1)) return cpu;
+        }
+#endif
+        return ::sched_getcpu();
+    }
 
     // impl in Thread.cc
     bool isMainThread();
@@ -48,4 +104,31 @@ namespace CurrentThread {
      */
     std::string stackTrace(bool demangle = false);
 }  // namespace CurrentThread
-}  // namespace Lute
\ No newline at end of file
+
+///
+/// @brief Threads registered through CurrentThread::index(). Lute::Thread
+///        registers its threads before running the thread function, other
+///        threads on their first index(). A thread leaves the registry when
+///        it exits and its index becomes free for the next one.
+///
+class ThreadRegistry {
+public:
+    struct Info {
+        int tid;
+        int index;
+        std::string name;
+    };
+
+    /// @brief The live registered threads, ordered by index
+    static std::vector<Info> snapshot();
+
+    /// @brief Number of live registered threads
+    static int size();
+
+    ///
+    /// @brief One past the largest index handed out so far, the size an
+    ///        array indexed by CurrentThread::index() needs
+    ///
+    static int indexLimit();
+};
+}  // namespace Lute
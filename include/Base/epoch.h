@@ -0,0 +1,115 @@
+///
+/// @brief Epoch-based reclamation for lock-free readers
+/// @note A reader pins the current epoch with an Epoch::Guard while it
+///       follows shared pointers; pinning only writes the thread's own
+///       cache line. A writer unlinks an object and hands it to retire(),
+///       it is freed once the global epoch has moved two steps past the
+///       retire, when no guard can still see it. The epoch only moves when
+///       every pinned thread has caught up with it, writers try that every
+///       kReclaimBatch retires.
+/// @usage
+///     {
+///         Lute::Epoch::Guard guard;
+///         Node* n = head.load(std::memory_order_acquire);
+///         ... n stays valid until the guard ends
+///     }
+///     Node* old = head.exchange(fresh);
+///     Lute::Epoch::retire(old);
+///
+
+#pragma once
+
+#include <atomic>   // atomic
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <vector>   // vector
+
+namespace Lute {
+namespace detail {
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    struct EpochRecord {
+        /// `epoch << 1 | 1` while pinned, 0 otherwise
+        std::atomic<uint64_t> state{0};
+        int depth = 0;
+        /// ordered by epoch, only the owning thread touches it
+        std::vector<Retired> limbo;
+    };
+
+    extern std::atomic<uint64_t> g_epoch;
+    /// initial-exec: one %fs-relative load, no __tls_get_addr call
+    extern __thread EpochRecord* t_epochRecord
+        __attribute__((tls_model("initial-exec")));
+    EpochRecord* registerEpochRecord();
+}  // namespace detail
+
+class Epoch {
+public:
+    /// retires between two attempts to advance the epoch
+    static const size_t kReclaimBatch = 64;
+
+    ///
+    /// @brief Pins the epoch for the enclosing scope, may be nested
+    ///
+    class Guard {
+    public:
+        /// non-copyable
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard() { enter(); }
+        ~Guard() { leave(); }
+    };
+
+    static void enter() {
+        detail::EpochRecord* r = detail::t_epochRecord;
+        if (__builtin_expect(r == nullptr, 0))
+            r = detail::registerEpochRecord();
+        if (r->depth++ == 0) {
+            r->state.store(detail::g_epoch.load() << 1 | 1,
+                           std::memory_order_relaxed);
+            /// the loads under the guard must not pass the announcement
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void leave() {
+        detail::EpochRecord* r = detail::t_epochRecord;
+        if (--r->depth == 0) r->state.store(0, std::memory_order_release);
+    }
+
+    ///
+    /// @brief Free `object` with `deleter` once no guard can reach it.
+    ///        The caller has already unlinked it from the shared structure.
+    ///
+    static void retire(void* object, void (*deleter)(void*));
+
+    template <typename T>
+    static void retire(T* object) {
+        retire(object, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    ///
+    /// @brief Try to advance the epoch and free what the calling thread
+    ///        retired and no guard can reach any more
+    /// @return number of objects freed
+    ///
+    static size_t reclaim();
+
+    ///
+    /// @brief Wait until everything the calling thread retired is freed.
+    ///        Must not be called under a Guard.
+    ///
+    static void synchronize();
+
+    /// @brief Objects retired by the calling thread and not yet freed
+    static size_t pending();
+
+    static uint64_t current() { return detail::g_epoch.load(); }
+};
+
+}  // namespace Lute
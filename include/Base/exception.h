@@ -32,17 +32,18 @@
 
 #pragma once
 
-#include <Base/currentThread.h>
+#include <Base/stackTrace.h>
 
 #include <exception>  // exception
 #include <string>
 
 namespace Lute {
 /// @brief 继承于 std::exception
+/// @note 抛出时只记录返回地址，stackTrace() 第一次调用时才做符号解析
 class Exception : public std::exception {
 public:
     explicit Exception(std::string what)
-        : message_(std::move(what)), stack_(CurrentThread::stackTrace(false)) {}
+        : message_(std::move(what)), trace_(StackTrace::capture()) {}
     ~Exception() noexcept override = default;
 
     // default copy-ctor and operator= are okay.
@@ -50,10 +51,25 @@ public:
     Exception& operator=(const Exception&) = default;
 
     const char* what() const noexcept override { return message_.c_str(); }
-    const char* stackTrace() const noexcept { return stack_.c_str(); }
+
+    /// @brief Symbolized and demangled, not safe to call concurrently on the
+    ///        same object
+    const char* stackTrace() const noexcept {
+        if (stack_.empty() && !trace_.empty()) {
+            try {
+                stack_ = trace_.toString();
+            } catch (...) {
+            }
+        }
+        return stack_.c_str();
+    }
+
+    /// @brief Raw program counters captured by the constructor
+    const StackTrace& trace() const noexcept { return trace_; }
 
 private:
     std::string message_;
-    std::string stack_;
+    StackTrace trace_;
+    mutable std::string stack_;
 };
 }  // namespace Lute
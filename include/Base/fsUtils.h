@@ -137,7 +137,11 @@ public:
     ///             标志的扩展模式打开文件，表示文件在执行 exec
     ///             系统调用时自动关闭
     ///
-    explicit AppendFile(const std::string& filename);
+    /// @param preallocate - reserve this many bytes of disk up front
+    ///        (fallocate KEEP_SIZE) so appends don't allocate blocks; the
+    ///        unused part is released on close
+    ///
+    explicit AppendFile(const std::string& filename, off_t preallocate = 0);
     ~AppendFile();
 
     ///
@@ -164,6 +168,7 @@ private:
     FILE* fp_;                // FILE*
     char buffer_[64 * 1024];  // 64KB
     off_t writtenBytes_;      // 已经写入的字节数
+    off_t preallocated_;      // fallocate 预留的字节数
 };
 
 }  // namespace Lute
@@ -0,0 +1,147 @@
+///
+/// @brief Function wrappers that keep the callable in an inline buffer
+///   - InplaceFunction<Sig, N>: copyable, never allocates; a callable bigger
+///     than N bytes is a compile error.
+///   - UniqueFunction<Sig, N>: move-only, so it can own unique_ptr captures;
+///     a callable bigger than N bytes falls back to the heap.
+/// @note N defaults to 32 bytes (a std::function, a bound member function,
+///       a lambda with four captures) so that either wrapper is 64 bytes.
+///       Both store the callable in a basic_any (see any.h) next to one
+///       invoker pointer.
+/// @usage
+///     Lute::UniqueFunction<void()> task = [p = std::move(ptr)] { use(*p); };
+///     queue.push(std::move(task));  // no malloc
+///
+
+#pragma once
+
+#include <Base/any.h>  // basic_any
+
+#include <cstddef>      // size_t nullptr_t
+#include <functional>   // bad_function_call invoke
+#include <type_traits>  // enable_if is_invocable_r
+#include <utility>      // forward move
+
+namespace Lute {
+
+/// Default inline capacity of InplaceFunction / UniqueFunction
+const std::size_t kFunctionInlineCapacity = 4 * sizeof(void*);
+
+namespace detail {
+    template <typename Sig, std::size_t N, bool Copyable, bool AllowHeap>
+    class BasicFunction;
+
+    template <typename R, typename... Args, std::size_t N, bool Copyable,
+              bool AllowHeap>
+    class BasicFunction<R(Args...), N, Copyable, AllowHeap> {
+        using Target = basic_any<N, Copyable>;
+
+        template <typename F>
+        using enable_if_callable = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type,
+                          BasicFunction>::value &&
+            std::is_invocable_r<R, typename std::decay<F>::type&,
+                                Args...>::value>::type;
+
+    public:
+        BasicFunction() noexcept : invoke_(nullptr) {}
+        BasicFunction(std::nullptr_t) noexcept : invoke_(nullptr) {}
+
+        BasicFunction(const BasicFunction&) = default;
+        BasicFunction& operator=(const BasicFunction&) = default;
+
+        BasicFunction(BasicFunction&& rhs) noexcept
+            : target_(std::move(rhs.target_)), invoke_(rhs.invoke_) {
+            rhs.invoke_ = nullptr;
+        }
+
+        BasicFunction& operator=(BasicFunction&& rhs) noexcept {
+            if (this != &rhs) {
+                target_ = std::move(rhs.target_);
+                invoke_ = rhs.invoke_;
+                rhs.invoke_ = nullptr;
+            }
+            return *this;
+        }
+
+        /// Wraps a copy of f (moved if it's an rvalue)
+        template <typename F, typename = enable_if_callable<F> >
+        BasicFunction(F&& f) : invoke_(nullptr) {
+            assign(std::forward<F>(f));
+        }
+
+        template <typename F, typename = enable_if_callable<F> >
+        BasicFunction& operator=(F&& f) {
+            BasicFunction(std::forward<F>(f)).swap(*this);
+            return *this;
+        }
+
+        BasicFunction& operator=(std::nullptr_t) noexcept {
+            target_.reset();
+            invoke_ = nullptr;
+            return *this;
+        }
+
+        /// Calls the target, throws bad_function_call if empty
+        R operator()(Args... args) const {
+            if (invoke_ == nullptr) throw std::bad_function_call();
+            return invoke_(target_, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+        void swap(BasicFunction& rhs) noexcept {
+            target_.swap(rhs.target_);
+            std::swap(invoke_, rhs.invoke_);
+        }
+
+        /// True if the target lives in the inline buffer (or it's empty)
+        bool is_inline() const noexcept {
+            return invoke_ == nullptr || target_.is_inline();
+        }
+
+    private:
+        template <typename F>
+        static R invoke(Target& target, Args&&... args) {
+            return std::invoke(*target.template get<F>(),
+                               std::forward<Args>(args)...);
+        }
+
+        template <typename F>
+        static bool isNull(const F&, std::false_type) {
+            return false;
+        }
+
+        template <typename Pointer>
+        static bool isNull(Pointer p, std::true_type) {
+            return p == nullptr;
+        }
+
+        template <typename Callable>
+        void assign(Callable&& f) {
+            using F = typename std::decay<Callable>::type;
+            static_assert(AllowHeap || Target::template fits_inline<F>::value,
+                          "callable too big for the InplaceFunction capacity");
+            static_assert(!Copyable || std::is_copy_constructible<F>::value,
+                          "use UniqueFunction for move-only callables");
+            /// a null function pointer gives an empty wrapper
+            if (isNull(f, std::integral_constant<
+                              bool, std::is_pointer<F>::value ||
+                                        std::is_member_pointer<F>::value>()))
+                return;
+            target_.template emplace<F>(std::forward<Callable>(f));
+            invoke_ = &invoke<F>;
+        }
+
+        mutable Target target_;
+        R (*invoke_)(Target&, Args&&...);
+    };
+}  // namespace detail
+
+template <typename Sig, std::size_t N = kFunctionInlineCapacity>
+using InplaceFunction = detail::BasicFunction<Sig, N, true, false>;
+
+template <typename Sig, std::size_t N = kFunctionInlineCapacity>
+using UniqueFunction = detail::BasicFunction<Sig, N, false, true>;
+
+}  // namespace Lute
@@ -97,6 +97,7 @@
 #include <cassert>
 #include <fstream>
 #include <memory>
+#include <memory_resource>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -135,14 +136,22 @@ namespace ini {
 
     /**
      * @brief std::pair<string, T>
+     * @note The containers allocate from a std::pmr::memory_resource, given
+     *       at construction and handed down to nested sections, e.g.
+     *          Lute::Arena arena;
+     *          Lute::ArenaResource resource(&arena);
+     *          Lute::ini::INIStructure ini(&resource);
      */
     template <typename T>
     class INIMAP {
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
     private:
         using string = std::string;
-        using DataIdxMap = std::unordered_map<string, std::size_t>;
+        using DataIdxMap = std::pmr::unordered_map<string, std::size_t>;
         using DataItem = std::pair<string, T>;
-        using DataContainer = std::vector<DataItem>;
+        using DataContainer = std::pmr::vector<DataItem>;
         using MultiArgs = typename std::vector<std::pair<string, T>>;
 
         DataIdxMap dataIndexMap_;
@@ -157,15 +166,27 @@ namespace ini {
 
     public:
         INIMAP() {}
-        INIMAP(const INIMAP& other) {
+        explicit INIMAP(const allocator_type& alloc)
+            : dataIndexMap_(alloc), data_(alloc) {}
+        INIMAP(const INIMAP& other) : INIMAP(other, allocator_type()) {}
+        INIMAP(const INIMAP& other, const allocator_type& alloc)
+            : dataIndexMap_(other.dataIndexMap_, alloc), data_(alloc) {
             std::size_t data_size = other.data_.size();
+            data_.reserve(data_size);
             for (std::size_t i = 0; i < data_size; ++i) {
                 const auto& key = other.data_[i].first;
                 const auto& obj = other.data_[i].second;
                 data_.emplace_back(key, obj);
             }
-            dataIndexMap_ = DataIdxMap(other.dataIndexMap_);
         }
+        INIMAP(INIMAP&& other) = default;
+        INIMAP(INIMAP&& other, const allocator_type& alloc)
+            : dataIndexMap_(std::move(other.dataIndexMap_), alloc),
+              data_(std::move(other.data_), alloc) {}
+        INIMAP& operator=(const INIMAP& other) = default;
+        INIMAP& operator=(INIMAP&& other) = default;
+
+        allocator_type get_allocator() const { return data_.get_allocator(); }
 
         T& operator[](string key) {
             trim(key);
@@ -658,7 +679,7 @@ namespace ini {
                 return generate(data);
             }
 
-            INIStructure originalData;
+            INIStructure originalData(data.get_allocator());
             LineDataPtr lineData;
             bool readSuccess = false;
             bool fileIsBOM = false;
@@ -1,6 +1,7 @@
 ///
 /// @brief Logger
-/// @note Default async logger
+/// @note Default async logger, lines are formatted straight into its buffer
+///       (AsyncLogger::reserve / commit)
 /// @usage
 ///     #include <Base/logger.h>
 ///     int main {
@@ -13,32 +14,42 @@
 
 #pragma once
 
-#include <Base/fsUtils.h>    // AppendFile
-#include <Base/mutex.h>      // MutexLock
-#include <Base/thread.h>     // Thread
-#include <Base/timestamp.h>  // Timestamp
-#include <Base/utils.h>      // memZero
+#include <Base/countDownLatch.h>  // CountDownLatch
+#include <Base/fsUtils.h>         // AppendFile
+#include <Base/mutex.h>           // MutexLock
+#include <Base/thread.h>          // Thread
+#include <Base/timestamp.h>       // Timestamp
+#include <Base/utils.h>           // memZero
 
+#include <atomic>  // atomic
 #include <memory>  // unique_ptr
+#include <vector>  // vector
 
 /// NOTE Message Delimiter
 constexpr char MsgDelimiter[] = "@ ";
 
 namespace Lute {
 
+class Counter;
+class Gauge;
+
 namespace detail {
+    /// longest line a Logger formats, longer ones are truncated
     const int kSmallBuffer = 4000;
     const int kLargeBuffer = 4000 * 1000;
 
-    template <int SIZE>
-    class FixedBuffer {
+    ///
+    /// @brief Append cursor over memory owned by someone else: a region
+    ///        reserved in the AsyncLogger buffer, or LogStream's own storage
+    ///
+    class LineBuffer {
     public:
         /// non-copyable
-        FixedBuffer(const FixedBuffer&) = delete;
-        FixedBuffer& operator=(FixedBuffer&) = delete;
+        LineBuffer(const LineBuffer&) = delete;
+        LineBuffer& operator=(LineBuffer&) = delete;
 
-        FixedBuffer() : cur_(data_) { setCookie(cookieStart); }
-        ~FixedBuffer() { setCookie(cookieEnd); }
+        LineBuffer(char* data, size_t size)
+            : data_(data), cur_(data), end_(data + size) {}
 
         void append(const char* /*restrict*/ buf, size_t len) {
             // FIXME: append partially
@@ -53,46 +64,135 @@ namespace detail {
 
         // write to data_ directly
         char* current() { return cur_; }
-        int avail() const { return static_cast<int>(end() - cur_); }
+        int avail() const { return static_cast<int>(end_ - cur_); }
         void add(size_t len) { cur_ += len; }
 
         void reset() { cur_ = data_; }
-        void bzero() { memZero(data_, sizeof data_); }
 
-        // for used by GDB
-        const char* debugString();
-        void setCookie(void (*cookie)()) { cookie_ = cookie; }
         // for used by unit test
         std::string toString() const { return std::string(data_, length()); }
-        // StringPiece toStringPiece() const {
-        // return StringPiece(data_, static_cast<size_t>(length()));
-        // }
 
     private:
-        const char* end() const { return data_ + sizeof data_; }
-        // Must be outline function for cookies.
-        static void cookieStart();
-        static void cookieEnd();
-
-        void (*cookie_)();
-        char data_[SIZE];
+        char* const data_;
         char* cur_;
+        char* const end_;
+    };
+
+    ///
+    /// @brief The owning buffer LogStream used to have, for code that names
+    ///        it: a LineBuffer over SIZE bytes of its own
+    ///
+    template <int SIZE>
+    class FixedBuffer : public LineBuffer {
+    public:
+        FixedBuffer() : LineBuffer(storage_, SIZE) {}
+
+        void bzero() { memZero(storage_, sizeof storage_); }
+
+    private:
+        char storage_[SIZE];
+    };
+
+    ///
+    /// @brief AsyncLogger's buffer. Producers reserve a region under the
+    ///        AsyncLogger mutex, fill it without any lock and commit. The
+    ///        commit gives the unused tail back when no later region was
+    ///        reserved meanwhile, and records it as a hole otherwise. The
+    ///        backend waits for the pending commits and writes the bytes
+    ///        between the holes.
+    ///
+    class LogBuffer {
+    public:
+        static const int kSize = kLargeBuffer;
+        /// a Logger line reserves kSmallBuffer bytes, so a buffer rarely has
+        /// more holes than that; smaller reservations spill the rest
+        static const int kMaxHoles = kLargeBuffer / kSmallBuffer + 24;
+
+        /// non-copyable
+        LogBuffer(const LogBuffer&) = delete;
+        LogBuffer& operator=(LogBuffer&) = delete;
+
+        LogBuffer() : cursor_(0), pending_(0), holeCount_(0) {}
+
+        ///
+        /// @brief Reserve `maxLen` bytes, the caller holds the AsyncLogger
+        ///        mutex, so commits are the only concurrent writers
+        /// @return false if the buffer is too full
+        ///
+        bool tryReserve(int maxLen, int* offset) {
+            int cur = cursor_.load(std::memory_order_relaxed);
+            do {
+                if (kSize - cur <= maxLen) return false;
+            } while (!cursor_.compare_exchange_weak(cur, cur + maxLen,
+                                                    std::memory_order_relaxed));
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            *offset = cur;
+            return true;
+        }
+
+        /// @brief `len` of the `maxLen` bytes reserved at `offset` are used
+        void commit(int offset, int maxLen, int len);
+
+        ///
+        /// @brief Wait until every reservation is committed: spin briefly,
+        ///        then sleep until the last commit wakes us
+        ///
+        void waitCommitted();
+
+        /// @brief Call `f(data, len)` on the committed bytes between holes
+        template <typename F>
+        void forEachSegment(F&& f);
+
+        char* data() { return data_; }
+        int length() const { return cursor_.load(std::memory_order_relaxed); }
+        void reset() {
+            cursor_.store(0, std::memory_order_relaxed);
+            holeCount_.store(0, std::memory_order_relaxed);
+            MutexLockGuard lock(spillMutex_);
+            spilled_.clear();
+        }
+        void bzero() { memZero(data_, sizeof data_); }
+
+    private:
+        struct Hole {
+            int offset;
+            int size;
+        };
+
+        /// set in pending_ while waitCommitted() sleeps on it
+        static const int kWaiting = 1 << 30;
+
+        std::atomic<int> cursor_;
+        /// reservations not committed yet, | kWaiting
+        std::atomic<int> pending_;
+        std::atomic<int> holeCount_;
+        Hole holes_[kMaxHoles];
+        /// holes past kMaxHoles
+        MutexLock spillMutex_;
+        std::vector<Hole> spilled_ GUARDED_BY(spillMutex_);
+        char data_[kSize];
     };
 }  // namespace detail
 
 // ---
 
-class LogStream {
+///
+/// @brief Formats into memory it doesn't own: the region a Logger reserved
+///        in the output's buffer, or a LogStream's storage
+///
+class LineStream {
 public:
-    using Buffer = detail::FixedBuffer<detail::kSmallBuffer>;
-    using self = LogStream;
+    using Buffer = detail::LineBuffer;
+    using self = LineStream;
     static const int kMaxNumericSize = 48;
 
     /// non-copyable
-    LogStream(const LogStream&) = delete;
-    LogStream& operator=(LogStream&) = delete;
+    LineStream(const LineStream&) = delete;
+    LineStream& operator=(LineStream&) = delete;
 
-    LogStream() = default;
+    /// @brief Formats into `size` bytes at `data`, owned by the caller
+    LineStream(char* data, int size)
+        : buffer_(data, static_cast<size_t>(size)) {}
 
     self& operator<<(bool v);
     self& operator<<(short);
@@ -136,6 +236,18 @@ private:
     Buffer buffer_;
 };
 
+///
+/// @brief A LineStream over kSmallBuffer bytes of its own, to format
+///        outside a Logger; LOG_* streams are LineStreams with no storage
+///
+class LogStream : public LineStream {
+public:
+    LogStream() : LineStream(storage_, sizeof storage_) {}
+
+private:
+    char storage_[detail::kSmallBuffer];
+};
+
 class Fmt {
 public:
     ///
@@ -154,41 +266,91 @@ private:
 };
 
 ///
-/// @brief
+/// @brief A number with SI / IEC units, e.g.
+///        `LOG_INFO << "rss " << Lute::FmtIEC(bytes) << "B";`
+///        formatted with integers only, no std::string.
+///
+class FmtSI {
+public:
+    explicit FmtSI(int64_t value) : value_(value) {}
+    int64_t value() const { return value_; }
+
+private:
+    int64_t value_;
+};
+
+class FmtIEC {
+public:
+    explicit FmtIEC(int64_t value) : value_(value) {}
+    int64_t value() const { return value_; }
+
+private:
+    int64_t value_;
+};
+
+namespace detail {
+    struct NextLogFile;
+}  // namespace detail
+
+///
+/// @brief Log file rolled by size and by period,
+///        `basename.YYYYmmdd-HHMMSS.hostname.pid.log`
+/// @note Rolling doesn't stall the writer: a background thread shared by
+///       all LogFiles keeps the next file open and preallocated under a
+///       hidden name (`.basename.hostname.pid.log.N.next`). A roll swaps it
+///       in, then the thread renames it, closes the old file and prepares
+///       the next one. If that one isn't ready yet, the roll opens the file
+///       itself as before. Spares left by processes that died are removed
+///       when a LogFile of the same basename starts. A child forked after
+///       the thread started rolls synchronously.
 ///
 class LogFile {
 public:
+    static const int kDefaultRollPeriod = 60 * 60 * 24;
+    /// the most a preallocated file reserves, less if rollSize is smaller
+    static constexpr off_t kMaxPreallocate = 64 * 1024 * 1024;
+
     /// non - copyable
     LogFile(const LogFile&) = delete;
     LogFile& operator=(LogFile&) = delete;
 
     LogFile(const std::string& basename, off_t rollSize, bool threadSafe = true,
             int flushInterval = 3, int checkEveryN = 1024);
+    /// @brief Waits for the background thread to close the rolled files
     ~LogFile();
 
     void append(const char* logline, int len);
     void flush();
     bool rollFile();
 
-private:
-    const static int kRollPerSeconds_ = 60 * 60 * 24;
+    ///
+    /// @brief Also roll when the wall clock enters a new `seconds` period
+    ///        (UTC aligned), 3600 rolls hourly. Call before appending.
+    ///
+    void setRollPeriod(int seconds);
 
+private:
     void append_unlocked(const char* logline, int len);
-
-    static std::string getLogFileName(const std::string& basename, time_t* now);
+    /// @brief basename.YYYYmmdd-HHMMSS.hostname.pid.log
+    std::string logFileName(time_t now) const;
 
     const std::string basename_;  // 日志文件名
     const off_t rollSize_;        // 日志文件 roll threshold
     const int flushInterval_;     // 日志写入间隔
     const int checkEveryN_;       // check every N
+    /// `.hostname.pid.log`, looked up once
+    const std::string suffix_;
 
     int count_;
+    int rollPeriod_;  // 按时间 roll 的周期（秒）
 
     std::unique_ptr<MutexLock> mutex_;
     time_t startOfPeriod_;              // 开始记录日志的时间
     time_t lastRoll_;                   // Last roll time
     time_t lastFlush_;                  // Last flush time
     std::unique_ptr<AppendFile> file_;  // 日志文件
+    /// shared with the background thread
+    std::shared_ptr<detail::NextLogFile> next_;
 };
 
 ///
@@ -209,6 +371,17 @@ public:
     using OutputFunc = void (*)(const char* msg, int len);
     using FlushFunc = void (*)();
 
+    /// @brief A region of the output's buffer a line is formatted into
+    struct Reservation {
+        char* data;
+        int capacity;
+        /// for the output, e.g. which buffer `data` is in
+        void* token;
+    };
+    /// @return false to have the line formatted aside and given to OutputFunc
+    using ReserveFunc = bool (*)(int maxLen, Reservation* reservation);
+    using CommitFunc = void (*)(const Reservation& reservation, int len);
+
     /// @brief compile time calculation of basename of source file
     class SourceFile {
     public:
@@ -240,13 +413,24 @@ public:
     Logger(SourceFile file, int line, bool toAbort);
     ~Logger();
 
-    LogStream& stream() { return impl_.stream_; }
+    LineStream& stream() { return impl_.stream_; }
 
     static LogLevel logLevel();
     static void setLogLevel(LogLevel level);
 
-    static void setOutput(OutputFunc);
+    /// @brief Lines are formatted aside and copied to `out`, this also
+    ///        removes the reserve / commit pair set by setReserve()
+    static void setOutput(OutputFunc out);
     static void setFlush(FlushFunc);
+    ///
+    /// @brief Format lines straight into the output's buffer: a line
+    ///        reserves kSmallBuffer bytes and commits what it used
+    ///
+    static void setReserve(ReserveFunc reserve, CommitFunc commit);
+
+    /// @brief "YYYY/MM/DD hh:mm:ss.uuuuuu", so merged files interleave
+    ///        within a second, see tools/logMerge.cc
+    static void setMicroseconds(bool on);
 
 private:
     class Impl {
@@ -255,14 +439,21 @@ private:
 
         /// @brief Constructor
         Impl(LogLevel level, int old_errno, const SourceFile& file, int line);
+        ~Impl();
+
+        /// @brief Hand the finished line to the output
+        void finish();
 
         /**
          * @brief 将本地时间格式化
          */
         void formatTime();
 
+        /// nullptr if the line is formatted aside for g_output
+        CommitFunc commit_;
+        Reservation reserved_;
         Timestamp time_;
-        LogStream stream_;
+        LineStream stream_;
         LogLevel level_;
         int line_;
         SourceFile basename_;
@@ -286,8 +477,39 @@ public:
         if (running_) stop();
     }
 
+    /// @brief Copy a whole line in, reserve() + commit()
     void append(const char* logline, int len);
 
+    ///
+    /// @brief Reserve `maxLen` bytes in the current buffer, fill them and
+    ///        commit() without holding any lock. Keep the time in between
+    ///        short: the backend waits for the commit before it writes the
+    ///        buffer out.
+    /// @return false if `maxLen` doesn't fit in a buffer
+    ///
+    bool reserve(int maxLen, Logger::Reservation* reservation);
+    /// @brief `len` of the reserved bytes are used, 0 drops the line
+    void commit(const Logger::Reservation& reservation, int len);
+
+    ///
+    /// @brief Low-latency mode, call before start(). A line is written and
+    ///        flushed to the file at most `ms` milliseconds after it was
+    ///        logged, instead of when its 4MB buffer fills or every
+    ///        flushInterval seconds. 0 turns it off.
+    /// @note The first line into an empty buffer wakes the backend, which
+    ///       then gathers lines for the rest of the delay.
+    ///
+    void setMaxDelay(int ms) { maxDelayMs_ = ms; }
+
+    ///
+    /// @brief Also wake the backend as soon as the current buffer holds
+    ///        `bytes`, call before start(). 0 turns it off.
+    ///
+    void setNotifyBytes(int bytes) { notifyBytes_ = bytes; }
+
+    /// @brief See LogFile::setRollPeriod, call before start()
+    void setRollPeriod(int seconds) { rollPeriod_ = seconds; }
+
     /// @brief start -
     ///  1. start thread
     ///  2. latch wait
@@ -297,16 +519,20 @@ public:
         latch_.wait();
     }
 
-    void stop() NO_THREAD_SAFETY_ANALYSIS {
+    void stop() {
         running_ = false;
-        cond_.notify();
+        wakeBackend();
         thread_.join();
     }
 
 private:
     void threadFunc();
+    /// @brief Backend: sleep until there is something to write
+    void waitForWork();
+    /// @brief Frontend: end the backend's waitForWork()
+    void wakeBackend();
 
-    using Buffer = detail::FixedBuffer<detail::kLargeBuffer>;
+    using Buffer = detail::LogBuffer;
     using BufferVector = std::vector<std::unique_ptr<Buffer>>;
     using BufferPtr = BufferVector::value_type;
 
@@ -317,7 +543,17 @@ private:
     Thread thread_;
     CountDownLatch latch_;
     MutexLock mutex_;
-    Condition cond_ GUARDED_BY(mutex_);
+    /// futex word the backend sleeps on, bumped by every wakeBackend()
+    std::atomic<uint32_t> wakeSeq_;
+    /// wakeBackend() skips the syscall while the backend is awake
+    std::atomic<bool> sleeping_;
+    int maxDelayMs_;
+    int notifyBytes_;
+    int rollPeriod_;
+    /// CLOCK_MONOTONIC ms of the first line in currentBuffer_
+    int64_t firstLineMs_ GUARDED_BY(mutex_);
+    /// currentBuffer_ crossed notifyBytes_
+    bool flushNow_ GUARDED_BY(mutex_);
 
     /// 当前缓冲
     BufferPtr currentBuffer_ GUARDED_BY(mutex_);
@@ -325,6 +561,73 @@ private:
     BufferPtr nextBuffer_ GUARDED_BY(mutex_);
     /// 待写入文件的已填满的缓冲
     BufferVector buffers_ GUARDED_BY(mutex_);
+    /// 后端写完后回收的多余缓冲，前端写入过快时优先复用，而非重新申请 4MB
+    BufferVector spareBuffers_ GUARDED_BY(mutex_);
+    static const size_t kMaxSpareBuffers = 4;
+
+    /// Published to MetricsRegistry::instance() as lute_async_logger_*
+    Counter& appendedLines_;
+    Counter& appendedBytes_;
+    Counter& writtenBytes_;
+    Counter& droppedBuffers_;
+    Counter& droppedLines_;
+    Gauge& buffersInFlight_;
+};
+
+///
+/// @brief K AsyncLoggers, each with its own backend thread, `LogFile` and
+///        roll sequence, for more volume than one backend thread can
+///        write. Shard `i` writes `basename-i.<time>.<host>.<pid>.log`.
+///        A thread logs to the shard of its CurrentThread::index(), or to
+///        the one of a category through appendTo(shardOf(category), ...).
+///        Lines of one thread keep their order within its shard,
+///        tools/logMerge interleaves the files by timestamp.
+///
+class ShardedAsyncLogger {
+public:
+    /// non-copyable
+    ShardedAsyncLogger(const ShardedAsyncLogger&) = delete;
+    ShardedAsyncLogger& operator=(const ShardedAsyncLogger&) = delete;
+
+    ShardedAsyncLogger(const std::string& basename, off_t rollSize,
+                       int shards, int flushInterval = 3);
+
+    /// @brief The shard of the calling thread
+    int shardOf() const {
+        return CurrentThread::index() % static_cast<int>(shards_.size());
+    }
+    /// @brief The shard of a category, the same in every process
+    int shardOf(const string_view& category) const;
+
+    void append(const char* logline, int len) {
+        shards_[static_cast<size_t>(shardOf())]->append(logline, len);
+    }
+    void appendTo(int shard, const char* logline, int len) {
+        shards_[static_cast<size_t>(shard)]->append(logline, len);
+    }
+
+    /// @brief AsyncLogger::reserve / commit on the calling thread's shard
+    bool reserve(int maxLen, Logger::Reservation* reservation) {
+        return shards_[static_cast<size_t>(shardOf())]->reserve(maxLen,
+                                                                 reservation);
+    }
+    void commit(const Logger::Reservation& reservation, int len) {
+        shards_[static_cast<size_t>(shardOf())]->commit(reservation, len);
+    }
+
+    /// @brief See AsyncLogger, call before start()
+    void setMaxDelay(int ms);
+    void setNotifyBytes(int bytes);
+    void setRollPeriod(int seconds);
+
+    void start();
+    void stop();
+
+    int size() const { return static_cast<int>(shards_.size()); }
+    AsyncLogger& shard(int i) { return *shards_[static_cast<size_t>(i)]; }
+
+private:
+    std::vector<std::unique_ptr<AsyncLogger>> shards_;
 };
 
 }  // namespace Lute
@@ -341,27 +644,43 @@ public:
 };
 
 ///
-/// @brief Not declared in class LogStream
+/// @brief Not declared in class LineStream
 ///
-inline Lute::LogStream& operator<<(Lute::LogStream& s, T v) {
+inline Lute::LineStream& operator<<(Lute::LineStream& s, T v) {
     s.append(v.str_, static_cast<int>(v.len_));
     return s;
 }
 ///
-/// @brief Not declared in class LogStream
+/// @brief Not declared in class LineStream
 ///
-inline Lute::LogStream& operator<<(Lute::LogStream& s,
+inline Lute::LineStream& operator<<(Lute::LineStream& s,
                                    const Lute::Logger::SourceFile& v) {
     s.append(v.data_, v.size_);
     return s;
 }
 ///
-/// @brief Not declared in class LogStream
+/// @brief Not declared in class LineStream
 ///
-inline Lute::LogStream& operator<<(Lute::LogStream& s, const Lute::Fmt& fmt) {
+inline Lute::LineStream& operator<<(Lute::LineStream& s, const Lute::Fmt& fmt) {
     s.append(fmt.data(), fmt.length());
     return s;
 }
+///
+/// @brief Not declared in class LineStream
+///
+inline Lute::LineStream& operator<<(Lute::LineStream& s, Lute::FmtSI v) {
+    char buf[Lute::kFormatUnitsSize];
+    s.append(buf, static_cast<int>(Lute::formatSI(buf, v.value())));
+    return s;
+}
+///
+/// @brief Not declared in class LineStream
+///
+inline Lute::LineStream& operator<<(Lute::LineStream& s, Lute::FmtIEC v) {
+    char buf[Lute::kFormatUnitsSize];
+    s.append(buf, static_cast<int>(Lute::formatIEC(buf, v.value())));
+    return s;
+}
 
 // NOTE Global logger level
 extern Lute::Logger::LogLevel g_logLevel;
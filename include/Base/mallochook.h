@@ -1,6 +1,9 @@
 /**
  * @brief 重写 malloc 和 free，仅限于 Linux 使用
  * https://github.com/sjp38/mallochook/blob/master/mallochook.c
+ * @note Prints every call, for demos only. To profile a real workload use
+ *       the sampling profiler in tools/allocProfiler.cc:
+ *          LD_PRELOAD=build/lib/libLute_AllocProfiler.so ./program
  * @usage
         1. Use hooked:
             LD_PRELOAD=$(PWD)/Lute_Base.so ./program
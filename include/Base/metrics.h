@@ -0,0 +1,275 @@
+///
+/// @brief In-process metrics: sharded counters, gauges and log-linear
+///        latency histograms, with Prometheus text / JSON exposition.
+/// @note The record path (`Counter::inc`, `Histogram::record`) is one relaxed
+///       atomic add on a shard owned by the calling thread: no lock, no
+///       allocation, no shared cache line in the common case.
+/// @usage
+///     auto& reqs = Lute::MetricsRegistry::instance().counter(
+///         "lute_requests_total", "Handled requests");
+///     auto& lat = Lute::MetricsRegistry::instance().histogram(
+///         "lute_request_latency_us", "Request latency in microseconds");
+///     reqs.inc();
+///     lat.record(elapsedUs);
+///     ...
+///     std::string text = Lute::MetricsRegistry::instance().toPrometheus();
+///
+
+#pragma once
+
+#include <Base/condition_variable.h>  // Condition
+#include <Base/mutex.h>               // MutexLock
+#include <Base/perCpu.h>              // kCacheLineSize
+#include <Base/thread.h>              // Thread
+
+#include <atomic>      // atomic
+#include <cstdint>     // int64_t uint64_t
+#include <functional>  // function
+#include <map>         // map
+#include <memory>      // unique_ptr
+#include <string>      // string
+
+namespace Lute {
+
+class LogFile;
+
+namespace detail {
+    /// Shards per counter / histogram, must be a power of 2
+    const int kMetricShards = 16;
+
+    /// @brief Shard index of the calling thread, assigned round-robin
+    int metricShard();
+}  // namespace detail
+
+///
+/// @brief Monotonic counter, sharded per thread
+///
+class Counter {
+public:
+    /// non-copyable
+    Counter(const Counter&) = delete;
+    Counter& operator=(Counter&) = delete;
+
+    Counter() = default;
+
+    void inc(int64_t n = 1) {
+        shards_[detail::metricShard()].value.fetch_add(
+            n, std::memory_order_relaxed);
+    }
+
+    /// @brief Sum of all shards, may lag concurrent `inc()`s
+    int64_t value() const;
+
+private:
+    struct alignas(detail::kCacheLineSize) Shard {
+        std::atomic<int64_t> value{0};
+    };
+    Shard shards_[detail::kMetricShards];
+};
+
+///
+/// @brief Point-in-time value, either set explicitly or read from a callback
+///        at exposition time
+///
+class Gauge {
+public:
+    using Callback = std::function<int64_t()>;
+
+    /// non-copyable
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(Gauge&) = delete;
+
+    Gauge() : value_(0) {}
+
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    void sub(int64_t n) { value_.fetch_sub(n, std::memory_order_relaxed); }
+
+    /// @brief Must be set before the gauge is exposed, not thread safe
+    void setCallback(Callback cb) { callback_ = std::move(cb); }
+
+    int64_t value() const {
+        return callback_ ? callback_() : value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> value_;
+    Callback callback_;
+};
+
+///
+/// @brief Log-linear (HDR style) histogram of non-negative integers.
+///        Each power of two is split into `kSubBuckets` linear buckets,
+///        so any recorded value is reported within 1 / kSubBuckets (6.25%).
+///
+class Histogram {
+public:
+    static const int kSubBucketBits = 4;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static const int kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+    /// Fewer shards than Counter, a shard is ~8KB
+    static const int kShards = detail::kMetricShards / 2;
+
+    /// @brief Aggregated view of all shards
+    struct Snapshot {
+        uint64_t count;
+        int64_t sum;
+        uint64_t buckets[kNumBuckets];
+
+        double mean() const {
+            return count ? static_cast<double>(sum) / static_cast<double>(count)
+                         : 0.0;
+        }
+        /// @brief Value at quantile q in [0, 1], upper bound of its bucket
+        int64_t percentile(double q) const;
+        /// @brief Upper bound of the highest non-empty bucket
+        int64_t max() const;
+    };
+
+    /// non-copyable
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(Histogram&) = delete;
+
+    Histogram() = default;
+
+    void record(int64_t v) {
+        if (v < 0) v = 0;
+        Shard& shard = shards_[detail::metricShard() & (kShards - 1)];
+        shard.buckets[bucketIndex(static_cast<uint64_t>(v))].fetch_add(
+            1, std::memory_order_relaxed);
+        shard.sum.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    void snapshot(Snapshot* snap) const;
+
+    static int bucketIndex(uint64_t v) {
+        if (v < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(v);
+        const int msb = 63 - __builtin_clzll(v);
+        const int shift = msb - kSubBucketBits;
+        const int sub = static_cast<int>((v >> shift) & (kSubBuckets - 1));
+        return (shift + 1) * kSubBuckets + sub;
+    }
+
+    /// @brief Largest value falling into bucket `index`
+    static int64_t bucketUpperBound(int index);
+
+private:
+    struct alignas(detail::kCacheLineSize) Shard {
+        std::atomic<int64_t> sum{0};
+        std::atomic<uint64_t> buckets[kNumBuckets] = {};
+    };
+    Shard shards_[kShards];
+};
+
+///
+/// @brief Named metrics. Registration takes a lock, recording never does;
+///        returned references stay valid for the registry's life time.
+///
+class MetricsRegistry {
+public:
+    enum class Format {
+        kPrometheus,
+        kJson,
+    };
+
+    /// non-copyable
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(MetricsRegistry&) = delete;
+
+    MetricsRegistry() = default;
+
+    /// @brief Process wide registry used by the library itself
+    static MetricsRegistry& instance();
+
+    /// @brief Get or create. Creating an existing name with another type
+    ///        aborts.
+    Counter& counter(const std::string& name, const std::string& help = "");
+    Gauge& gauge(const std::string& name, const std::string& help = "");
+    Histogram& histogram(const std::string& name, const std::string& help = "");
+
+    /// @brief Prometheus text exposition format 0.0.4. Histograms are exposed
+    ///        as summaries (quantiles 0.5, 0.9, 0.99, 0.999 + _sum/_count).
+    std::string toPrometheus() const;
+    std::string toJson() const;
+    std::string dump(Format format) const {
+        return format == Format::kJson ? toJson() : toPrometheus();
+    }
+
+    /// @brief Append a dump to `file` and flush it
+    void writeTo(LogFile& file, Format format = Format::kPrometheus) const;
+    /// @brief Replace `filename` with a dump, via a temporary file + rename
+    bool writeToFile(const std::string& filename,
+                     Format format = Format::kPrometheus) const;
+
+private:
+    enum class Type { kCounter, kGauge, kHistogram };
+
+    struct Entry {
+        Type type;
+        std::string help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    Entry& getOrCreate(const std::string& name, const std::string& help,
+                       Type type) REQUIRES(mutex_);
+
+    mutable MutexLock mutex_;
+    std::map<std::string, Entry> metrics_ GUARDED_BY(mutex_);
+};
+
+///
+/// @brief Periodic aggregator: renders a registry every `interval` seconds
+///        on a background thread and hands the text to a sink.
+///
+class MetricsReporter {
+public:
+    using Sink = std::function<void(const std::string&)>;
+
+    /// non-copyable
+    MetricsReporter(const MetricsReporter&) = delete;
+    MetricsReporter& operator=(MetricsReporter&) = delete;
+
+    MetricsReporter(MetricsRegistry& registry, double interval, Sink sink,
+                    MetricsRegistry::Format format =
+                        MetricsRegistry::Format::kPrometheus);
+    ~MetricsReporter() {
+        if (running_) stop();
+    }
+
+    /// @brief Sink that appends to `file`, which must outlive the reporter
+    static Sink logFileSink(LogFile& file);
+    /// @brief Sink that atomically replaces `filename` on every report
+    static Sink fileSink(const std::string& filename);
+
+    void start();
+    void stop();
+
+    /// @brief Render and sink once in the calling thread
+    void report();
+
+private:
+    void threadFunc();
+
+    MetricsRegistry& registry_;
+    const double interval_;
+    const Sink sink_;
+    const MetricsRegistry::Format format_;
+    std::atomic<bool> running_;
+    Thread thread_;
+    MutexLock mutex_;
+    Condition cond_ GUARDED_BY(mutex_);
+};
+
+namespace metrics {
+    ///
+    /// @brief Publish process stats (rss, vm, cpu, faults, context switches,
+    ///        threads, fds) as callback gauges, read via ResourceSampler at
+    ///        exposition time.
+    ///
+    void registerProcessMetrics(
+        MetricsRegistry& registry = MetricsRegistry::instance());
+}  // namespace metrics
+
+}  // namespace Lute
@@ -0,0 +1,251 @@
+///
+/// @brief Sharded storage: one cache-line aligned T per CPU or per thread
+///   - PerCpu<T>: a shard per configured CPU, `local()` picks the shard of
+///     the CPU the caller runs on (rseq cpu_id, sched_getcpu() otherwise).
+///     The thread may migrate or be preempted, so a shard can be touched by
+///     several threads at once: T must be safe for that (atomics).
+///     The shards of each NUMA node are allocated together on that node.
+///   - PerThread<T>: a shard per live thread, indexed by
+///     CurrentThread::index(). Only its thread writes `local()`, a new
+///     thread that reuses an index also reuses the shard and its value.
+///   Both offer `forEach` / `reduce` over all shards, which may run while
+///   other threads update them.
+/// @usage
+///     Lute::PerCpu<std::atomic<int64_t>> hits(0);
+///     hits.local().fetch_add(1, std::memory_order_relaxed);
+///     int64_t total = hits.reduce(int64_t(0), [](int64_t sum, auto& v) {
+///         return sum + v.load(std::memory_order_relaxed);
+///     });
+///
+
+#pragma once
+
+#include <Base/currentThread.h>  // CurrentThread
+
+#include <atomic>      // atomic
+#include <cstddef>     // size_t
+#include <functional>  // function
+#include <memory>      // unique_ptr
+#include <new>         // placement new
+#include <utility>     // forward
+#include <vector>      // vector
+
+namespace Lute {
+namespace detail {
+    const int kCacheLineSize = 64;
+
+    struct CpuTopology {
+        /// configured CPUs, including offline ones
+        int cpus;
+        /// NUMA nodes, 1 if the kernel doesn't report any
+        int nodes;
+        /// node of each CPU
+        std::vector<int> nodeOfCpu;
+    };
+
+    /// @brief Read from /sys once
+    const CpuTopology& cpuTopology();
+
+    ///
+    /// @brief Page-aligned zeroed memory, preferably placed on `node`
+    ///        (mbind MPOL_PREFERRED, ignored where not permitted)
+    /// @throw std::bad_alloc
+    ///
+    void* allocateOnNode(size_t bytes, int node);
+    void freeOnNode(void* p, size_t bytes);
+}  // namespace detail
+
+///
+/// @brief A T per CPU, see the file comment
+///
+template <typename T>
+class PerCpu {
+public:
+    /// non-copyable
+    PerCpu(const PerCpu&) = delete;
+    PerCpu& operator=(PerCpu&) = delete;
+
+    /// @brief Every shard is constructed from `args`
+    template <typename... Args>
+    explicit PerCpu(const Args&... args) {
+        const detail::CpuTopology& topo = detail::cpuTopology();
+        size_ = topo.cpus;
+        slots_.reset(new Slot*[static_cast<size_t>(size_)]);
+        regions_.reserve(static_cast<size_t>(topo.nodes));
+
+        for (int node = 0; node < topo.nodes; ++node) {
+            size_t count = 0;
+            for (int cpu = 0; cpu < size_; ++cpu)
+                count += topo.nodeOfCpu[static_cast<size_t>(cpu)] == node;
+            if (count == 0) continue;
+
+            Region region{nullptr, count * sizeof(Slot), 0};
+            region.memory = static_cast<Slot*>(
+                detail::allocateOnNode(region.bytes, node));
+            regions_.push_back(region);
+            Region& r = regions_.back();
+            for (int cpu = 0; cpu < size_; ++cpu) {
+                if (topo.nodeOfCpu[static_cast<size_t>(cpu)] != node) continue;
+                try {
+                    slots_[static_cast<size_t>(cpu)] =
+                        new (r.memory + r.constructed) Slot(args...);
+                } catch (...) {
+                    destroy();
+                    throw;
+                }
+                ++r.constructed;
+            }
+        }
+    }
+
+    ~PerCpu() { destroy(); }
+
+    /// @brief Shard of the CPU the caller is running on
+    T& local() { return shard(CurrentThread::cpu()); }
+
+    T& shard(int cpu) {
+        /// CPUs hot-plugged after startup share the existing shards
+        if (__builtin_expect(cpu >= size_, 0)) cpu %= size_;
+        return slots_[static_cast<size_t>(cpu)]->value;
+    }
+    const T& shard(int cpu) const {
+        return const_cast<PerCpu*>(this)->shard(cpu);
+    }
+
+    int size() const { return size_; }
+
+    template <typename F>
+    void forEach(F&& f) {
+        for (int cpu = 0; cpu < size_; ++cpu) f(shard(cpu));
+    }
+    template <typename F>
+    void forEach(F&& f) const {
+        for (int cpu = 0; cpu < size_; ++cpu) f(shard(cpu));
+    }
+
+    /// @brief `init = f(init, shard)` over all shards
+    template <typename R, typename F>
+    R reduce(R init, F&& f) const {
+        for (int cpu = 0; cpu < size_; ++cpu) init = f(init, shard(cpu));
+        return init;
+    }
+
+private:
+    struct alignas(detail::kCacheLineSize) Slot {
+        template <typename... Args>
+        explicit Slot(const Args&... args) : value(args...) {}
+        T value;
+    };
+
+    /// @brief The shards of one node
+    struct Region {
+        Slot* memory;
+        size_t bytes;
+        size_t constructed;
+    };
+
+    void destroy() {
+        for (Region& region : regions_) {
+            for (size_t i = 0; i < region.constructed; ++i)
+                region.memory[i].~Slot();
+            detail::freeOnNode(region.memory, region.bytes);
+        }
+        regions_.clear();
+    }
+
+    int size_;
+    std::unique_ptr<Slot*[]> slots_;
+    std::vector<Region> regions_;
+};
+
+///
+/// @brief A T per live thread, see the file comment
+///
+template <typename T>
+class PerThread {
+public:
+    /// Shards are allocated in chunks as thread indices grow
+    static const int kChunkShift = 6;
+    static const int kChunkSize = 1 << kChunkShift;
+    static const int kMaxChunks = 256;
+    /// indices past this share shards, don't rely on exclusive access there
+    static const int kMaxThreads = kChunkSize * kMaxChunks;
+
+    /// non-copyable
+    PerThread(const PerThread&) = delete;
+    PerThread& operator=(PerThread&) = delete;
+
+    ///
+    /// @brief Every shard is constructed from `args`, when the first thread
+    ///        of its chunk asks for it
+    ///
+    template <typename... Args>
+    explicit PerThread(Args... args)
+        : construct_([args...](void* p) { new (p) T(args...); }) {
+        for (auto& chunk : chunks_) chunk.store(nullptr);
+    }
+
+    ~PerThread() {
+        for (auto& chunk : chunks_) delete chunk.load();
+    }
+
+    /// @brief Shard of the calling thread
+    T& local() {
+        int index = CurrentThread::index();
+        if (__builtin_expect(index >= kMaxThreads, 0)) index %= kMaxThreads;
+        Chunk* chunk = chunks_[index >> kChunkShift].load(
+            std::memory_order_acquire);
+        if (__builtin_expect(chunk == nullptr, 0))
+            chunk = allocateChunk(index >> kChunkShift);
+        return chunk->slots[index & (kChunkSize - 1)].value();
+    }
+
+    /// @brief Visit the shards allocated so far
+    template <typename F>
+    void forEach(F&& f) const {
+        for (const auto& c : chunks_) {
+            Chunk* chunk = c.load(std::memory_order_acquire);
+            if (chunk == nullptr) continue;
+            for (Slot& slot : chunk->slots) f(slot.value());
+        }
+    }
+
+    /// @brief `init = f(init, shard)` over the shards allocated so far
+    template <typename R, typename F>
+    R reduce(R init, F&& f) const {
+        forEach([&init, &f](T& value) { init = f(init, value); });
+        return init;
+    }
+
+private:
+    struct alignas(detail::kCacheLineSize) Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        T& value() { return *reinterpret_cast<T*>(storage); }
+    };
+
+    struct Chunk {
+        Slot slots[kChunkSize];
+        size_t constructed = 0;
+        ~Chunk() {
+            for (size_t i = 0; i < constructed; ++i) slots[i].value().~T();
+        }
+    };
+
+    Chunk* allocateChunk(int c) {
+        std::unique_ptr<Chunk> chunk(new Chunk);
+        for (Slot& slot : chunk->slots) {
+            construct_(slot.storage);
+            ++chunk->constructed;
+        }
+        Chunk* expected = nullptr;
+        if (chunks_[c].compare_exchange_strong(expected, chunk.get(),
+                                               std::memory_order_acq_rel))
+            return chunk.release();
+        return expected;  // another thread of the chunk won
+    }
+
+    const std::function<void(void*)> construct_;
+    std::atomic<Chunk*> chunks_[kMaxChunks];
+};
+
+}  // namespace Lute
@@ -0,0 +1,131 @@
+///
+/// @brief Pinyin dictionary indexed directly by codepoint
+/// @note One uint32_t per CJK Unified Ideograph (U+4E00 .. U+9FA5, ~84KB)
+///       packs the offset and length of its readings ("zhong1,zhong4") in a
+///       pooled blob, with the length of the first one so the toneless,
+///       toned and initial forms are all prefixes of the same bytes.
+///       Reading lists are deduplicated, the whole blob is ~21KB. A lookup
+///       is one bounds check and one load, no hashing, no string compare.
+///       builtin() is compiled from pinyin.txt at build time (see
+///       tools/pinyinDictGen.cc): its tables live in .rodata, need no
+///       parsing and are shared read-only by every parser and process.
+///
+
+#pragma once
+
+#include <Base/string_view.h>  // string_view
+
+#include <cstdint>  // uint32_t
+#include <string>   // string
+#include <vector>   // vector
+
+namespace Lute {
+
+class PinyinDict {
+public:
+    static const uint32_t kFirst = 0x4E00;
+    static const uint32_t kLast = 0x9FA5;
+    static const uint32_t kSize = kLast - kFirst + 1;
+
+    PinyinDict();
+    PinyinDict(const PinyinDict& rhs);
+    PinyinDict& operator=(const PinyinDict& rhs);
+
+    /// @brief The dictionary embedded in the library, nothing to load
+    static const PinyinDict& builtin();
+
+    /// @brief Load a "王=wang2,wang4" file
+    /// @return 0 on success, -1 if the file can't be read
+    int load(const std::string& path);
+
+    ///
+    /// @brief Add or replace the readings of `codepoint`, comma separated,
+    ///        most common first, with or without tone digits. A dictionary
+    ///        viewing builtin tables copies them first.
+    ///
+    void add(uint32_t codepoint, const string_view& readings);
+
+    /// @brief The first reading of `codepoint` without tone, empty if unknown
+    string_view lookup(uint32_t codepoint) const {
+        const uint32_t entry = entryOf(codepoint);
+        return string_view(blob_ + (entry & kOffsetMask),
+                           (entry >> kFirstShift) & kFirstMask);
+    }
+
+    /// @brief The first reading with its tone digit ("zhong1")
+    string_view lookupTone(uint32_t codepoint) const {
+        const uint32_t entry = entryOf(codepoint);
+        return string_view(blob_ + (entry & kOffsetMask),
+                           ((entry >> kFirstShift) & kFirstMask) +
+                               ((entry & kToneBit) ? 1 : 0));
+    }
+
+    /// @brief Every reading with tones, comma separated ("zhong1,zhong4")
+    string_view readings(uint32_t codepoint) const {
+        const uint32_t entry = entryOf(codepoint);
+        return string_view(blob_ + (entry & kOffsetMask),
+                           entry >> kLengthShift);
+    }
+
+    /// @brief Number of characters with a reading
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// @brief Bytes used by the table and the blob
+    size_t memoryUsage() const { return kSize * sizeof(uint32_t) + blobSize_; }
+
+    /// @brief False if the tables are the read-only builtin ones
+    bool owned() const { return owned_; }
+
+    /// @brief Raw tables, for the build-time generator
+    const uint32_t* entries() const { return entries_; }
+    string_view blob() const { return string_view(blob_, blobSize_); }
+
+    ///
+    /// @brief Codepoint of the 3-byte UTF-8 sequence at `p`, 0 if it isn't
+    ///        one. `p` must have 3 readable bytes.
+    ///
+    static uint32_t decode3(const char* p) {
+        const auto b0 = static_cast<unsigned char>(p[0]);
+        const auto b1 = static_cast<unsigned char>(p[1]);
+        const auto b2 = static_cast<unsigned char>(p[2]);
+        if ((b0 & 0xF0) != 0xE0 || (b1 & 0xC0) != 0x80 || (b2 & 0xC0) != 0x80)
+            return 0;
+        return (static_cast<uint32_t>(b0 & 0x0F) << 12) |
+               (static_cast<uint32_t>(b1 & 0x3F) << 6) | (b2 & 0x3F);
+    }
+
+private:
+    /// offset:18 | first reading length without tone:4 | has tone:1 |
+    /// length of all readings:8
+    static const int kFirstShift = 18;
+    static const uint32_t kOffsetMask = (1u << kFirstShift) - 1;
+    static const uint32_t kFirstMask = 0xF;
+    static const uint32_t kToneBit = 1u << 22;
+    static const int kLengthShift = 23;
+
+    uint32_t entryOf(uint32_t codepoint) const {
+        const uint32_t index = codepoint - kFirst;
+        return index < kSize ? entries_[index] : 0;
+    }
+
+    /// View over static tables
+    PinyinDict(const uint32_t* entries, const char* blob, size_t blobSize,
+               size_t size);
+
+    /// Copy viewed tables into ownedEntries_ / ownedBlob_
+    void own();
+    void rebind();
+
+    std::vector<uint32_t> ownedEntries_;
+    std::string ownedBlob_;
+    bool owned_;
+
+    /// kSize packed entries, 0 for unknown
+    const uint32_t* entries_;
+    const char* blob_;
+    size_t blobSize_;
+    size_t size_;
+};
+
+}  // namespace Lute
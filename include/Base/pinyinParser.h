@@ -3,12 +3,10 @@
  * @file pinyinParser.h
  * @author Tianen Lu (tianenlu957@gmail.com)
  * @brief Conver 中文 to pinyin
+ * @note A parser starts with the dictionary built into the library, so
+ *       InitPinyinMap is only needed to load a different file.
  * @example
  *   Lute::PinyinParser parser;
- *   if (parser.InitPinyinMap(PINYIN_FILE) != 0) {
- *       cout<<"GetPinYinMap error, ret:" << endl;
- *       return -1;
- *   }
  *   string zh = "哈哈";
  *   string zhpinyin;
  *   if (parser.ConvertZh2Pinyin(zh, zhpinyin) != 0) {
@@ -22,27 +20,172 @@
 
 #pragma once
 
-#include <fstream>
+#include <Base/pinyinDict.h>   // PinyinDict
+#include <Base/string_view.h>  // string_view
+
+#include <atomic>
+#include <cstdint>
 #include <iostream>
-#include <map>
 #include <string>
-
-// NOTE it must be modified to your own path
-#define PINYIN_FILE \
-    "/home/lux/githubWorkplace/Lute/Base/include/Base/pinyin.txt"
+#include <vector>
 
 namespace Lute {
+
+///
+/// @brief Counters of a conversion, instead of printing every miss
+///
+struct PinyinStats {
+    /// characters of the dictionary range replaced by their pinyin
+    uint64_t converted = 0;
+    /// characters of the dictionary range without a reading, copied as is
+    uint64_t misses = 0;
+    /// malformed UTF-8 bytes, copied as is
+    uint64_t invalid = 0;
+
+    PinyinStats& operator+=(const PinyinStats& rhs) {
+        converted += rhs.converted;
+        misses += rhs.misses;
+        invalid += rhs.invalid;
+        return *this;
+    }
+};
+
+///
+/// @brief One dictionary character, or one run of other bytes, of the input
+///
+struct PinyinSegment {
+    /// bytes [begin, end) of the input
+    uint32_t begin;
+    uint32_t end;
+    /// where the segment starts in each output of PinyinResult, it ends
+    /// where the next one starts
+    uint32_t plain;
+    uint32_t tone;
+    uint32_t initials;
+    /// every reading of the character ("zhong1,zhong4"), pointing into the
+    /// dictionary; empty for other bytes
+    string_view readings;
+};
+
+///
+/// @brief Outputs of PinyinParser::convert(src, modes, result), only those
+///        selected by the modes are filled. Appended to; clear() between
+///        inputs so segment offsets stay relative to one input.
+///
+struct PinyinResult {
+    /// kPlain: "zhongguo"
+    std::string plain;
+    /// kTone: "zhong1guo2"
+    std::string tone;
+    /// kInitials: "zg"
+    std::string initials;
+    /// kSegments
+    std::vector<PinyinSegment> segments;
+
+    void clear();
+};
+
+///
+/// @brief Reusable output of a batch conversion: every record's pinyin in
+///        one buffer. clear() keeps the memory for the next batch.
+///
+class PinyinArena {
+public:
+    PinyinArena() : offsets_(1, 0) {}
+
+    /// @brief Number of records
+    size_t size() const { return offsets_.size() - 1; }
+
+    string_view operator[](size_t i) const {
+        return string_view(data_.data() + offsets_[i],
+                           offsets_[i + 1] - offsets_[i]);
+    }
+
+    /// @brief All records back to back
+    const std::string& buffer() const { return data_; }
+
+    void clear() {
+        data_.clear();
+        offsets_.resize(1);
+    }
+
+private:
+    friend class PinyinParser;
+
+    /// One worker's output, merged into data_ afterwards
+    struct Chunk {
+        std::string data;
+        std::vector<size_t> ends;
+        PinyinStats stats;
+    };
+
+    std::string data_;
+    /// record i is data_[offsets_[i], offsets_[i + 1])
+    std::vector<size_t> offsets_;
+    /// scratch, kept to avoid reallocating per batch
+    std::vector<string_view> records_;
+    std::vector<Chunk> chunks_;
+};
+
 class PinyinParser {
 public:
-    PinyinParser() { map_.clear(); }
+    /// Outputs of convert(src, modes, result), or-ed together
+    enum Mode : unsigned {
+        kPlain = 1u << 0,
+        kTone = 1u << 1,
+        kInitials = 1u << 2,
+        kSegments = 1u << 3,
+    };
 
+    PinyinParser() : dict_(PinyinDict::builtin()), misses_(0) {}
+
+    ///
+    /// @brief Replace the dictionary with the one in `path`, or the builtin
+    ///        one if `path` is empty. The current one is kept on error.
+    ///
     int InitPinyinMap(std::string path = "");
 
     int ConvertZh2Pinyin(std::string& src, std::string& dst);
 
+    const PinyinDict& dict() const { return dict_; }
+
+    ///
+    /// @brief Append the pinyin of `src` to `*out`. ASCII runs are copied
+    ///        16 bytes at a time, other characters are copied as is.
+    ///
+    void convert(const string_view& src, std::string* out,
+                 PinyinStats* stats = nullptr) const;
+
+    ///
+    /// @brief Fill the outputs selected by `modes` in one pass over `src`.
+    ///        Text other than dictionary characters is copied as is to each
+    ///        output; polyphonic characters use their first reading, all of
+    ///        them are in the segments.
+    ///
+    void convert(const string_view& src, unsigned modes, PinyinResult* result,
+                 PinyinStats* stats = nullptr) const;
+
+    ///
+    /// @brief Convert every input into `*arena` (appended, in order), split
+    ///        across `threads` threads (0: one per CPU). Small batches run
+    ///        on the calling thread.
+    ///
+    void convertBatch(const std::vector<std::string>& inputs,
+                      PinyinArena* arena, int threads = 0,
+                      PinyinStats* stats = nullptr) const;
+
+    /// @brief Same with one record per line of `buffer` ('\n' separated)
+    void convertLines(const string_view& buffer, PinyinArena* arena,
+                      int threads = 0, PinyinStats* stats = nullptr) const;
+
+    /// @brief Misses of ConvertZh2Pinyin so far
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
 private:
-    bool IsZh(const char* p);
+    void convertRecords(PinyinArena* arena, int threads,
+                        PinyinStats* stats) const;
 
-    std::map<std::string, std::string> map_;
+    PinyinDict dict_;
+    std::atomic<uint64_t> misses_;
 };
 }  // namespace Lute
@@ -0,0 +1,205 @@
+///
+/// @brief Fast pseudo random numbers, the thread-safe successor of
+///        randomUniform
+///   - SplitMix64 / Xoshiro256ss (xoshiro256**) / WyRand generators, all
+///     usable with <random> distributions
+///   - randomBounded / randomInt / randomDouble on a thread-local
+///     xoshiro256**: no lock, no shared cache line
+///   - Lemire's nearly divisionless bounded integers
+///   - fillRandom: bulk fill from 8 interleaved streams, vectorized with
+///     AVX2 when the CPU has it
+/// @note Not for cryptography.
+/// @usage
+///     Lute::seedThreadRandom(42);            // optional, reproducible
+///     uint64_t dice = Lute::randomInt(1, 6);
+///     double p = Lute::randomDouble();       // [0, 1)
+///     uint64_t keys[1024];
+///     Lute::fillRandom(keys, 1024);
+///
+
+#pragma once
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+
+namespace Lute {
+
+///
+/// @brief SplitMix64, used to expand a single seed into generator states
+///
+class SplitMix64 {
+public:
+    using result_type = uint64_t;
+
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state_;
+};
+
+///
+/// @brief xoshiro256** by Blackman and Vigna: 256 bits of state, period
+///        2^256 - 1, passes BigCrush
+/// @note Trivially default constructible (all-zero state, which must be
+///       seeded before use) so it can live in a __thread variable.
+///
+class Xoshiro256ss {
+public:
+    using result_type = uint64_t;
+
+    Xoshiro256ss() = default;
+    explicit Xoshiro256ss(uint64_t seed) { this->seed(seed); }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    void seed(uint64_t seed) {
+        SplitMix64 sm(seed);
+        for (uint64_t& s : s_) s = sm();
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    ///
+    /// @brief Advance by 2^128 calls: gives up to 2^128 non-overlapping
+    ///        streams from one seed
+    ///
+    void jump();
+
+    const uint64_t* state() const { return s_; }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t s_[4];
+};
+
+///
+/// @brief wyrand by Wang Yi: 64 bits of state, one multiply per call.
+///        Faster than xoshiro256**, period 2^64.
+///
+class WyRand {
+public:
+    using result_type = uint64_t;
+
+    WyRand() = default;
+    explicit WyRand(uint64_t seed) : state_(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    void seed(uint64_t seed) { state_ = seed; }
+
+    result_type operator()() {
+        state_ += 0xa0761d6478bd642fULL;
+        const __uint128_t m = static_cast<__uint128_t>(state_) *
+                              (state_ ^ 0xe7037ed1a0b428dbULL);
+        return static_cast<uint64_t>(m >> 64) ^ static_cast<uint64_t>(m);
+    }
+
+private:
+    uint64_t state_;
+};
+
+///
+/// @brief Uniform integer in [0, bound) without modulo bias, by Lemire's
+///        multiply-shift. Divides only in the rare rejection case.
+/// @param bound must not be 0
+///
+template <typename Rng>
+inline uint64_t boundedRandom(Rng& rng, uint64_t bound) {
+    uint64_t x = rng();
+    __uint128_t m = static_cast<__uint128_t>(x) * bound;
+    auto low = static_cast<uint64_t>(m);
+    if (__builtin_expect(low < bound, 0)) {
+        const uint64_t threshold = (0 - bound) % bound;
+        while (low < threshold) {
+            x = rng();
+            m = static_cast<__uint128_t>(x) * bound;
+            low = static_cast<uint64_t>(m);
+        }
+    }
+    return static_cast<uint64_t>(m >> 64);
+}
+
+/// @brief Uniform double in [0, 1) from the top 53 bits
+inline double toUnitDouble(uint64_t x) {
+    return static_cast<double>(x >> 11) * 0x1.0p-53;
+}
+
+namespace detail {
+    // internal
+    extern __thread Xoshiro256ss t_random;
+    extern __thread bool t_randomSeeded;
+
+    /// seed t_random from the process seed and a per-thread counter
+    void seedThreadRandom();
+}  // namespace detail
+
+///
+/// @brief The calling thread's generator, seeded on first use with a
+///        different stream per thread
+///
+inline Xoshiro256ss& threadRandom() {
+    if (__builtin_expect(!detail::t_randomSeeded, 0))
+        detail::seedThreadRandom();
+    return detail::t_random;
+}
+
+///
+/// @brief Re-seed the calling thread's generator (and its fillRandom
+///        streams), e.g. for a reproducible load test
+///
+void seedThreadRandom(uint64_t seed);
+
+inline uint64_t randomU64() { return threadRandom()(); }
+
+/// @brief Uniform in [0, bound), bound must not be 0
+inline uint64_t randomBounded(uint64_t bound) {
+    return boundedRandom(threadRandom(), bound);
+}
+
+/// @brief Uniform in [lo, hi], both inclusive
+inline int64_t randomInt(int64_t lo, int64_t hi) {
+    const uint64_t span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+    if (__builtin_expect(span == ~uint64_t(0), 0))
+        return static_cast<int64_t>(randomU64());
+    return static_cast<int64_t>(static_cast<uint64_t>(lo) +
+                                randomBounded(span + 1));
+}
+
+/// @brief Uniform in [0, 1)
+inline double randomDouble() { return toUnitDouble(randomU64()); }
+
+///
+/// @brief Fill with random 64-bit words from the calling thread's 8 bulk
+///        streams (jumped copies of threadRandom())
+///
+void fillRandom(uint64_t* data, size_t n);
+
+/// @brief Fill `bytes` random bytes
+void fillRandom(void* buf, size_t bytes);
+
+}  // namespace Lute
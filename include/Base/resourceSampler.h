@@ -0,0 +1,107 @@
+///
+/// @brief Low-overhead process / thread resource sampler
+/// @note ProcessInfo::numThreads() / openedFiles() / threadStat() reopen and
+///       re-parse /proc on every call. ResourceSampler keeps the /proc fds
+///       open, pread()s into preallocated buffers and parses the numeric
+///       fields in place, without std::string.
+/// @usage
+///     Lute::ResourceSampler sampler(1.0);  // sample once per second
+///     sampler.start();
+///     ...
+///     Lute::ResourceSampler::Snapshot snap = sampler.snapshot();  // lock-free
+///     LOG_INFO << "rss: " << snap.rssBytes;
+///
+
+#pragma once
+
+#include <Base/condition_variable.h>  // Condition
+#include <Base/mutex.h>               // MutexLock
+#include <Base/thread.h>              // Thread
+
+#include <atomic>   // atomic
+#include <cstdint>  // int64_t
+
+namespace Lute {
+
+class ResourceSampler {
+public:
+    ///
+    /// @brief One sample of the process resource usage
+    ///
+    struct Snapshot {
+        int64_t sampleTime;  // microseconds since epoch, 0 if never sampled
+        int64_t rssBytes;    // resident set size
+        int64_t vmBytes;     // virtual memory size
+        int64_t userTicks;   // user mode CPU time, in clock ticks
+        int64_t systemTicks;           // kernel mode CPU time, in clock ticks
+        int64_t minorFaults;           // page faults without disk IO
+        int64_t majorFaults;           // page faults with disk IO
+        int64_t voluntaryCtxSwitches;  // blocked / yielded
+        int64_t involuntaryCtxSwitches;  // preempted
+        int64_t numThreads;
+        int64_t openedFiles;
+    };
+
+    /// non-copyable
+    ResourceSampler(const ResourceSampler&) = delete;
+    ResourceSampler& operator=(ResourceSampler&) = delete;
+
+    /// @brief Open /proc/self/{stat,status,fd} once
+    /// @param interval Sampling period of the background thread, in seconds
+    explicit ResourceSampler(double interval = 1.0);
+    ~ResourceSampler();
+
+    /// @brief Start the background sampling thread
+    void start();
+    /// @brief Stop and join the background sampling thread
+    void stop();
+    bool running() const { return running_.load(); }
+
+    ///
+    /// @brief Sample synchronously in the calling thread and publish the
+    ///        result, i.e. `snapshot()` returns it afterwards.
+    /// @return false if /proc can't be read
+    ///
+    bool sample(Snapshot* snap = nullptr);
+
+    ///
+    /// @brief The latest published snapshot. Lock-free (seqlock), safe to
+    ///        call from any thread while the sampler thread is writing.
+    ///
+    Snapshot snapshot() const;
+
+    ///
+    /// @brief CPU time consumed by the calling thread, in nanoseconds.
+    ///        One vDSO call (CLOCK_THREAD_CPUTIME_ID), no /proc access.
+    ///
+    static int64_t threadCpuTimeNanos();
+
+private:
+    void threadFunc();
+    bool readStat(Snapshot* snap);
+    bool readStatus(Snapshot* snap);
+    int64_t countOpenedFiles();
+    void publish(const Snapshot& snap);
+
+    static const int kBufferSize = 4096;
+    static const int kNumFields = sizeof(Snapshot) / sizeof(int64_t);
+
+    const double interval_;
+    int statFd_;    // /proc/self/stat
+    int statusFd_;  // /proc/self/status
+    int fdDirFd_;   // /proc/self/fd
+
+    std::atomic<bool> running_;
+    Thread thread_;
+    MutexLock mutex_;
+    Condition cond_ GUARDED_BY(mutex_);
+
+    /// Only touched by the sampling thread (or `sample()` caller)
+    char buf_[kBufferSize];
+
+    /// Seqlock protected snapshot: odd sequence means write in progress
+    std::atomic<uint64_t> seq_;
+    std::atomic<int64_t> fields_[kNumFields];
+};
+
+}  // namespace Lute
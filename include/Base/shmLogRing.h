@@ -0,0 +1,202 @@
+///
+/// @brief Log lines from many processes through one shared-memory ring
+/// @note A POSIX shared memory object (`/dev/shm/<name>`) holds a byte
+///       ring with many producers and one consumer. Producers claim room
+///       with a CAS on the head cursor, fill it and publish the record by
+///       storing its header; nothing is locked and no producer waits on
+///       another. A full ring drops the line and counts it. The consumer,
+///       tools/logDaemon, drains the records in claim order into rolled
+///       LogFiles: one writer thread and one set of files per host
+///       instead of an AsyncLogger in every process.
+///       initLogger() appends to the ring named by LOG_SHM_RING when it is
+///       set and the daemon is running.
+///       Records are 16-byte aligned: an 8-byte header word, the line
+///       length and the producer's pid, then the line. The word holds the
+///       record's span and a tag derived from its position, so a header
+///       left from an earlier lap never reads as published.
+/// @usage
+///     // logDaemon
+///     auto ring = Lute::ShmLogRing::create("/lute-log", 64 << 20);
+///     while (running) {
+///         if (ring->drain([&](const char* line, int len) {
+///                 file.append(line, len);
+///             }) == 0)
+///             ring->waitForData(1000);
+///     }
+///     // every other process
+///     auto ring = Lute::ShmLogRing::open("/lute-log");
+///     ring->append(line, len);
+///
+
+#pragma once
+
+#include <Base/logger.h>  // Logger::Reservation
+
+#include <atomic>   // atomic
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <memory>   // unique_ptr
+#include <string>   // string
+
+namespace Lute {
+namespace detail {
+    /// lives at the start of the shared memory object
+    struct ShmRingHeader {
+        /// stored last by the creator
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        uint64_t capacity;
+        /// producers: next position to claim, in bytes since creation
+        alignas(64) std::atomic<uint64_t> head;
+        /// consumer: next position to read
+        alignas(64) std::atomic<uint64_t> tail;
+        /// lines dropped because the ring was full
+        alignas(64) std::atomic<uint64_t> dropped;
+        /// futex word the consumer sleeps on, bumped to wake it
+        alignas(64) std::atomic<uint32_t> wakeSeq;
+        /// producers only issue FUTEX_WAKE while this is set
+        std::atomic<uint32_t> sleeping;
+    };
+
+    struct ShmRingRecord {
+        /// `tag << 32 | kBusy? | span`, see ShmLogRing::tagOf
+        std::atomic<uint64_t> word;
+        /// bytes of the line, kPadding for the filler before a wrap,
+        /// kHandedBack for the one after a shrunk line
+        uint32_t length;
+        /// producer, to tell a dead one from a slow one
+        int32_t pid;
+    };
+}  // namespace detail
+
+class ShmLogRing {
+public:
+    /// records are aligned on this, the header included
+    static const size_t kAlign = 16;
+    static const size_t kMinCapacity = 64 * 1024;
+
+    /// non-copyable
+    ShmLogRing(const ShmLogRing&) = delete;
+    ShmLogRing& operator=(const ShmLogRing&) = delete;
+
+    ///
+    /// @brief Consumer: create the ring `name` ("/lute-log"). `capacity` is
+    ///        rounded up to a power of 2. A ring of that capacity left by a
+    ///        previous consumer is reused, so producers keep their mapping
+    ///        and nothing they wrote meanwhile is lost; anything else under
+    ///        the name is replaced.
+    /// @return nullptr on failure, errno is set
+    ///
+    static std::unique_ptr<ShmLogRing> create(const std::string& name,
+                                              size_t capacity);
+    ///
+    /// @brief Producer: map the ring a consumer created
+    /// @return nullptr if there is none or it isn't a ring, errno is set
+    ///
+    static std::unique_ptr<ShmLogRing> open(const std::string& name);
+    /// @brief Remove the name, mappings stay valid
+    static bool unlink(const std::string& name);
+
+    ~ShmLogRing();
+
+    /// @brief Producer: copy a whole line in, reserve() + commit()
+    /// @return false if the ring is full, the line is dropped
+    bool append(const char* line, int len);
+
+    ///
+    /// @brief Producer: claim room for up to `maxLen` bytes, fill it and
+    ///        commit() it. The consumer stops at the claim until it is
+    ///        committed, keep the time in between short.
+    /// @return false if the ring is full; append() counts the line dropped
+    ///
+    bool reserve(int maxLen, Logger::Reservation* reservation);
+    /// @brief `len` of the reserved bytes are used, 0 drops the line
+    void commit(const Logger::Reservation& reservation, int len);
+
+    ///
+    /// @brief Consumer: call `f(line, len)` for every published record
+    ///        from the tail on, up to the first one still being written
+    /// @return number of lines passed to `f`
+    ///
+    template <typename F>
+    size_t drain(F&& f) {
+        size_t lines = 0;
+        uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        while (tail != header_->head.load(std::memory_order_acquire)) {
+            detail::ShmRingRecord* record = recordAt(tail);
+            const uint64_t word =
+                record->word.load(std::memory_order_acquire);
+            if ((word >> 32) != tagOf(tail) || (word & kBusy)) break;
+            /// only skipDeadWriter() trusts these, see commit()
+            if (record->length == kHandedBack) break;
+            if (record->length != kPadding && record->length > 0) {
+                f(reinterpret_cast<const char*>(record + 1),
+                  static_cast<int>(record->length));
+                ++lines;
+            }
+            tail += word & kSpanMask;
+            /// hands the room back to the producers
+            header_->tail.store(tail, std::memory_order_release);
+        }
+        return lines;
+    }
+
+    ///
+    /// @brief Consumer: sleep until a producer commits or `timeoutMs`
+    /// @return false on timeout
+    ///
+    bool waitForData(int timeoutMs);
+
+    ///
+    /// @brief Consumer: skip the record at the tail if the process that
+    ///        claimed it has exited without committing it. Producers must
+    ///        share the consumer's pid namespace.
+    /// @note A producer dying in reserve() between its CAS and the header
+    ///       store, a few instructions, still blocks the ring. One dying in
+    ///       commit() is skipped with all it claimed.
+    /// @return true if a record was skipped, it counts as dropped
+    ///
+    bool skipDeadWriter();
+
+    /// @brief Lines dropped on a full ring since creation
+    uint64_t dropped() const {
+        return header_->dropped.load(std::memory_order_relaxed);
+    }
+    /// @brief Bytes claimed and not yet drained
+    size_t used() const {
+        return static_cast<size_t>(
+            header_->head.load(std::memory_order_acquire) -
+            header_->tail.load(std::memory_order_acquire));
+    }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static const uint64_t kBusy = uint64_t(1) << 31;
+    static const uint64_t kSpanMask = kBusy - 1;
+    static const uint32_t kPadding = 0xffffffff;
+    /// filler for the room a commit() is handing back
+    static const uint32_t kHandedBack = 0xfffffffe;
+
+    ShmLogRing(void* memory, size_t bytes);
+
+    /// @brief Tag of the record at `pos`, unique over 2^32 records
+    static uint64_t tagOf(uint64_t pos) {
+        return ((pos / kAlign) + 1) & 0xffffffff;
+    }
+
+    detail::ShmRingRecord* recordAt(uint64_t pos) const {
+        return reinterpret_cast<detail::ShmRingRecord*>(
+            data_ + (pos & (capacity_ - 1)));
+    }
+
+    /// @brief Producer: end the consumer's waitForData()
+    void wakeConsumer();
+
+    void* memory_;
+    const size_t bytes_;
+    detail::ShmRingHeader* const header_;
+    char* const data_;
+    const size_t capacity_;
+};
+
+}  // namespace Lute
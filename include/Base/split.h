@@ -0,0 +1,182 @@
+///
+/// @brief Allocation-free split / tokenize over string_view
+/// @note The ranges and their tokens point into the input, which must
+///       outlive them.
+/// @usage
+///     for (Lute::string_view field : Lute::split("a,b,,c", ','))
+///         ...  // "a" "b" "" "c"
+///     for (Lute::string_view word : Lute::tokenize("  a \t b  "))
+///         ...  // "a" "b"
+///
+
+#pragma once
+
+#include <Base/string_view.h>  // string_view
+#include <Base/utils.h>        // search
+
+#include <cstddef>   // ptrdiff_t
+#include <cstdint>   // uint64_t
+#include <cstring>   // memchr
+#include <iterator>  // forward_iterator_tag
+
+namespace Lute {
+
+///
+/// @brief A forward range of the pieces of `str` between delimiters
+///
+class Split {
+public:
+    enum Mode {
+        kChar,      // a single character
+        kSequence,  // the whole delimiter string
+        kAnyOf,     // any character of the delimiter string
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const string_view*;
+        using reference = const string_view&;
+
+        /// end()
+        iterator() : split_(nullptr), next_(0) {}
+
+        explicit iterator(const Split* split) : split_(split), next_(0) {
+            advance();
+        }
+
+        reference operator*() const { return token_; }
+        pointer operator->() const { return &token_; }
+
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator tmp = *this;
+            advance();
+            return tmp;
+        }
+
+        bool operator==(const iterator& rhs) const {
+            return split_ == rhs.split_ &&
+                   (split_ == nullptr || next_ == rhs.next_);
+        }
+        bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+    private:
+        void advance() {
+            do {
+                if (split_ == nullptr) return;
+                if (next_ > split_->str_.size()) {
+                    split_ = nullptr;
+                    return;
+                }
+                size_t delimLen = 0;
+                const size_t end = split_->find(next_, &delimLen);
+                token_ = string_view(split_->str_.data() + next_, end - next_);
+                next_ = delimLen ? end + delimLen : end + 1;
+            } while (split_->skipEmpty_ && token_.empty());
+        }
+
+        const Split* split_;
+        size_t next_;  // > str_.size() once the last token was produced
+        string_view token_;
+    };
+
+    Split(const string_view& str, char delimiter, bool skipEmpty)
+        : str_(str),
+          ch_(delimiter),
+          mode_(kChar),
+          skipEmpty_(skipEmpty),
+          anyOf_{0, 0, 0, 0} {}
+
+    Split(const string_view& str, const string_view& delimiter, Mode mode,
+          bool skipEmpty)
+        : str_(str),
+          delim_(delimiter),
+          ch_('\0'),
+          mode_(mode),
+          skipEmpty_(skipEmpty),
+          anyOf_{0, 0, 0, 0} {
+        if (mode_ == kAnyOf) {
+            for (char c : delim_) {
+                const auto u = static_cast<unsigned char>(c);
+                anyOf_[u >> 6] |= uint64_t(1) << (u & 63);
+            }
+        }
+    }
+
+    iterator begin() const { return iterator(this); }
+    iterator end() const { return iterator(); }
+
+private:
+    ///
+    /// @brief Position of the next delimiter at or after `pos`, or
+    ///        str_.size() with *delimLen = 0 if there is none
+    ///
+    size_t find(size_t pos, size_t* delimLen) const {
+        const char* base = str_.data();
+        const size_t n = str_.size() - pos;
+        const void* p = nullptr;
+        switch (mode_) {
+            case kChar:
+                p = n ? ::memchr(base + pos, ch_, n) : nullptr;
+                *delimLen = 1;
+                break;
+            case kSequence:
+                if (!delim_.empty() && n >= delim_.size())
+                    p = search(base + pos, n, delim_.data(), delim_.size());
+                *delimLen = delim_.size();
+                break;
+            case kAnyOf:
+                for (size_t i = pos; i < str_.size(); ++i) {
+                    const auto u = static_cast<unsigned char>(base[i]);
+                    if (anyOf_[u >> 6] >> (u & 63) & 1) {
+                        p = base + i;
+                        break;
+                    }
+                }
+                *delimLen = 1;
+                break;
+        }
+        if (p == nullptr) {
+            *delimLen = 0;
+            return str_.size();
+        }
+        return static_cast<size_t>(static_cast<const char*>(p) - base);
+    }
+
+    string_view str_;
+    string_view delim_;
+    char ch_;
+    Mode mode_;
+    bool skipEmpty_;
+    /// kAnyOf: bit set of the delimiter characters
+    uint64_t anyOf_[4];
+};
+
+///
+/// @brief Pieces between each `delimiter`, empty ones included.
+///        An empty `str` gives one empty piece.
+///
+inline Split split(const string_view& str, char delimiter) {
+    return Split(str, delimiter, false);
+}
+
+/// @brief Split on a multi-character delimiter, e.g. ", " or "\r\n"
+inline Split split(const string_view& str, const string_view& delimiter) {
+    return Split(str, delimiter, Split::kSequence, false);
+}
+
+///
+/// @brief Non-empty runs of characters not in `delimiters`
+///
+inline Split tokenize(const string_view& str,
+                      const string_view& delimiters = " \t\n\r\f\v") {
+    return Split(str, delimiters, Split::kAnyOf, true);
+}
+
+}  // namespace Lute
@@ -0,0 +1,70 @@
+///
+/// @brief Stack traces captured as raw program counters, symbolized on demand
+/// @note capture() only records return addresses, without malloc or
+///       dladdr, so it is cheap enough for every throw. toString() resolves
+///       them with dladdr + __cxa_demangle through an LRU cache of resolved
+///       addresses shared by all threads.
+///       writeSignalSafe() is for crash handlers: it captures and writes
+///       `#N 0xpc module+0xoffset` lines with write(2) only. Call
+///       prepareSignalSafe() when installing the handler, it loads the
+///       unwinder and snapshots the loaded modules.
+/// @usage
+///     Lute::StackTrace trace = Lute::StackTrace::capture();
+///     ...
+///     std::cout << trace.toString();
+///
+///     void onCrash(int sig) {
+///         Lute::StackTrace::writeSignalSafe(STDERR_FILENO);
+///         ...
+///     }
+///
+
+#pragma once
+
+#include <cstddef>  // size_t
+#include <string>   // string
+
+namespace Lute {
+
+class StackTrace {
+public:
+    static const int kMaxFrames = 64;
+
+    StackTrace() : size_(0) {}
+
+    ///
+    /// @brief Capture the calling thread's stack, the first frame is the
+    ///        caller of capture(), `skip` more frames are dropped
+    ///
+    static StackTrace capture(int skip = 0);
+
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void* frame(int i) const { return frames_[i]; }
+
+    ///
+    /// @brief One line per frame, `module(symbol+0xoffset) [0xpc]` as
+    ///        backtrace_symbols() writes them
+    /// @param demangle - 是否进行符号解析
+    ///
+    std::string toString(bool demangle = true) const;
+
+    ///
+    /// @brief Capture and write the calling thread's stack to `fd`,
+    ///        async-signal-safe once prepareSignalSafe() was called
+    ///
+    static void writeSignalSafe(int fd, int skip = 0);
+
+    /// @brief Load the unwinder and snapshot the loaded modules
+    static void prepareSignalSafe();
+
+    /// @brief Resolved addresses kept by toString(), 1024 by default
+    static void setSymbolCacheCapacity(size_t capacity);
+    static size_t symbolCacheSize();
+
+private:
+    int size_;
+    void* frames_[kMaxFrames];
+};
+
+}  // namespace Lute
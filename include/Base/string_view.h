@@ -218,6 +218,7 @@ inline Lute::string_view operator""_sv(const char* str, std::size_t len) {
 }
 
 inline std::ostream& operator<<(std::ostream& os, const Lute::string_view& sv) {
-    os << sv.data();
+    /// a view isn't necessarily null-terminated (e.g. trimView)
+    os.write(sv.data(), static_cast<std::streamsize>(sv.size()));
     return os;
 }
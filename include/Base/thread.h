@@ -6,12 +6,12 @@
 
 #pragma once
 
-#include <Base/countDownLatch.h>  // CountDownLatch
-#include <pthread.h>              // pthread_t
+#include <Base/function.h>  // UniqueFunction
+#include <pthread.h>        // pthread_t
 
 #include <atomic>
-#include <functional>  // function
 #include <memory>
+#include <string>
 
 namespace Lute {
 /**
@@ -21,7 +21,8 @@ namespace Lute {
  */
 class Thread {
 public:
-    using ThreadFunc = std::function<void()>;
+    /// move-only, captures up to 32 bytes are stored without allocating
+    using ThreadFunc = UniqueFunction<void()>;
 
     // noncopyable
     Thread(const Thread&) = delete;
@@ -39,7 +40,8 @@ public:
     // pthread_t
     // pthreadId() const { return pthreadId_; }
 
-    pid_t tid() const { return tid_; }
+    /// @brief Blocks until the started thread has published its tid
+    pid_t tid() const;
 
     const std::string& name() const { return name_; }
 
@@ -52,12 +54,12 @@ private:
     /* pthread_t 不适合做程序中对线程的标识符, 只在进程内具有唯一性 */
     pthread_t pthreadId_;
     // 在操纵系统内具有全局唯一性，采用递增轮回法进行分配
-    pid_t tid_;
+    // 由新线程写入，与其共享，Thread 先析构也无妨
+    std::shared_ptr<std::atomic<pid_t>> tid_;
 
     // 线程函数
     ThreadFunc func_;
     std::string name_;
-    Lute::CountDownLatch latch_;
 
     // 用于线程池
     static std::atomic_int32_t numCreated_;
@@ -0,0 +1,106 @@
+///
+/// @brief Scoped tracing spans, exported as Chrome trace_event JSON
+///        (load the file in chrome://tracing or https://ui.perfetto.dev)
+/// @note Each span records begin / end with the TSC into a lock-free ring
+///       owned by the calling thread; a background thread drains the rings
+///       into the trace file. Names must have static storage (literals).
+///   - Compile time: define LUTE_TRACE_DISABLE and LUTE_TRACE_SCOPE expands
+///     to nothing.
+///   - Run time: while tracing is stopped a scope costs one relaxed load.
+/// @usage
+///     Lute::trace::start("trace.json");
+///     {
+///         LUTE_TRACE_SCOPE("flush");
+///         ...
+///     }
+///     Lute::trace::stop();
+///
+
+#pragma once
+
+#include <time.h>  // clock_gettime
+
+#include <atomic>   // atomic
+#include <cstdint>  // uint64_t
+#include <string>   // string
+
+namespace Lute {
+namespace trace {
+    namespace detail {
+        extern std::atomic<bool> g_enabled;
+
+        /// @brief Append a complete event to the calling thread's ring
+        void record(const char* name, uint64_t begin, uint64_t end);
+    }  // namespace detail
+
+    ///
+    /// @brief Timestamp counter ticks. rdtsc / cntvct_el0 where available,
+    ///        CLOCK_MONOTONIC nanoseconds otherwise. Converted to
+    ///        microseconds when the trace is written.
+    ///
+    inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+        uint64_t v;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+        return v;
+#else
+        struct timespec ts {};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 +
+               static_cast<uint64_t>(ts.tv_nsec);
+#endif
+    }
+
+    inline bool enabled() {
+        return detail::g_enabled.load(std::memory_order_relaxed);
+    }
+
+    ///
+    /// @brief Start tracing into `filename`, draining the per-thread rings
+    ///        every `flushInterval` seconds.
+    /// @return false if the file can't be opened or tracing already runs
+    ///
+    bool start(const std::string& filename, double flushInterval = 0.5);
+
+    /// @brief Stop tracing, drain every ring and close the JSON document
+    void stop();
+
+    /// @brief Events lost because a ring was full, since `start()`
+    uint64_t droppedEvents();
+
+    ///
+    /// @brief RAII span: begin at construction, end at destruction
+    ///
+    class Scope {
+    public:
+        /// non-copyable
+        Scope(const Scope&) = delete;
+        Scope& operator=(Scope&) = delete;
+
+        explicit Scope(const char* name)
+            : name_(name), begin_(enabled() ? ticks() : 0) {}
+
+        ~Scope() {
+            if (begin_ != 0) detail::record(name_, begin_, ticks());
+        }
+
+    private:
+        const char* name_;
+        uint64_t begin_;
+    };
+}  // namespace trace
+}  // namespace Lute
+
+#define LUTE_TRACE_CONCAT_IMPL(a, b) a##b
+#define LUTE_TRACE_CONCAT(a, b) LUTE_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef LUTE_TRACE_DISABLE
+#define LUTE_TRACE_SCOPE(name) \
+    do {                       \
+    } while (0)
+#else
+#define LUTE_TRACE_SCOPE(name) \
+    Lute::trace::Scope LUTE_TRACE_CONCAT(luteTraceScope_, __LINE__)(name)
+#endif
@@ -3,6 +3,8 @@
  *   - PING PONG
  *   - toUpper
  *   - toLower
+ *   - trim
+ *   - replace
  */
 
 #pragma once
@@ -90,11 +92,19 @@ inline void memZero(void* S, size_t N) { ::memset(S, 0, N); }
 std::string toUpper(const std::string& str);
 /// @brief transform str to uppercase
 void toUpper(std::string& str);
+/// @brief uppercase `str` into `buf` (at least str.size() bytes)
+string_view toUpper(const string_view& str, char* buf);
+/// @brief uppercase n bytes of src into dst, dst may be src
+void toUpper(char* dst, const char* src, size_t n);
 
 /// @brief transform str to lowercase and return a new string
 std::string toLower(const std::string& str);
 /// @brief transform str to lowercase
 void toLower(std::string& str);
+/// @brief lowercase `str` into `buf` (at least str.size() bytes)
+string_view toLower(const string_view& str, char* buf);
+/// @brief lowercase n bytes of src into dst, dst may be src
+void toLower(char* dst, const char* src, size_t n);
 
 ///
 /// @brief Delete the First and Last " \t\n\r\f\v" in `str`.
@@ -103,14 +113,29 @@ void trim(std::string& str,
           const string_view& whitespaceDelimiters = " \t\n\r\f\v");
 
 ///
-/// @brief In src, replace all target with dst
+/// @brief Non-mutating trim, the result points into `str`
+///
+string_view trimView(const string_view& str,
+                     const string_view& whitespaceDelimiters = " \t\n\r\f\v");
+
+///
+/// @brief First occurrence of needle[0, m) in haystack[0, n), nullptr if
+///        none. Embedded '\0' is fine. Linear in the worst case.
+///
+const char* search(const char* haystack, size_t n, const char* needle,
+                   size_t m);
+
+///
+/// @brief In src, replace all target with dst, left to right without
+///        overlapping. Linear in src.size(), allocates at most once.
 /// @example std::string str = "LutePolaris";
 ///          Lute::replace(str, "is", "RIS"); // LutePolarRIS
 void replace(std::string& src, const string_view& target,
              const string_view& dst);
 
 #define seed 42
-static std::mt19937 __gen(seed);
+/// one generator per thread, a shared one would be a data race
+static thread_local std::mt19937 __gen(seed);
 #undef seed
 ///
 /// @brief mt19937 + uniform_distribution (均匀分布)
@@ -120,6 +145,7 @@ static std::mt19937 __gen(seed);
 ///        randomUniform<int, 1>() \n
 ///        randomUniform<int, 1, 100>() \n
 ///        randomUniform<float, 1, 100>() ...
+/// @note See Base/random.h for faster generators in hot paths
 ///
 template <typename T = uint32_t, int minv = 1, int maxv = 10>
 inline T randomUniform() {
@@ -140,6 +166,9 @@ inline T randomUniform() {
     }
 };
 
+/// @brief Buffer size for formatSI / formatIEC, fits INT64_MIN
+const size_t kFormatUnitsSize = 24;
+
 ///
 /// @brief Format a number with 5 characters, including SI units.
 ///   [0,     999]
@@ -149,6 +178,7 @@ inline T randomUniform() {
 ///   [1.00T, 999T]
 ///   [1.00P, 999P]
 ///   [1.00E, inf)
+/// @note Negative numbers are printed in full.
 ///
 std::string formatSI(int64_t s);
 
@@ -162,6 +192,31 @@ std::string formatSI(int64_t s);
 ///
 std::string formatIEC(int64_t s);
 
+///
+/// @brief formatSI / formatIEC into `buf` (kFormatUnitsSize bytes), no
+///        allocation. Null-terminated.
+/// @return size_t Valid length of buf
+///
+size_t formatSI(char* buf, int64_t s);
+size_t formatIEC(char* buf, int64_t s);
+
+///
+/// @brief Parse "1500", "1.5k", "2M", "1.5Gi", "64 MiB", ... into `*value`.
+///   - parseSI: k/K M G T P E are powers of 1000
+///   - parseIEC: they are powers of 1024, e.g. "512M" for a log roll size
+///   With an 'i' (Ki Mi Gi ...) both use 1024; a trailing 'B' is ignored.
+///   Fractions are rounded half up to an integer.
+/// @return false on malformed input or overflow, `*value` is untouched
+///
+bool parseSI(const string_view& str, int64_t* value);
+bool parseIEC(const string_view& str, int64_t* value);
+
+///
+/// @brief Append `str` as the inside of a JSON string: `"`, `\` and the
+///        control characters below 0x20 are escaped
+///
+void appendJsonEscaped(std::string* out, const string_view& str);
+
 ///
 /// @brief Efficient Integer to String Conversions, by Matthew Wilson.
 /// @param buf Dst buffer
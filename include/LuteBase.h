@@ -1,21 +1,37 @@
 #pragma once
 
 #include <Base/MTQueue.h>
+#include <Base/ahoCorasick.h>
 #include <Base/any.h>
+#include <Base/arena.h>
 #include <Base/atomic.h>
+#include <Base/benchmark.h>
 #include <Base/bytearray.h>
+#include <Base/concurrentHashMap.h>
 #include <Base/condition_variable.h>
 #include <Base/countDownLatch.h>
 #include <Base/currentThread.h>
 #include <Base/endian.h>
+#include <Base/epoch.h>
 #include <Base/exception.h>
 #include <Base/fsUtils.h>
+#include <Base/function.h>
 #include <Base/ini_config.h>
 #include <Base/logger.h>
 #include <Base/mallochook.h>
+#include <Base/metrics.h>
 #include <Base/mutex.h>
+#include <Base/perCpu.h>
+#include <Base/pinyinDict.h>
+#include <Base/pinyinParser.h>
+#include <Base/random.h>
+#include <Base/resourceSampler.h>
+#include <Base/shmLogRing.h>
 #include <Base/singleton.h>
+#include <Base/split.h>
+#include <Base/stackTrace.h>
 #include <Base/string_view.h>
 #include <Base/thread.h>
 #include <Base/timestamp.h>
+#include <Base/trace.h>
 #include <Base/utils.h>
@@ -0,0 +1,143 @@
+#include <Base/ahoCorasick.h>
+
+#include <cstring>  // memset
+#include <queue>    // queue
+
+namespace Lute {
+
+AhoCorasick::AhoCorasick(const Rules& rules)
+    : rules_(rules), classes_(1), firstByte_(-1) {
+    ::memset(classOf_, 0, sizeof classOf_);
+    for (const auto& rule : rules_) {
+        for (char c : rule.first) {
+            uint8_t& cls = classOf_[static_cast<uint8_t>(c)];
+            if (cls == 0) cls = static_cast<uint8_t>(classes_++);
+        }
+    }
+    /// Patterns using all 256 bytes leave no spare class 0, give every
+    /// byte its own column instead
+    if (classes_ > 256) {
+        for (int i = 0; i < 256; ++i) classOf_[i] = static_cast<uint8_t>(i);
+        classes_ = 256;
+    }
+
+    /// trie, -1 = no edge yet
+    next_.assign(classes_, -1);
+    depth_.push_back(0);
+    output_.push_back(-1);
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        const std::string& pattern = rules_[i].first;
+        if (pattern.empty()) continue;
+        int32_t state = 0;
+        for (char c : pattern) {
+            const size_t edge = static_cast<size_t>(state) * classes_ +
+                                classOf_[static_cast<uint8_t>(c)];
+            if (next_[edge] < 0) {
+                next_[edge] = static_cast<int32_t>(depth_.size());
+                next_.resize(next_.size() + classes_, -1);
+                depth_.push_back(depth_[static_cast<size_t>(state)] + 1);
+                output_.push_back(-1);
+            }
+            state = next_[edge];
+        }
+        const int first = static_cast<uint8_t>(pattern[0]);
+        if (firstByte_ == -1)
+            firstByte_ = first;
+        else if (firstByte_ != first)
+            firstByte_ = -2;
+
+        int32_t& out = output_[static_cast<size_t>(state)];
+        if (out < 0) out = static_cast<int32_t>(i);
+    }
+
+    if (firstByte_ < 0) firstByte_ = -1;
+
+    /// BFS: turn the trie into a DFA, a missing edge goes where the
+    /// failure link's edge goes
+    std::vector<int32_t> fail(depth_.size(), 0);
+    std::queue<int32_t> queue;
+    for (size_t c = 0; c < classes_; ++c) {
+        int32_t& to = next_[c];
+        if (to < 0) {
+            to = 0;
+        } else {
+            fail[static_cast<size_t>(to)] = 0;
+            queue.push(to);
+        }
+    }
+    while (!queue.empty()) {
+        const auto state = static_cast<size_t>(queue.front());
+        queue.pop();
+        const auto f = static_cast<size_t>(fail[state]);
+        if (output_[state] < 0) output_[state] = output_[f];
+        for (size_t c = 0; c < classes_; ++c) {
+            int32_t& to = next_[state * classes_ + c];
+            if (to < 0) {
+                to = next_[f * classes_ + c];
+            } else {
+                fail[static_cast<size_t>(to)] = next_[f * classes_ + c];
+                queue.push(to);
+            }
+        }
+    }
+}
+
+AhoCorasick::Match AhoCorasick::find(const string_view& text,
+                                     size_t pos) const {
+    Match best = {0, 0, -1};
+    const char* data = text.data();
+    int32_t state = 0;
+    for (size_t i = pos; i < text.size(); ++i) {
+        if (state == 0 && firstByte_ >= 0) {
+            /// every pattern starts with the same byte, e.g. "${"
+            const void* p = ::memchr(data + i, firstByte_, text.size() - i);
+            if (p == nullptr) break;
+            i = static_cast<size_t>(static_cast<const char*>(p) - data);
+        }
+        state = step(state, data[i]);
+        const auto s = static_cast<size_t>(state);
+        const int32_t out = output_[s];
+        if (best.found()) {
+            /// every match still to come starts at or after this
+            const size_t earliest = i + 1 - static_cast<size_t>(depth_[s]);
+            if (earliest > best.start) return best;
+        } else if (out < 0) {
+            continue;
+        }
+
+        if (out >= 0) {
+            const size_t length = rules_[static_cast<size_t>(out)].first.size();
+            const size_t start = i + 1 - length;
+            if (!best.found() || start < best.start ||
+                (start == best.start && length > best.length))
+                best = {start, length, out};
+        }
+    }
+    return best;
+}
+
+size_t AhoCorasick::count(const string_view& text) const {
+    size_t n = 0;
+    for (Match m = find(text); m.found(); m = find(text, m.start + m.length))
+        ++n;
+    return n;
+}
+
+void AhoCorasick::replace(const string_view& text, std::string* out) const {
+    size_t pos = 0;
+    for (Match m = find(text); m.found(); m = find(text, pos)) {
+        out->append(text.data() + pos, m.start - pos);
+        out->append(rules_[static_cast<size_t>(m.index)].second);
+        pos = m.start + m.length;
+    }
+    out->append(text.data() + pos, text.size() - pos);
+}
+
+std::string AhoCorasick::replace(const string_view& text) const {
+    std::string out;
+    out.reserve(text.size());
+    replace(text, &out);
+    return out;
+}
+
+}  // namespace Lute
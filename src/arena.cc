@@ -0,0 +1,300 @@
+#include <Base/arena.h>
+#include <Base/mutex.h>  // MutexLock
+
+#include <algorithm>  // max
+#include <atomic>     // atomic
+
+namespace Lute {
+
+/// NOTE ----------- Arena -----------
+
+Arena::Arena(size_t blockSize)
+    : blockSize_(std::max<size_t>(blockSize, 256)),
+      ptr_(nullptr),
+      end_(nullptr),
+      current_(0),
+      allocated_(0),
+      reserved_(0) {
+    blocks_.push_back({static_cast<char*>(::operator new(blockSize_)),
+                       blockSize_});
+    reserved_ += blockSize_;
+    setBlock(blocks_[0]);
+}
+
+void* Arena::allocateSlow(size_t size, size_t align) {
+    if (size + align > blockSize_ / 4) {
+        /// a block of its own, so the tail of the current one isn't wasted
+        const size_t n = size + align;
+        Block block{static_cast<char*>(::operator new(n)), n};
+        large_.push_back(block);
+        reserved_ += n;
+        allocated_ += size;
+        const uintptr_t p =
+            (reinterpret_cast<uintptr_t>(block.data) + align - 1) &
+            ~static_cast<uintptr_t>(align - 1);
+        return reinterpret_cast<void*>(p);
+    }
+
+    /// fits in any empty block: reuse the next one kept by reset()
+    if (current_ + 1 < blocks_.size()) {
+        ++current_;
+    } else {
+        blocks_.push_back({static_cast<char*>(::operator new(blockSize_)),
+                           blockSize_});
+        reserved_ += blockSize_;
+        current_ = blocks_.size() - 1;
+    }
+    setBlock(blocks_[current_]);
+    return allocate(size, align);
+}
+
+void Arena::reset() {
+    for (const Block& block : large_) {
+        ::operator delete(block.data);
+        reserved_ -= block.size;
+    }
+    large_.clear();
+    allocated_ = 0;
+    current_ = 0;
+    if (blocks_.empty()) {
+        ptr_ = end_ = nullptr;
+    } else {
+        setBlock(blocks_[0]);
+    }
+}
+
+void Arena::release() {
+    reset();
+    for (const Block& block : blocks_) ::operator delete(block.data);
+    blocks_.clear();
+    ptr_ = end_ = nullptr;
+    reserved_ = 0;
+}
+
+/// NOTE ----------- ThreadCachePool -----------
+
+namespace {
+    /// 16 .. 128 in steps of 16, then 4 classes per power of 2 up to 32K
+    const size_t kNumClasses = 40;
+    /// Memory is taken from the system in spans of at least this size
+    const size_t kSpanBytes = 64 * 1024;
+
+    inline size_t classIndex(size_t size) {
+        if (size <= 128) return size ? (size + 15) / 16 - 1 : 0;
+        const int log = 63 - __builtin_clzll(size - 1);
+        return 8 + static_cast<size_t>(log - 7) * 4 +
+               ((size - 1) >> (log - 2)) - 4;
+    }
+
+    struct SizeClassTable {
+        /// object size of each class
+        uint32_t size[kNumClasses];
+        /// objects moved at once between a thread cache and the central
+        /// list, a thread cache holds at most 2 batches per class
+        uint32_t batch[kNumClasses];
+
+        constexpr SizeClassTable() : size(), batch() {
+            for (size_t i = 0; i < kNumClasses; ++i) {
+                if (i < 8) {
+                    size[i] = static_cast<uint32_t>(16 * (i + 1));
+                } else {
+                    const uint32_t base = 128u << ((i - 8) / 4);
+                    const uint32_t step = static_cast<uint32_t>((i - 8) % 4);
+                    size[i] = base + (step + 1) * base / 4;
+                }
+                const uint32_t n = 16384 / size[i];
+                batch[i] = n < 2 ? 2 : (n > 64 ? 64 : n);
+            }
+        }
+    };
+    constexpr SizeClassTable kClasses;
+
+    static_assert(kClasses.size[kNumClasses - 1] == ThreadCachePool::kMaxSize,
+                  "size classes must cover kMaxSize");
+
+    struct FreeObject {
+        FreeObject* next;
+    };
+
+    struct FreeList {
+        FreeObject* head;
+        uint32_t count;
+    };
+
+    struct alignas(64) CentralList {
+        MutexLock mutex;
+        FreeObject* head GUARDED_BY(mutex) = nullptr;
+    };
+
+    /// Leaked, so objects can still be freed by static / thread_local
+    /// destructors that run after this translation unit's statics
+    CentralList* central() {
+        static CentralList* lists = new CentralList[kNumClasses];
+        return lists;
+    }
+
+    std::atomic<size_t> g_reserved(0);
+
+    enum ThreadState { kUnregistered, kActive, kExited };
+
+    /// initial-exec: a plain %fs-relative access instead of a
+    /// __tls_get_addr call on every allocation from the shared library
+    __thread FreeList t_lists[kNumClasses]
+        __attribute__((tls_model("initial-exec")));
+    __thread int t_state __attribute__((tls_model("initial-exec"))) =
+        kUnregistered;
+
+    /// Returns the thread's cached objects when the thread exits
+    struct ThreadCacheReaper {
+        bool armed = false;
+        ~ThreadCacheReaper() {
+            ThreadCachePool::flushThreadCache();
+            t_state = kExited;
+        }
+    };
+    thread_local ThreadCacheReaper t_reaper;
+
+    void registerThread() {
+        t_reaper.armed = true;
+        t_state = kActive;
+    }
+
+    void fetchFromCentral(size_t cls, FreeList* list) {
+        const size_t size = kClasses.size[cls];
+        const uint32_t batch = kClasses.batch[cls];
+        CentralList& c = central()[cls];
+
+        FreeObject* head;
+        uint32_t n = 1;
+        {
+            MutexLockGuard lock(c.mutex);
+            if (c.head == nullptr) {
+                const size_t span = std::max(kSpanBytes, size * batch);
+                char* mem = static_cast<char*>(::operator new(span));
+                g_reserved.fetch_add(span, std::memory_order_relaxed);
+                for (size_t off = span / size * size; off != 0; off -= size) {
+                    FreeObject* obj =
+                        reinterpret_cast<FreeObject*>(mem + off - size);
+                    obj->next = c.head;
+                    c.head = obj;
+                }
+            }
+            FreeObject* tail = c.head;
+            for (; n < batch && tail->next; ++n) tail = tail->next;
+            head = c.head;
+            c.head = tail->next;
+            tail->next = list->head;
+        }
+        list->head = head;
+        list->count += n;
+    }
+
+    void releaseToCentral(size_t cls, FreeList* list, uint32_t n) {
+        if (n == 0) return;
+        FreeObject* head = list->head;
+        FreeObject* tail = head;
+        for (uint32_t i = 1; i < n; ++i) tail = tail->next;
+        list->head = tail->next;
+        list->count -= n;
+
+        CentralList& c = central()[cls];
+        MutexLockGuard lock(c.mutex);
+        tail->next = c.head;
+        c.head = head;
+    }
+
+    __attribute__((noinline)) void* allocateSlow(size_t cls) {
+        if (t_state == kUnregistered) registerThread();
+        FreeList& list = t_lists[cls];
+        fetchFromCentral(cls, &list);
+        FreeObject* obj = list.head;
+        list.head = obj->next;
+        --list.count;
+        /// the reaper already ran, don't strand objects in a dead cache
+        if (t_state == kExited) releaseToCentral(cls, &list, list.count);
+        return obj;
+    }
+
+    __attribute__((noinline)) void deallocateSlow(size_t cls, void* p) {
+        if (t_state == kUnregistered) registerThread();
+        FreeList& list = t_lists[cls];
+        FreeObject* obj = static_cast<FreeObject*>(p);
+        obj->next = list.head;
+        list.head = obj;
+        ++list.count;
+        if (t_state == kExited) {
+            releaseToCentral(cls, &list, list.count);
+        } else if (list.count >= 2 * kClasses.batch[cls]) {
+            releaseToCentral(cls, &list, kClasses.batch[cls]);
+        }
+    }
+}  // namespace
+
+void* ThreadCachePool::allocate(size_t size) {
+    if (__builtin_expect(size > kMaxSize, 0)) return ::operator new(size);
+    const size_t cls = classIndex(size);
+    FreeList& list = t_lists[cls];
+    FreeObject* obj = list.head;
+    if (__builtin_expect(obj != nullptr, 1)) {
+        list.head = obj->next;
+        --list.count;
+        return obj;
+    }
+    return allocateSlow(cls);
+}
+
+void ThreadCachePool::deallocate(void* p, size_t size) {
+    if (p == nullptr) return;
+    if (__builtin_expect(size > kMaxSize, 0)) {
+        ::operator delete(p);
+        return;
+    }
+    const size_t cls = classIndex(size);
+    FreeList& list = t_lists[cls];
+    if (__builtin_expect(
+            list.count + 1 < 2 * kClasses.batch[cls] && t_state == kActive,
+            1)) {
+        FreeObject* obj = static_cast<FreeObject*>(p);
+        obj->next = list.head;
+        list.head = obj;
+        ++list.count;
+        return;
+    }
+    deallocateSlow(cls, p);
+}
+
+size_t ThreadCachePool::roundUp(size_t size) {
+    return size > kMaxSize ? size : kClasses.size[classIndex(size)];
+}
+
+void ThreadCachePool::flushThreadCache() {
+    for (size_t cls = 0; cls < kNumClasses; ++cls)
+        releaseToCentral(cls, &t_lists[cls], t_lists[cls].count);
+}
+
+size_t ThreadCachePool::reservedBytes() {
+    return g_reserved.load(std::memory_order_relaxed);
+}
+
+/// NOTE ----------- PoolResource -----------
+
+PoolResource* PoolResource::instance() {
+    static PoolResource* resource = new PoolResource;
+    return resource;
+}
+
+void* PoolResource::do_allocate(size_t bytes, size_t align) {
+    if (align > ThreadCachePool::kAlignment)
+        return ::operator new(bytes, std::align_val_t(align));
+    return ThreadCachePool::allocate(bytes);
+}
+
+void PoolResource::do_deallocate(void* p, size_t bytes, size_t align) {
+    if (align > ThreadCachePool::kAlignment) {
+        ::operator delete(p, std::align_val_t(align));
+        return;
+    }
+    ThreadCachePool::deallocate(p, bytes);
+}
+
+}  // namespace Lute
@@ -0,0 +1,394 @@
+#include <Base/benchmark.h>
+#include <Base/timestamp.h>    // Timestamp
+#include <Base/utils.h>        // ProcessInfo formatIEC appendJsonEscaped
+#include <linux/perf_event.h>  // perf_event_attr
+#include <sys/ioctl.h>         // ioctl
+#include <sys/syscall.h>       // __NR_perf_event_open
+#include <unistd.h>            // syscall close read sysconf
+
+#include <algorithm>  // sort
+#include <cmath>      // sqrt
+#include <cstdio>     // printf FILE
+#include <cstdlib>    // atof atoi
+#include <cstring>    // strncmp strstr
+#include <ctime>      // clock_gettime
+#include <string>     // string
+#include <vector>     // vector
+
+namespace Lute {
+namespace bench {
+    namespace detail {
+        int64_t nowNanos() {
+            struct timespec ts {};
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        struct Benchmark {
+            std::string name;
+            Function func;
+            int64_t arg;
+        };
+
+        /// Function-local, so static registrars in any TU can use it
+        std::vector<Benchmark>& benchmarks() {
+            static std::vector<Benchmark> v;
+            return v;
+        }
+
+        struct Result {
+            std::string name;
+            int64_t iterations;
+            int samples;
+            double mean;  // ns per iteration
+            double stddev;
+            double min;
+            double p50;
+            double p90;
+            double p99;
+            double bytesPerSecond;  // 0 if not set
+            double counters[State::kMaxCounters];  // per iteration, <0 = n/a
+        };
+
+        /// @brief Nearest-rank percentile of sorted values
+        double percentile(const std::vector<double>& sorted, double q) {
+            if (sorted.empty()) return 0.0;
+            auto rank = static_cast<size_t>(
+                std::ceil(q * static_cast<double>(sorted.size())));
+            if (rank == 0) rank = 1;
+            return sorted[std::min(rank, sorted.size()) - 1];
+        }
+    }  // namespace detail
+
+    ///
+    /// @brief Hardware counters of the calling thread (user space only),
+    ///        each opened independently so that missing ones are skipped.
+    ///
+    class PerfCounters {
+    public:
+        /// non-copyable
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(PerfCounters&) = delete;
+
+        explicit PerfCounters(bool enable) {
+            static const uint64_t kConfigs[State::kMaxCounters] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES,
+            };
+            for (int i = 0; i < State::kMaxCounters; ++i) {
+                fds_[i] = enable ? open(kConfigs[i]) : -1;
+            }
+        }
+
+        ~PerfCounters() {
+            for (int fd : fds_) {
+                if (fd >= 0) ::close(fd);
+            }
+        }
+
+        bool available(int i) const { return fds_[i] >= 0; }
+        bool anyAvailable() const {
+            for (int i = 0; i < State::kMaxCounters; ++i) {
+                if (available(i)) return true;
+            }
+            return false;
+        }
+
+        void start() {
+            for (int fd : fds_) {
+                if (fd >= 0) {
+                    ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+
+        /// @brief Disable and add the counts since `start()` to `values`
+        void stop(uint64_t* values) {
+            for (int i = 0; i < State::kMaxCounters; ++i) {
+                if (fds_[i] < 0) continue;
+                ::ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+                uint64_t v = 0;
+                if (::read(fds_[i], &v, sizeof v) == sizeof v) values[i] += v;
+            }
+        }
+
+        static const char* name(int i) {
+            static const char* kNames[State::kMaxCounters] = {
+                "cycles",
+                "instructions",
+                "cache_misses",
+            };
+            return kNames[i];
+        }
+
+    private:
+        static int open(uint64_t config) {
+            struct perf_event_attr attr {};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof attr;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(
+                ::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        int fds_[State::kMaxCounters];
+    };
+
+}  // namespace bench
+}  // namespace Lute
+
+/// NOTE ----------- State -----------
+Lute::bench::State::State(int64_t iterations, int64_t arg,
+                          PerfCounters* counters)
+    : iterations_(iterations),
+      arg_(arg),
+      remaining_(0),
+      started_(false),
+      finished_(false),
+      startNanos_(0),
+      elapsedNanos_(0),
+      bytes_(0),
+      counters_(counters),
+      counterValues_() {}
+
+bool Lute::bench::State::startOrStop() {
+    if (!started_) {
+        started_ = true;
+        remaining_ = iterations_ - 1;
+        resumeTiming();
+        return iterations_ > 0;
+    }
+    if (!finished_) {
+        finished_ = true;
+        pauseTiming();
+    }
+    return false;
+}
+
+void Lute::bench::State::pauseTiming() {
+    const int64_t now = detail::nowNanos();
+    if (counters_) counters_->stop(counterValues_);
+    elapsedNanos_ += now - startNanos_;
+}
+
+void Lute::bench::State::resumeTiming() {
+    if (counters_) counters_->start();
+    startNanos_ = detail::nowNanos();
+}
+
+/// NOTE ----------- Runner -----------
+int Lute::bench::registerBenchmark(const std::string& name, Function func,
+                                   int64_t arg) {
+    detail::benchmarks().push_back({name, std::move(func), arg});
+    return static_cast<int>(detail::benchmarks().size());
+}
+
+namespace {
+using Lute::bench::PerfCounters;
+using Lute::bench::State;
+using Lute::bench::detail::Benchmark;
+using Lute::bench::detail::Result;
+
+struct Options {
+    std::string filter;
+    double minTime = 0.01;
+    int samples = 20;
+    std::string json;
+    bool perf = true;
+};
+
+Options parseOptions(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (::strncmp(a, "--filter=", 9) == 0) {
+            opts.filter = a + 9;
+        } else if (::strncmp(a, "--min_time=", 11) == 0) {
+            opts.minTime = ::atof(a + 11);
+        } else if (::strncmp(a, "--samples=", 10) == 0) {
+            opts.samples = std::max(1, ::atoi(a + 10));
+        } else if (::strncmp(a, "--json=", 7) == 0) {
+            opts.json = a + 7;
+        } else if (::strcmp(a, "--no_perf") == 0) {
+            opts.perf = false;
+        } else {
+            ::fprintf(stderr, "unknown option: %s\n", a);
+        }
+    }
+    return opts;
+}
+
+/// @brief Grow the iteration count until one run lasts `minTime`
+int64_t scaleIterations(const Benchmark& bm, double minTime) {
+    const auto target = static_cast<int64_t>(minTime * 1e9);
+    int64_t n = 1;
+    for (;;) {
+        State state(n, bm.arg, nullptr);
+        bm.func(state);
+        const int64_t elapsed = std::max<int64_t>(state.elapsedNanos(), 1);
+        if (elapsed >= target || n >= 1000000000) return n;
+        /// aim 40% past the target, grow by [2, 100]x per step
+        double factor = 1.4 * static_cast<double>(target) /
+                        static_cast<double>(elapsed);
+        factor = std::min(std::max(factor, 2.0), 100.0);
+        n = static_cast<int64_t>(static_cast<double>(n) * factor);
+    }
+}
+
+Result runOne(const Benchmark& bm, const Options& opts,
+              PerfCounters* counters) {
+    /// scaling doubles as warmup, plus one discarded run
+    const int64_t n = scaleIterations(bm, opts.minTime);
+    {
+        State warm(n, bm.arg, nullptr);
+        bm.func(warm);
+    }
+
+    Result r{};
+    r.name = bm.name;
+    r.iterations = n;
+    r.samples = opts.samples;
+
+    std::vector<double> nsPerIter;
+    nsPerIter.reserve(static_cast<size_t>(opts.samples));
+    uint64_t totals[State::kMaxCounters] = {};
+    int64_t totalBytes = 0;
+    int64_t totalNanos = 0;
+    for (int s = 0; s < opts.samples; ++s) {
+        State state(n, bm.arg, counters);
+        bm.func(state);
+        nsPerIter.push_back(static_cast<double>(state.elapsedNanos()) /
+                            static_cast<double>(n));
+        for (int i = 0; i < State::kMaxCounters; ++i)
+            totals[i] += state.counterValues()[i];
+        totalBytes += state.bytesProcessed();
+        totalNanos += state.elapsedNanos();
+    }
+
+    double sum = 0.0;
+    for (double v : nsPerIter) sum += v;
+    r.mean = sum / static_cast<double>(nsPerIter.size());
+    double sq = 0.0;
+    for (double v : nsPerIter) sq += (v - r.mean) * (v - r.mean);
+    r.stddev = nsPerIter.size() > 1
+                   ? std::sqrt(sq / static_cast<double>(nsPerIter.size() - 1))
+                   : 0.0;
+    std::sort(nsPerIter.begin(), nsPerIter.end());
+    r.min = nsPerIter.front();
+    r.p50 = Lute::bench::detail::percentile(nsPerIter, 0.5);
+    r.p90 = Lute::bench::detail::percentile(nsPerIter, 0.9);
+    r.p99 = Lute::bench::detail::percentile(nsPerIter, 0.99);
+    r.bytesPerSecond = totalNanos > 0 ? static_cast<double>(totalBytes) * 1e9 /
+                                            static_cast<double>(totalNanos)
+                                      : 0.0;
+
+    const double totalIters = static_cast<double>(n) * opts.samples;
+    for (int i = 0; i < State::kMaxCounters; ++i) {
+        r.counters[i] = counters && counters->available(i)
+                            ? static_cast<double>(totals[i]) / totalIters
+                            : -1.0;
+    }
+    return r;
+}
+
+void printHeader(bool perf) {
+    ::printf("%-40s %12s %10s %10s %10s %10s %10s", "Benchmark", "Iterations",
+             "Mean(ns)", "StdDev", "p50", "p99", "Min");
+    if (perf) {
+        for (int i = 0; i < State::kMaxCounters; ++i)
+            ::printf(" %12s", PerfCounters::name(i));
+    }
+    ::printf("\n");
+}
+
+void printResult(const Result& r, bool perf) {
+    ::printf("%-40s %12ld %10.2f %10.2f %10.2f %10.2f %10.2f", r.name.c_str(),
+             r.iterations, r.mean, r.stddev, r.p50, r.p99, r.min);
+    if (perf) {
+        for (double c : r.counters) {
+            if (c >= 0)
+                ::printf(" %12.2f", c);
+            else
+                ::printf(" %12s", "-");
+        }
+    }
+    if (r.bytesPerSecond > 0)
+        ::printf(" %sB/s", Lute::formatIEC(
+                               static_cast<int64_t>(r.bytesPerSecond))
+                               .c_str());
+    ::printf("\n");
+    ::fflush(stdout);
+}
+
+/// @brief `str` as JSON string contents
+std::string jsonEscaped(const std::string& str) {
+    std::string out;
+    Lute::appendJsonEscaped(&out, str);
+    return out;
+}
+
+void writeJson(FILE* fp, const std::vector<Result>& results) {
+    ::fprintf(fp,
+              "{\n  \"context\": {\"date\": \"%s\", \"host\": \"%s\", "
+              "\"num_cpus\": %ld, \"debug_build\": %s},\n"
+              "  \"benchmarks\": [\n",
+              Lute::Timestamp::now().toFormattedString().c_str(),
+              jsonEscaped(Lute::ProcessInfo::hostname()).c_str(),
+              ::sysconf(_SC_NPROCESSORS_ONLN),
+              Lute::ProcessInfo::isDebugBuild() ? "true" : "false");
+    for (size_t k = 0; k < results.size(); ++k) {
+        const Result& r = results[k];
+        ::fprintf(fp,
+                  "    {\"name\": \"%s\", \"iterations\": %ld, "
+                  "\"samples\": %d, \"time_unit\": \"ns\", \"mean\": %.3f, "
+                  "\"stddev\": %.3f, \"min\": %.3f, \"p50\": %.3f, "
+                  "\"p90\": %.3f, \"p99\": %.3f",
+                  jsonEscaped(r.name).c_str(), r.iterations, r.samples,
+                  r.mean, r.stddev, r.min, r.p50, r.p90, r.p99);
+        if (r.bytesPerSecond > 0)
+            ::fprintf(fp, ", \"bytes_per_second\": %.0f", r.bytesPerSecond);
+        for (int i = 0; i < State::kMaxCounters; ++i) {
+            if (r.counters[i] >= 0)
+                ::fprintf(fp, ", \"%s\": %.3f", PerfCounters::name(i),
+                          r.counters[i]);
+        }
+        ::fprintf(fp, "}%s\n", k + 1 < results.size() ? "," : "");
+    }
+    ::fprintf(fp, "  ]\n}\n");
+}
+}  // namespace
+
+int Lute::bench::runBenchmarks(int argc, char** argv) {
+    const Options opts = parseOptions(argc, argv);
+    PerfCounters counters(opts.perf);
+    const bool perf = counters.anyAvailable();
+    if (opts.perf && !perf)
+        ::fprintf(stderr, "perf_event_open unavailable, no HW counters\n");
+
+    printHeader(perf);
+    std::vector<Result> results;
+    for (const Benchmark& bm : detail::benchmarks()) {
+        if (!opts.filter.empty() &&
+            bm.name.find(opts.filter) == std::string::npos)
+            continue;
+        results.push_back(runOne(bm, opts, perf ? &counters : nullptr));
+        printResult(results.back(), perf);
+    }
+
+    if (!opts.json.empty()) {
+        FILE* fp =
+            opts.json == "-" ? stdout : ::fopen(opts.json.c_str(), "we");
+        if (fp == nullptr) {
+            ::perror("open json output");
+            return 1;
+        }
+        writeJson(fp, results);
+        if (fp != stdout) ::fclose(fp);
+    }
+    return 0;
+}
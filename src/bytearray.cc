@@ -27,23 +27,40 @@ ByteArray::Node::~Node() {
     if (nullptr != ptr_) delete[] ptr_;
 }
 
-ByteArray::ByteArray(size_t base_size)
+ByteArray::ByteArray(size_t base_size, std::pmr::memory_resource* resource)
     : baseSize_(base_size),
       position_(0),
       capacity_(base_size),
       size_(0),
       endian_(LUTE_BYTE_ORDER),
-      root_(new Node(base_size)),
-      curr_(root_) {}
+      root_(nullptr),
+      curr_(nullptr),
+      resource_(resource ? resource : std::pmr::get_default_resource()) {
+    root_ = curr_ = newNode();
+}
 
 ByteArray::~ByteArray() {
     Node* tmp = root_;
     while (nullptr != tmp) {
         curr_ = tmp;
         tmp = tmp->next_;
-        delete curr_;
+        deleteNode(curr_);
     }
 }
+
+ByteArray::Node* ByteArray::newNode() {
+    void* mem = resource_->allocate(sizeof(Node) + baseSize_, alignof(Node));
+    Node* node = new (mem) Node();
+    node->ptr_ = static_cast<char*>(mem) + sizeof(Node);
+    node->size_ = baseSize_;
+    return node;
+}
+
+void ByteArray::deleteNode(Node* node) {
+    node->ptr_ = nullptr;  // 内存块随节点一起释放
+    node->~Node();
+    resource_->deallocate(node, sizeof(Node) + baseSize_, alignof(Node));
+}
 void ByteArray::writeFint8(int8_t val) { write(&val, sizeof(val)); }
 
 void ByteArray::writeFuint8(uint8_t val) { write(&val, sizeof(val)); }
@@ -526,7 +543,7 @@ void ByteArray::clear() {
     while (nullptr != tmp) {
         curr_ = tmp;
         tmp = tmp->next_;
-        delete curr_;
+        deleteNode(curr_);
     }
     curr_ = root_;
     root_->next_ = nullptr;
@@ -545,7 +562,7 @@ void ByteArray::ensureCapacity(size_t size) {
 
     Node* first = nullptr;
     for (size_t i = 0; i < count; ++i) {
-        tmp->next_ = new Node(baseSize_);
+        tmp->next_ = newNode();
         if (first == nullptr) first = tmp->next_;
         tmp = tmp->next_;
         capacity_ += baseSize_;
@@ -13,12 +13,10 @@ bool Lute::Condition::waitForSeconds(double seconds) {
         CLOCK_MONOTONIC 时钟可能会受到时间调整的影响（例如 NTP 校时），
         CLOCK_MONOTONIC_RAW 时钟则不受影响
      */
+    /// NOTE pthread_cond_timedwait 只支持 CLOCK_REALTIME / CLOCK_MONOTONIC,
+    /// 必须与构造时 pthread_condattr_setclock 设置的时钟一致
     struct timespec abstime {};
-#ifdef CLOCK_MONOTONIC_RAW
-    ::clock_gettime(CLOCK_MONOTONIC_RAW, &abstime);
-#else
     ::clock_gettime(CLOCK_MONOTONIC, &abstime);
-#endif
 
     const int64_t kNanoSecondsPerSecond = 1E9;
     auto nanoseconds = static_cast<int64_t>(seconds * kNanoSecondsPerSecond);
@@ -1,62 +1,129 @@
 #include <Base/currentThread.h>
-#include <cxxabi.h>    // abi
-#include <execinfo.h>  // backtrace backtrace_symbols
+#include <Base/mutex.h>       // MutexLock
+#include <Base/stackTrace.h>  // StackTrace
+
+#include <type_traits>  // is_same
 
 namespace Lute {
 namespace CurrentThread {
-    __thread int t_cachedTid = 0;
-    __thread char t_tidString[32];
-    __thread int t_tidStringLength = 6;
-    __thread const char* t_threadName = "unknown";
+    __thread Context t_context __attribute__((tls_model("initial-exec"))) = {
+        0, -1, 6, "unknown", {}};
     static_assert(std::is_same<int, pid_t>::value, "pid_t should be int");
 }  // namespace CurrentThread
-}  // namespace Lute
 
-std::string Lute::CurrentThread::stackTrace(bool demangle) {
-    std::string stack;
-    const int max_frames = 200;
-    void* frame[max_frames];
-    int nptrs = ::backtrace(frame, max_frames);
-    char** strings = ::backtrace_symbols(frame, nptrs);
-    if (strings) {
-        size_t len = 256;
-        char* demangled =
-            demangle ? static_cast<char*>(::malloc(len)) : nullptr;
-
-        // skipping the 0-th, which is this function
-        for (int i = 1; i < nptrs; ++i) {
-            if (demangle) {
-                char* left_par = nullptr;
-                char* plus = nullptr;
-                for (char* p = strings[i]; *p; ++p) {
-                    if (*p == '(')
-                        left_par = p;
-                    else if (*p == '+')
-                        plus = p;
-                }
-
-                if (left_par && plus) {
-                    *plus = '\0';
-                    int status = 0;
-                    char* ret = abi::__cxa_demangle(left_par + 1, demangled,
-                                                    &len, &status);
-                    *plus = '+';
-                    if (status == 0) {
-                        demangled = ret;  // ret could be realloc()
-                        stack.append(strings[i], left_par + 1);
-                        stack.append(demangled);
-                        stack.append(plus);
-                        stack.push_back('\n');
-                        continue;
-                    }
-                }
-            }
-            // Fallback to mangled names
-            stack.append(strings[i]);
-            stack.push_back('\n');
+namespace {
+    ///
+    /// @brief Slots indexed by CurrentThread::index(), a free slot is
+    ///        nullptr. The lowest free slot is handed out first so the
+    ///        indices stay dense.
+    ///
+    struct Registry {
+        MutexLock mutex;
+        std::vector<CurrentThread::Context*> slots GUARDED_BY(mutex);
+        int live GUARDED_BY(mutex) = 0;
+    };
+
+    /// Leaked, threads may exit after static destructors ran. Replaced in
+    /// the child after fork() since the mutex may have been held.
+    Registry*& registryRef() {
+        static Registry* registry = new Registry;
+        return registry;
+    }
+
+    /// Takes the thread out of the registry when it exits
+    struct Deregistrar {
+        bool armed = false;
+        ~Deregistrar() {
+            CurrentThread::Context& ctx = CurrentThread::t_context;
+            if (ctx.index < 0) return;
+            Registry* registry = registryRef();
+            MutexLockGuard lock(registry->mutex);
+            registry->slots[static_cast<size_t>(ctx.index)] = nullptr;
+            --registry->live;
+            ctx.index = -1;
+        }
+    };
+    thread_local Deregistrar t_deregistrar;
+
+    int addToRegistry(Registry* registry, int preferred)
+        NO_THREAD_SAFETY_ANALYSIS {
+        std::vector<CurrentThread::Context*>& slots = registry->slots;
+        size_t index = 0;
+        if (preferred >= 0) {
+            index = static_cast<size_t>(preferred);
+            if (slots.size() <= index) slots.resize(index + 1, nullptr);
+        } else {
+            while (index < slots.size() && slots[index] != nullptr) ++index;
+            if (index == slots.size()) slots.push_back(nullptr);
         }
-        free(demangled);
-        free(strings);
+        slots[index] = &CurrentThread::t_context;
+        ++registry->live;
+        return static_cast<int>(index);
     }
-    return stack;
+}  // namespace
+
+int CurrentThread::registerThread() {
+    if (t_context.index >= 0) return t_context.index;
+    tid();
+    t_deregistrar.armed = true;
+    Registry* registry = registryRef();
+    MutexLockGuard lock(registry->mutex);
+    t_context.index = addToRegistry(registry, -1);
+    return t_context.index;
+}
+
+void CurrentThread::setName(const char* name) {
+    if (t_context.index < 0) {
+        t_context.name = name;
+        return;
+    }
+    /// registered: ThreadRegistry::snapshot() reads it under the lock
+    Registry* registry = registryRef();
+    MutexLockGuard lock(registry->mutex);
+    t_context.name = name;
+}
+
+std::string CurrentThread::stackTrace(bool demangle) {
+    // skipping the 0-th, which is this function
+    return StackTrace::capture(1).toString(demangle);
 }
+
+namespace detail {
+    /// @brief Called in the child after fork(), only the calling thread
+    ///        survives and keeps its index
+    void resetThreadRegistry() {
+        Registry* registry = new Registry;
+        const int index = CurrentThread::t_context.index;
+        if (index >= 0) {
+            MutexLockGuard lock(registry->mutex);
+            addToRegistry(registry, index);
+        }
+        registryRef() = registry;
+    }
+}  // namespace detail
+
+std::vector<ThreadRegistry::Info> ThreadRegistry::snapshot() {
+    std::vector<Info> threads;
+    Registry* registry = registryRef();
+    MutexLockGuard lock(registry->mutex);
+    threads.reserve(static_cast<size_t>(registry->live));
+    for (const CurrentThread::Context* ctx : registry->slots) {
+        if (ctx != nullptr)
+            threads.push_back(Info{ctx->tid, ctx->index, ctx->name});
+    }
+    return threads;
+}
+
+int ThreadRegistry::size() {
+    Registry* registry = registryRef();
+    MutexLockGuard lock(registry->mutex);
+    return registry->live;
+}
+
+int ThreadRegistry::indexLimit() {
+    Registry* registry = registryRef();
+    MutexLockGuard lock(registry->mutex);
+    return static_cast<int>(registry->slots.size());
+}
+
+}  // namespace Lute
@@ -0,0 +1,131 @@
+#include <Base/epoch.h>
+#include <Base/mutex.h>   // MutexLock
+#include <Base/perCpu.h>  // PerThread
+#include <sched.h>        // sched_yield
+
+#include <cassert>  // assert
+
+namespace Lute {
+namespace detail {
+    std::atomic<uint64_t> g_epoch(1);
+    __thread EpochRecord* t_epochRecord
+        __attribute__((tls_model("initial-exec"))) = nullptr;
+}  // namespace detail
+
+namespace {
+    using detail::EpochRecord;
+    using detail::Retired;
+
+    /// Leaked, objects may be retired by static / thread_local destructors
+    PerThread<EpochRecord>& records() {
+        static PerThread<EpochRecord>* records = new PerThread<EpochRecord>;
+        return *records;
+    }
+
+    /// What exited threads left behind, freed by whoever reclaims next
+    struct Orphans {
+        MutexLock mutex;
+        std::vector<Retired> retired GUARDED_BY(mutex);
+        std::atomic<size_t> count{0};
+    };
+
+    Orphans& orphans() {
+        static Orphans* orphans = new Orphans;
+        return *orphans;
+    }
+
+    /// Hands the thread's limbo over to the orphans when the thread exits
+    struct RecordReaper {
+        bool armed = false;
+        ~RecordReaper() {
+            EpochRecord* r = detail::t_epochRecord;
+            Epoch::reclaim();
+            if (r->limbo.empty()) return;
+            Orphans& o = orphans();
+            MutexLockGuard lock(o.mutex);
+            o.retired.insert(o.retired.end(), r->limbo.begin(),
+                             r->limbo.end());
+            o.count.store(o.retired.size(), std::memory_order_relaxed);
+            r->limbo.clear();
+        }
+    };
+    thread_local RecordReaper t_reaper;
+
+    /// @brief Move the entries retired before `safe` out of `retired`
+    void takeReclaimable(std::vector<Retired>* retired, uint64_t safe,
+                         std::vector<Retired>* out) {
+        size_t kept = 0;
+        for (const Retired& item : *retired) {
+            if (item.epoch < safe)
+                out->push_back(item);
+            else
+                (*retired)[kept++] = item;
+        }
+        retired->resize(kept);
+    }
+
+    void tryAdvance() {
+        uint64_t epoch = detail::g_epoch.load();
+        /// pairs with the fence in Epoch::enter()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool behind = false;
+        records().forEach([epoch, &behind](EpochRecord& r) {
+            const uint64_t state = r.state.load(std::memory_order_acquire);
+            if ((state & 1) && (state >> 1) != epoch) behind = true;
+        });
+        if (!behind) detail::g_epoch.compare_exchange_strong(epoch, epoch + 1);
+    }
+}  // namespace
+
+detail::EpochRecord* detail::registerEpochRecord() {
+    /// index() first: the index must stay ours until the reaper has run
+    EpochRecord* r = &records().local();
+    t_reaper.armed = true;
+    t_epochRecord = r;
+    return r;
+}
+
+void Epoch::retire(void* object, void (*deleter)(void*)) {
+    EpochRecord* r = detail::t_epochRecord;
+    if (__builtin_expect(r == nullptr, 0)) r = detail::registerEpochRecord();
+    r->limbo.push_back(Retired{object, deleter, detail::g_epoch.load()});
+    if (r->limbo.size() % kReclaimBatch == 0) reclaim();
+}
+
+size_t Epoch::reclaim() {
+    EpochRecord* r = detail::t_epochRecord;
+    if (__builtin_expect(r == nullptr, 0)) r = detail::registerEpochRecord();
+    tryAdvance();
+    /// a guard may have pinned `epoch - 1` and still see what was retired
+    /// then, anything older is unreachable
+    const uint64_t safe = detail::g_epoch.load() - 1;
+
+    std::vector<Retired> freed;
+    takeReclaimable(&r->limbo, safe, &freed);
+    Orphans& o = orphans();
+    if (o.count.load(std::memory_order_relaxed) > 0) {
+        MutexLockGuard lock(o.mutex);
+        takeReclaimable(&o.retired, safe, &freed);
+        o.count.store(o.retired.size(), std::memory_order_relaxed);
+    }
+    /// deleters run last, they may retire more
+    for (const Retired& item : freed) item.deleter(item.object);
+    return freed.size();
+}
+
+void Epoch::synchronize() {
+    assert(detail::t_epochRecord == nullptr ||
+           detail::t_epochRecord->depth == 0);
+    while (true) {
+        reclaim();
+        if (pending() == 0) break;
+        ::sched_yield();
+    }
+}
+
+size_t Epoch::pending() {
+    EpochRecord* r = detail::t_epochRecord;
+    return r == nullptr ? 0 : r->limbo.size();
+}
+
+}  // namespace Lute
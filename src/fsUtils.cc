@@ -1,6 +1,6 @@
 #include <Base/fsUtils.h>
 #include <dirent.h>  // opendir
-#include <fcntl.h>   // open
+#include <fcntl.h>   // open fallocate
 #include <unistd.h>  // access
 
 #include <cassert>  // assert
@@ -299,13 +299,29 @@ int ReadSmallFile::readToBuffer(int* size) {
     return err;
 }
 
-AppendFile::AppendFile(const std::string& filename)
-    : fp_(::fopen(filename.c_str(), "ae")), writtenBytes_(0) {
+AppendFile::AppendFile(const std::string& filename, off_t preallocate)
+    : fp_(::fopen(filename.c_str(), "ae")),
+      writtenBytes_(0),
+      preallocated_(0) {
     assert(fp_);
     ::setbuffer(fp_, buffer_, sizeof(buffer_));
+    /// best effort: not every file system supports it
+    if (preallocate > 0 &&
+        ::fallocate(::fileno(fp_), FALLOC_FL_KEEP_SIZE, 0, preallocate) == 0)
+        preallocated_ = preallocate;
 }
 
-AppendFile::~AppendFile() { ::fclose(fp_); }
+AppendFile::~AppendFile() {
+    if (preallocated_ > 0) {
+        /// give back the blocks reserved past what was written
+        ::fflush(fp_);
+        const int fd = ::fileno(fp_);
+        const off_t size = ::lseek(fd, 0, SEEK_END);
+        if (size >= 0 && size < preallocated_ && ::ftruncate(fd, size) != 0)
+            ::perror("AppendFile::~AppendFile() ftruncate");
+    }
+    ::fclose(fp_);
+}
 
 size_t AppendFile::write(const char* logline, size_t len) {
     /// 1 - 数据类型大小
@@ -1,7 +1,23 @@
+#include <Base/condition_variable.h>
 #include <Base/ini_config.h>
 #include <Base/logger.h>
+#include <Base/metrics.h>
+#include <Base/shmLogRing.h>
 #include <Base/singleton.h>
+#include <Base/trace.h>
 #include <Base/utils.h>
+#include <dirent.h>         // opendir
+#include <linux/futex.h>  // FUTEX_WAIT_PRIVATE
+#include <sched.h>          // sched_yield
+#include <signal.h>         // kill
+#include <sys/syscall.h>    // SYS_futex
+#include <unistd.h>         // syscall
+
+#include <algorithm>  // sort
+#include <atomic>     // atomic
+#include <cerrno>     // errno
+#include <climits>    // INT_MAX
+#include <deque>      // deque
 
 /// *********************************************************
 /// FIXME Must correspond one-to-one with .ini file
@@ -15,11 +31,31 @@
 /// Uint: seconds
 #define LUTE_LOGGER_INI_LOG_FLUSH_INTERVAL_KEY "LOG_FLUSH_INTERVAL"
 #define LUTE_LOGGER_INI_LOG_FLUSH_INTERVAL_VALUE_DEFAULT "30"
+/// Uint: milliseconds, 0 is off, see AsyncLogger::setMaxDelay
+#define LUTE_LOGGER_INI_LOG_FLUSH_MAX_DELAY_KEY "LOG_FLUSH_MAX_DELAY_MS"
+#define LUTE_LOGGER_INI_LOG_FLUSH_MAX_DELAY_VALUE_DEFAULT "0"
+/// Uint: Byte, "64K" works too, 0 is off, see AsyncLogger::setNotifyBytes
+#define LUTE_LOGGER_INI_LOG_FLUSH_NOTIFY_SIZE_KEY "LOG_FLUSH_NOTIFY_SIZE"
+#define LUTE_LOGGER_INI_LOG_FLUSH_NOTIFY_SIZE_VALUE_DEFAULT "0"
+/// Uint: seconds, 3600 rolls hourly, see LogFile::setRollPeriod
+#define LUTE_LOGGER_INI_LOG_ROLL_PERIOD_KEY "LOG_ROLL_PERIOD"
+#define LUTE_LOGGER_INI_LOG_ROLL_PERIOD_VALUE_DEFAULT "86400"
+/// Backend threads and files, > 1 uses ShardedAsyncLogger
+#define LUTE_LOGGER_INI_LOG_SHARDS_KEY "LOG_SHARDS"
+#define LUTE_LOGGER_INI_LOG_SHARDS_VALUE_DEFAULT "1"
+/// Shared memory ring drained by tools/logDaemon, e.g. "/lute-log"; empty
+/// or no daemon running logs through this process's own AsyncLogger
+#define LUTE_LOGGER_INI_LOG_SHM_RING_KEY "LOG_SHM_RING"
+#define LUTE_LOGGER_INI_LOG_SHM_RING_VALUE_DEFAULT ""
 /// *********************************************************
 
 // forward declaration
 Lute::Logger::LogLevel initLogLevel();
 std::shared_ptr<Lute::AsyncLogger> g_asyncLogger;
+/// Used instead of g_asyncLogger when LOG_SHARDS > 1
+std::shared_ptr<Lute::ShardedAsyncLogger> g_shardedLogger;
+/// Used instead of both when LOG_SHM_RING names a running logDaemon's ring
+std::shared_ptr<Lute::ShmLogRing> g_shmRing;
 
 /**
  * @brief Default output Func.
@@ -40,6 +76,30 @@ void defaultOutput(const char* msg, int len) {
 inline void defaultAsyncOutput(const char* msg, int len) {
     g_asyncLogger->append(msg, len);
 }
+bool defaultAsyncReserve(int maxLen, Lute::Logger::Reservation* line) {
+    return g_asyncLogger->reserve(maxLen, line);
+}
+void defaultAsyncCommit(const Lute::Logger::Reservation& line, int len) {
+    g_asyncLogger->commit(line, len);
+}
+inline void shardedAsyncOutput(const char* msg, int len) {
+    g_shardedLogger->append(msg, len);
+}
+bool shardedAsyncReserve(int maxLen, Lute::Logger::Reservation* line) {
+    return g_shardedLogger->reserve(maxLen, line);
+}
+void shardedAsyncCommit(const Lute::Logger::Reservation& line, int len) {
+    g_shardedLogger->commit(line, len);
+}
+inline void shmRingOutput(const char* msg, int len) {
+    g_shmRing->append(msg, len);
+}
+bool shmRingReserve(int maxLen, Lute::Logger::Reservation* line) {
+    return g_shmRing->reserve(maxLen, line);
+}
+void shmRingCommit(const Lute::Logger::Reservation& line, int len) {
+    g_shmRing->commit(line, len);
+}
 void defaultFlush() { ::fflush(stdout); }
 
 /// -----------------------------
@@ -108,6 +168,21 @@ namespace ini {
             LUTE_INI_WRITE(LUTE_LOGGER_INI_SECTION,
                            LUTE_LOGGER_INI_LOG_FLUSH_INTERVAL_KEY,
                            LUTE_LOGGER_INI_LOG_FLUSH_INTERVAL_VALUE_DEFAULT);
+            LUTE_INI_WRITE(LUTE_LOGGER_INI_SECTION,
+                           LUTE_LOGGER_INI_LOG_FLUSH_MAX_DELAY_KEY,
+                           LUTE_LOGGER_INI_LOG_FLUSH_MAX_DELAY_VALUE_DEFAULT);
+            LUTE_INI_WRITE(LUTE_LOGGER_INI_SECTION,
+                           LUTE_LOGGER_INI_LOG_FLUSH_NOTIFY_SIZE_KEY,
+                           LUTE_LOGGER_INI_LOG_FLUSH_NOTIFY_SIZE_VALUE_DEFAULT);
+            LUTE_INI_WRITE(LUTE_LOGGER_INI_SECTION,
+                           LUTE_LOGGER_INI_LOG_ROLL_PERIOD_KEY,
+                           LUTE_LOGGER_INI_LOG_ROLL_PERIOD_VALUE_DEFAULT);
+            LUTE_INI_WRITE(LUTE_LOGGER_INI_SECTION,
+                           LUTE_LOGGER_INI_LOG_SHARDS_KEY,
+                           LUTE_LOGGER_INI_LOG_SHARDS_VALUE_DEFAULT);
+            LUTE_INI_WRITE(LUTE_LOGGER_INI_SECTION,
+                           LUTE_LOGGER_INI_LOG_SHM_RING_KEY,
+                           LUTE_LOGGER_INI_LOG_SHM_RING_VALUE_DEFAULT);
         }
     }
 
@@ -118,6 +193,10 @@ namespace ini {
 /// NOTE Global Outuput/Flush Function
 Lute::Logger::OutputFunc g_output = defaultOutput;
 Lute::Logger::FlushFunc g_flush = defaultFlush;
+/// NOTE Set together, nullptr when lines go through g_output
+Lute::Logger::ReserveFunc g_reserve = nullptr;
+Lute::Logger::CommitFunc g_commit = nullptr;
+bool g_logMicroseconds = false;
 /// NOTE Global logger level is set
 Lute::Logger::LogLevel g_logLevel = initLogLevel();
 
@@ -125,6 +204,10 @@ Lute::Logger::LogLevel g_logLevel = initLogLevel();
 __thread char t_errnobuf[512];
 __thread char t_time[64];
 __thread time_t t_lastSecond;
+/// Lines formatted aside for g_output, a nested LOG_* in the middle of a
+/// line takes a heap buffer instead
+__thread char t_line[Lute::detail::kSmallBuffer];
+__thread bool t_lineBusy;
 
 const char* LogLevelName[static_cast<unsigned int>(
     Lute::Logger::LogLevel::NUM_LOG_LEVELS)] = {"TRACE ", "DEBUG ", "INFO  ",
@@ -137,18 +220,84 @@ constexpr int LogLevelStrLen = sizeof(LogLevelName) / sizeof(LogLevelName[0]);
 ///
 void initLogger(Lute::Logger::LogLevel logLevel) {
     Lute::ini::initIniConfig();
-    static Lute::string_view logFilename = LUTE_INI_READ(
-        LUTE_LOGGER_INI_SECTION, LUTE_LOGGER_INI_LOG_FILENAME_KEY);
-    static Lute::string_view logFileRollsize = LUTE_INI_READ(
-        LUTE_LOGGER_INI_SECTION, LUTE_LOGGER_INI_LOG_FILE_ROLLSIZE_KEY);
-    static Lute::string_view logFlushInterval = LUTE_INI_READ(
-        LUTE_LOGGER_INI_SECTION, LUTE_LOGGER_INI_LOG_FLUSH_INTERVAL_KEY);
+    /// copies: every LUTE_INI_READ re-reads the file into the structure the
+    /// previous views point into
+    static const std::string logFilename(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_FILENAME_KEY));
+    static const std::string logFileRollsize(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_FILE_ROLLSIZE_KEY));
+    static const std::string logFlushInterval(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_FLUSH_INTERVAL_KEY));
+    /// missing in older .ini files, read as "" -> 0 (off)
+    static const std::string logFlushMaxDelay(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_FLUSH_MAX_DELAY_KEY));
+    static const std::string logFlushNotifySize(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_FLUSH_NOTIFY_SIZE_KEY));
+    static const std::string logRollPeriod(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_ROLL_PERIOD_KEY));
+    static const std::string logShards(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_SHARDS_KEY));
+    static const std::string logShmRing(
+        LUTE_INI_READ(LUTE_LOGGER_INI_SECTION,
+                      LUTE_LOGGER_INI_LOG_SHM_RING_KEY));
 
     Lute::Logger::setLogLevel(logLevel);
+    if (!logShmRing.empty()) {
+        /// lines already in the ring survive a crash of this process
+        g_shmRing = Lute::ShmLogRing::open(logShmRing);
+        if (g_shmRing) {
+            Lute::Logger::setOutput(shmRingOutput);
+            Lute::Logger::setReserve(shmRingReserve, shmRingCommit);
+            return;
+        }
+        ::fprintf(stderr, "initLogger: no log ring %s (%s), writing %s\n",
+                  logShmRing.c_str(), strerror_tl(errno),
+                  logFilename.c_str());
+    }
+    /// "1072741824", "1Gi" and "512M" (MiB) all work
+    int64_t rollSize = 0;
+    if (!Lute::parseIEC(logFileRollsize, &rollSize) || rollSize <= 0)
+        rollSize = ::atoll(LUTE_LOGGER_INI_LOG_FILE_ROLLSIZE_VALUE_DEFAULT);
+    int64_t notifySize = 0;
+    if (!Lute::parseIEC(logFlushNotifySize, &notifySize) || notifySize < 0)
+        notifySize = 0;
+    const int maxDelay = ::atoi(logFlushMaxDelay.data());
+    const int shards = ::atoi(logShards.data());
+    int rollPeriod = ::atoi(logRollPeriod.data());
+    if (rollPeriod <= 0)
+        rollPeriod = ::atoi(LUTE_LOGGER_INI_LOG_ROLL_PERIOD_VALUE_DEFAULT);
+
+    if (shards > 1) {
+        g_shardedLogger =
+            Lute::SingletonPtr<Lute::ShardedAsyncLogger>::GetInstance(
+                logFilename.data(), static_cast<off_t>(rollSize), shards,
+                ::atoi(logFlushInterval.data()));
+        g_shardedLogger->setMaxDelay(maxDelay);
+        g_shardedLogger->setNotifyBytes(static_cast<int>(notifySize));
+        g_shardedLogger->setRollPeriod(rollPeriod);
+        /// lets tools/logMerge order lines within a second
+        Lute::Logger::setMicroseconds(true);
+        Lute::Logger::setOutput(shardedAsyncOutput);
+        Lute::Logger::setReserve(shardedAsyncReserve, shardedAsyncCommit);
+        g_shardedLogger->start();
+        return;
+    }
+
     g_asyncLogger = Lute::SingletonPtr<Lute::AsyncLogger>::GetInstance(
-        logFilename.data(), ::atoi(logFileRollsize.data()),
+        logFilename.data(), static_cast<off_t>(rollSize),
         ::atoi(logFlushInterval.data()));
+    g_asyncLogger->setMaxDelay(maxDelay);
+    g_asyncLogger->setNotifyBytes(static_cast<int>(notifySize));
+    g_asyncLogger->setRollPeriod(rollPeriod);
     Lute::Logger::setOutput(defaultAsyncOutput);
+    Lute::Logger::setReserve(defaultAsyncReserve, defaultAsyncCommit);
     g_asyncLogger->start();
 }
 
@@ -162,21 +311,76 @@ const char* strerror_tl(int savedErrno) {
     return ::strerror_r(savedErrno, t_errnobuf, sizeof(t_errnobuf));
 }
 
-/// NOTE ----------- FixedBuffer -----------
-template <int SIZE>
-const char* Lute::detail::FixedBuffer<SIZE>::debugString() {
-    *cur_ = '\0';
-    return data_;
+/// NOTE ----------- LogBuffer -----------
+void Lute::detail::LogBuffer::commit(int offset, int maxLen, int len) {
+    int end = offset + maxLen;
+    /// a zero-length commit never shrinks: the cursor could come back to
+    /// `end` while a later region starting there is still being filled
+    if (len < maxLen &&
+        (len == 0 || !cursor_.compare_exchange_strong(
+                         end, offset + len, std::memory_order_relaxed))) {
+        const int i = holeCount_.fetch_add(1, std::memory_order_relaxed);
+        if (i < kMaxHoles) {
+            holes_[i] = Hole{offset + len, maxLen - len};
+        } else {
+            /// only with many small reservations interleaved
+            MutexLockGuard lock(spillMutex_);
+            spilled_.push_back(Hole{offset + len, maxLen - len});
+        }
+    }
+    /// the region is no longer touched after this, nor is the buffer but
+    /// to wake a backend waiting for this last commit
+    if (pending_.fetch_sub(1, std::memory_order_release) == (kWaiting | 1))
+        ::syscall(SYS_futex, &pending_, FUTEX_WAKE_PRIVATE, 1, nullptr,
+                  nullptr, 0);
 }
 
-template <int SIZE>
-void Lute::detail::FixedBuffer<SIZE>::cookieStart() {}
+void Lute::detail::LogBuffer::waitCommitted() {
+    /// a line is formatted in microseconds, unless its stream expression
+    /// is slow: then sleep rather than spin
+    for (int i = 0; i < 64; ++i) {
+        if (pending_.load(std::memory_order_acquire) == 0) return;
+        ::sched_yield();
+    }
+    /// retired, the count only goes down now
+    int pending = pending_.fetch_or(kWaiting, std::memory_order_acquire) |
+                  kWaiting;
+    while (pending != kWaiting) {
+        ::syscall(SYS_futex, &pending_, FUTEX_WAIT_PRIVATE, pending, nullptr,
+                  nullptr, 0);
+        pending = pending_.load(std::memory_order_acquire);
+    }
+    pending_.store(0, std::memory_order_relaxed);
+}
+
+template <typename F>
+void Lute::detail::LogBuffer::forEachSegment(F&& f) {
+    const int holes = holeCount_.load(std::memory_order_relaxed);
+    Hole* begin = holes_;
+    Hole* end = holes_ + (holes < kMaxHoles ? holes : kMaxHoles);
+    std::vector<Hole> all;
+    if (holes > kMaxHoles) {
+        MutexLockGuard lock(spillMutex_);
+        all.assign(holes_, holes_ + kMaxHoles);
+        all.insert(all.end(), spilled_.begin(), spilled_.end());
+        begin = all.data();
+        end = begin + all.size();
+    }
+    std::sort(begin, end, [](const Hole& a, const Hole& b) {
+        return a.offset < b.offset;
+    });
+    int from = 0;
+    for (const Hole* hole = begin; hole != end; ++hole) {
+        if (hole->offset > from) f(data_ + from, hole->offset - from);
+        from = hole->offset + hole->size;
+    }
+    const int to = length();
+    if (to > from) f(data_ + from, to - from);
+}
 
-template <int SIZE>
-void Lute::detail::FixedBuffer<SIZE>::cookieEnd() {}
+/// NOTE ----------- LineStream -----------
 
-/// NOTE ----------- LogStream -----------
-void Lute::LogStream::staticCheck() {
+void Lute::LineStream::staticCheck() {
     static_assert(kMaxNumericSize - 10 > std::numeric_limits<double>::digits10,
                   "kMaxNumericSize is large enough");
     static_assert(
@@ -190,54 +394,54 @@ void Lute::LogStream::staticCheck() {
 }
 
 template <typename T>
-void Lute::LogStream::formatInteger(T v) {
+void Lute::LineStream::formatInteger(T v) {
     if (buffer_.avail() >= kMaxNumericSize) {
         size_t len = integer2Str(buffer_.current(), v);
         buffer_.add(len);
     }
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(short v) {
+Lute::LineStream& Lute::LineStream::operator<<(short v) {
     *this << static_cast<int>(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(unsigned short v) {
+Lute::LineStream& Lute::LineStream::operator<<(unsigned short v) {
     *this << static_cast<unsigned int>(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(int v) {
+Lute::LineStream& Lute::LineStream::operator<<(int v) {
     formatInteger(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(unsigned int v) {
+Lute::LineStream& Lute::LineStream::operator<<(unsigned int v) {
     formatInteger(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(long v) {
+Lute::LineStream& Lute::LineStream::operator<<(long v) {
     formatInteger(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(unsigned long v) {
+Lute::LineStream& Lute::LineStream::operator<<(unsigned long v) {
     formatInteger(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(long long v) {
+Lute::LineStream& Lute::LineStream::operator<<(long long v) {
     formatInteger(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(unsigned long long v) {
+Lute::LineStream& Lute::LineStream::operator<<(unsigned long long v) {
     formatInteger(v);
     return *this;
 }
 
-Lute::LogStream& Lute::LogStream::operator<<(const void* p) {
+Lute::LineStream& Lute::LineStream::operator<<(const void* p) {
     auto v = reinterpret_cast<uintptr_t>(p);
     if (buffer_.avail() >= kMaxNumericSize) {
         char* buf = buffer_.current();
@@ -250,26 +454,26 @@ Lute::LogStream& Lute::LogStream::operator<<(const void* p) {
 }
 
 // FIXME: replace this with Grisu3 by Florian Loitsch.
-Lute::LogStream& Lute::LogStream::operator<<(double v) {
+Lute::LineStream& Lute::LineStream::operator<<(double v) {
     if (buffer_.avail() >= kMaxNumericSize) {
         int len = ::snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
         buffer_.add(static_cast<size_t>(len));
     }
     return *this;
 }
-Lute::LogStream::self& Lute::LogStream::operator<<(bool v) {
+Lute::LineStream::self& Lute::LineStream::operator<<(bool v) {
     buffer_.append(v ? "1" : "0", 1);
     return *this;
 }
-Lute::LogStream::self& Lute::LogStream::operator<<(float v) {
+Lute::LineStream::self& Lute::LineStream::operator<<(float v) {
     *this << static_cast<double>(v);
     return *this;
 }
-Lute::LogStream::self& Lute::LogStream::operator<<(char v) {
+Lute::LineStream::self& Lute::LineStream::operator<<(char v) {
     buffer_.append(&v, 1);
     return *this;
 }
-Lute::LogStream::self& Lute::LogStream::operator<<(const char* str) {
+Lute::LineStream::self& Lute::LineStream::operator<<(const char* str) {
     if (str) {
         buffer_.append(str, strlen(str));
     } else {
@@ -278,17 +482,17 @@ Lute::LogStream::self& Lute::LogStream::operator<<(const char* str) {
     return *this;
 }
 
-Lute::LogStream::self& Lute::LogStream::operator<<(const unsigned char* str) {
+Lute::LineStream::self& Lute::LineStream::operator<<(const unsigned char* str) {
     return operator<<(reinterpret_cast<const char*>(str));
 }
 
-Lute::LogStream::self& Lute::LogStream::operator<<(const std::string& v) {
+Lute::LineStream::self& Lute::LineStream::operator<<(const std::string& v) {
     buffer_.append(v.c_str(), v.size());
     return *this;
 }
 
-Lute::LogStream::self& Lute::LogStream::operator<<(
-    const Lute::LogStream::Buffer& v) {
+Lute::LineStream::self& Lute::LineStream::operator<<(
+    const Lute::LineStream::Buffer& v) {
     // *this << v.toStringPiece();
     *this << v.toString();
     return *this;
@@ -318,22 +522,167 @@ template Lute::Fmt::Fmt(const char* fmt, float);
 template Lute::Fmt::Fmt(const char* fmt, double);
 
 /// NOTE ----------- LogFile -----------
+/// The spare file of a LogFile, filled in by the roller thread
+struct Lute::detail::NextLogFile {
+    /// hidden until renamed: `.basename.hostname.pid.log.N.next`
+    std::string path;
+    off_t preallocate;
+    MutexLock mutex;
+    std::unique_ptr<AppendFile> file GUARDED_BY(mutex);
+    /// the LogFile is gone, don't leave a spare behind
+    bool closed GUARDED_BY(mutex) = false;
+};
+
+namespace Lute {
+namespace {
+///
+/// @brief The thread that does the slow part of rolling for every LogFile
+///        of the process: fclose (which flushes), rename, fopen, fallocate
+///
+class FileRoller {
+public:
+    /// Leaked, LogFiles of static objects may roll during exit
+    static FileRoller& instance() {
+        static FileRoller* roller = new FileRoller;
+        return *roller;
+    }
+
+    void post(std::function<void()> task) {
+        MutexLockGuard lock(mutex_);
+        tasks_.push_back(std::move(task));
+        cond_.notify();
+    }
+
+    ///
+    /// @brief false in a child forked after the thread started: the thread
+    ///        didn't survive and its lock may be held, roll synchronously
+    ///
+    bool ours() const { return pid_ == ProcessInfo::pid(); }
+
+    /// @brief Wait for the tasks posted so far
+    void drain() {
+        CountDownLatch latch(1);
+        post([&latch] { latch.countDown(); });
+        latch.wait();
+    }
+
+private:
+    FileRoller()
+        : pid_(ProcessInfo::pid()),
+          cond_(mutex_),
+          thread_(std::bind(&FileRoller::threadFunc, this), "LogRoller") {
+        thread_.start();
+    }
+
+    void threadFunc() {
+        while (true) {
+            std::function<void()> task;
+            {
+                MutexLockGuard lock(mutex_);
+                while (tasks_.empty()) cond_.wait();
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    const pid_t pid_;
+    MutexLock mutex_;
+    Condition cond_;
+    std::deque<std::function<void()>> tasks_ GUARDED_BY(mutex_);
+    Thread thread_;
+};
+
+/// tells the spares of the LogFiles of one process apart
+std::atomic<int> g_spares(0);
+
+///
+/// @brief Remove the spares named `prefix`pid.* in the working directory
+///        that processes no longer running left behind, preallocated
+///
+void removeStaleSpares(const std::string& prefix) {
+    DIR* dir = ::opendir(".");
+    if (dir == nullptr) return;
+    while (struct dirent* entry = ::readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) != 0 ||
+            name.size() < prefix.size() + 5 ||
+            name.compare(name.size() - 5, 5, ".next") != 0)
+            continue;
+        const pid_t pid = ::atoi(name.c_str() + prefix.size());
+        if (pid > 0 && ::kill(pid, 0) != 0 && errno == ESRCH)
+            ::unlink(name.c_str());
+    }
+    ::closedir(dir);
+}
+
+/// @brief Roller thread: open and preallocate the spare
+void prepareNext(const std::shared_ptr<detail::NextLogFile>& next) {
+    /// left by a crashed process with the same pid and sequence
+    ::unlink(next->path.c_str());
+    std::unique_ptr<AppendFile> file(
+        new AppendFile(next->path, next->preallocate));
+    MutexLockGuard lock(next->mutex);
+    if (next->closed) {
+        file.reset();
+        ::unlink(next->path.c_str());
+        return;
+    }
+    next->file = std::move(file);
+}
+}  // namespace
+}  // namespace Lute
+
 Lute::LogFile::LogFile(const std::string& basename, off_t rollSize,
                        bool threadSafe, int flushInterval, int checkEveryN)
     : basename_(basename),
       rollSize_(rollSize),
       flushInterval_(flushInterval),
       checkEveryN_(checkEveryN),
+      suffix_("." + ProcessInfo::hostname() + "." +
+              std::to_string(ProcessInfo::pid()) + ".log"),
       count_(0),
+      rollPeriod_(kDefaultRollPeriod),
       mutex_(threadSafe ? new MutexLock : nullptr),
       startOfPeriod_(0),
       lastRoll_(0),
-      lastFlush_(0) {
+      lastFlush_(0),
+      next_(std::make_shared<detail::NextLogFile>()) {
     assert(basename.find('/') == std::string::npos);
+    next_->path = "." + basename_ + suffix_ + "." +
+                  std::to_string(++g_spares) + ".next";
+    next_->preallocate = std::min(rollSize_, kMaxPreallocate);
+    const std::string prefix = "." + basename_ + "." +
+                               ProcessInfo::hostname() + ".";
+    FileRoller& roller = FileRoller::instance();
+    if (roller.ours())
+        roller.post([prefix] { removeStaleSpares(prefix); });
+    else
+        removeStaleSpares(prefix);
     rollFile();
 }
 
-Lute::LogFile::~LogFile() = default;
+Lute::LogFile::~LogFile() {
+    /// forked: the spare and the roller are the parent's
+    if (!FileRoller::instance().ours()) return;
+    {
+        MutexLockGuard lock(next_->mutex);
+        next_->closed = true;
+        if (next_->file) {
+            next_->file.reset();
+            ::unlink(next_->path.c_str());
+        }
+    }
+    /// the files this one rolled away from are closed, and flushed, there
+    FileRoller::instance().drain();
+}
+
+void Lute::LogFile::setRollPeriod(int seconds) {
+    assert(seconds > 0);
+    rollPeriod_ = seconds;
+    startOfPeriod_ = lastRoll_ / rollPeriod_ * rollPeriod_;
+}
 
 void Lute::LogFile::append(const char* logline, int len) {
     if (mutex_) {
@@ -363,7 +712,7 @@ void Lute::LogFile::append_unlocked(const char* logline, int len) {
         if (count_ >= checkEveryN_) {
             count_ = 0;
             time_t now = ::time(nullptr);
-            time_t thisPeriod_ = now / kRollPerSeconds_ * kRollPerSeconds_;
+            time_t thisPeriod_ = now / rollPeriod_ * rollPeriod_;
             if (thisPeriod_ != startOfPeriod_) {
                 rollFile();
             } else if (now - lastFlush_ > flushInterval_) {
@@ -375,51 +724,62 @@ void Lute::LogFile::append_unlocked(const char* logline, int len) {
 }
 
 bool Lute::LogFile::rollFile() {
-    time_t now = 0;
-    std::string filename = getLogFileName(basename_, &now);
-    time_t start = now / kRollPerSeconds_ * kRollPerSeconds_;
+    const time_t now = ::time(nullptr);
+    /// one file per second at most, the name has no finer time
+    if (now <= lastRoll_) return false;
+    std::string filename = logFileName(now);
 
-    if (now > lastRoll_) {
+    if (!FileRoller::instance().ours()) {
+        /// forked: the old way, the spare is the parent's
+        file_.reset(new AppendFile(filename));
         lastRoll_ = now;
         lastFlush_ = now;
-        startOfPeriod_ = start;
-        file_.reset(new AppendFile(filename));
+        startOfPeriod_ = now / rollPeriod_ * rollPeriod_;
         return true;
     }
-    return false;
+
+    std::unique_ptr<AppendFile> file;
+    {
+        MutexLockGuard lock(next_->mutex);
+        file = std::move(next_->file);
+    }
+    /// the roller hasn't caught up yet (or this is the first file)
+    const bool spare = file != nullptr;
+    if (!spare) file.reset(new AppendFile(filename));
+
+    std::shared_ptr<AppendFile> old(std::move(file_));
+    file_ = std::move(file);
+    lastRoll_ = now;
+    lastFlush_ = now;
+    startOfPeriod_ = now / rollPeriod_ * rollPeriod_;
+
+    std::shared_ptr<detail::NextLogFile> next = next_;
+    FileRoller::instance().post([next, spare, filename, old]() mutable {
+        if (spare && ::rename(next->path.c_str(), filename.c_str()) != 0) {
+            char buf[512];
+            ::fprintf(stderr, "LogFile: rename to %s failed %s\n",
+                      filename.c_str(), ::strerror_r(errno, buf, sizeof buf));
+        }
+        old.reset();
+        prepareNext(next);
+    });
+    return true;
 }
 
-/**
- * @brief Get the fileName of log.
- * E.g  basename.YYYYmmdd-HHMMSS.HOSTNAME.PID.log
- */
-std::string Lute::LogFile::getLogFileName(const std::string& basename,
-                                          time_t* now) {
+std::string Lute::LogFile::logFileName(time_t now) const {
     std::string filename;
-    filename.reserve(basename.size() + 64);
+    filename.reserve(basename_.size() + suffix_.size() + 32);
+    filename = basename_;
 
-    // basename
-    filename = basename;
-
-    // .YYYYmmdd-HHMMSS.
+    // .YYYYmmdd-HHMMSS
     char timebuf[32];
     struct tm tm {};
-    *now = time(nullptr);
-    localtime_r(now, &tm);
-    strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S.", &tm);
+    ::localtime_r(&now, &tm);
+    ::strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S", &tm);
     filename += timebuf;
 
-    // hostname
-    filename += ProcessInfo::hostname();
-
-    // .pid
-    char pidbuf[32];
-    snprintf(pidbuf, sizeof pidbuf, ".%d", ProcessInfo::pid());
-    filename += pidbuf;
-
-    // Suffix: .log
-    filename += ".log";
-
+    // .hostname.pid.log
+    filename += suffix_;
     return filename;
 }
 
@@ -436,10 +796,37 @@ Lute::Logger::LogLevel initLogLevel() {
 ///
 /// @brief Add time, tid, logLevel, file:line to stream
 ///
+namespace {
+int64_t monotonicMs() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+///
+/// @brief The region a line is formatted into: reserved in the output's
+///        buffer, or t_line / the heap for g_output
+///
+Lute::Logger::CommitFunc reserveLine(Lute::Logger::Reservation* line) {
+    const int size = Lute::detail::kSmallBuffer;
+    Lute::Logger::CommitFunc commit = g_commit;
+    if (commit != nullptr && g_reserve(size, line)) return commit;
+    line->data = t_lineBusy ? new char[size] : t_line;
+    line->capacity = size;
+    line->token = nullptr;
+    t_lineBusy = true;
+    return nullptr;
+}
+}  // namespace
+
+/// a LOG_* statement formats in place, its frame holds no line buffer
+static_assert(sizeof(Lute::Logger) < 256, "Logger carries no line storage");
+
 Lute::Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file,
                          int line)
-    : time_(Timestamp::now()),
-      stream_(),
+    : commit_(reserveLine(&reserved_)),
+      time_(Timestamp::now()),
+      stream_(reserved_.data, reserved_.capacity),
       level_(level),
       line_(line),
       basename_(file) {
@@ -459,6 +846,22 @@ Lute::Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file,
         stream_ << strerror_tl(savedErrno) << " (errno=" << savedErrno << ") ";
 }
 
+Lute::Logger::Impl::~Impl() {
+    if (commit_ != nullptr) return;
+    if (reserved_.data == t_line)
+        t_lineBusy = false;
+    else
+        delete[] reserved_.data;
+}
+
+void Lute::Logger::Impl::finish() {
+    const int len = stream_.buffer().length();
+    if (commit_ != nullptr)
+        commit_(reserved_, len);
+    else
+        g_output(reserved_.data, len);
+}
+
 ///
 /// @brief Add time("YYYY/MM/DD hh:mm:ss ") to stream
 ///
@@ -477,6 +880,16 @@ void Lute::Logger::Impl::formatTime() {
         (void)len;
     }
     stream_ << T(t_time, 19);
+    if (g_logMicroseconds) {
+        int micros =
+            static_cast<int>(time_.microSecondsSinceEpoch() %
+                             Timestamp::kMicroSecondsPerSecond);
+        char buf[7];
+        buf[0] = '.';
+        for (int i = 6; i > 0; --i, micros /= 10)
+            buf[i] = static_cast<char>('0' + micros % 10);
+        stream_ << T(buf, 7);
+    }
     stream_ << T(" ", 1);
 }
 
@@ -503,8 +916,7 @@ Lute::Logger::Logger(SourceFile file, int line, bool toAbort)
 
 Lute::Logger::~Logger() {
     impl_.stream_ << "\n";
-    const LogStream::Buffer& buf(stream().buffer());
-    g_output(buf.data(), buf.length());
+    impl_.finish();
     if (impl_.level_ == LogLevel::FATAL) {
         g_flush();
         abort();
@@ -513,7 +925,19 @@ Lute::Logger::~Logger() {
 
 void Lute::Logger::setLogLevel(Logger::LogLevel level) { g_logLevel = level; }
 
-void Lute::Logger::setOutput(OutputFunc out) { g_output = out; }
+void Lute::Logger::setOutput(OutputFunc out) {
+    g_output = out;
+    g_commit = nullptr;
+    g_reserve = nullptr;
+}
+
+void Lute::Logger::setMicroseconds(bool on) { g_logMicroseconds = on; }
+
+void Lute::Logger::setReserve(ReserveFunc reserve, CommitFunc commit) {
+    /// reserveLine() reads g_commit first
+    g_reserve = reserve;
+    g_commit = commit;
+}
 
 void Lute::Logger::setFlush(FlushFunc flush) { g_flush = flush; }
 
@@ -527,10 +951,33 @@ Lute::AsyncLogger::AsyncLogger(const std::string& basename, off_t rollSize,
       thread_(std::bind(&AsyncLogger::threadFunc, this), "AsyncLogger"),
       latch_(1),
       mutex_(),
-      cond_(mutex_),
+      wakeSeq_(0),
+      sleeping_(false),
+      maxDelayMs_(0),
+      notifyBytes_(0),
+      rollPeriod_(LogFile::kDefaultRollPeriod),
+      firstLineMs_(0),
+      flushNow_(false),
       currentBuffer_(new Buffer),
       nextBuffer_(new Buffer),
-      buffers_() {
+      buffers_(),
+      appendedLines_(MetricsRegistry::instance().counter(
+          "lute_async_logger_lines_total", "Lines appended by producers")),
+      appendedBytes_(MetricsRegistry::instance().counter(
+          "lute_async_logger_appended_bytes_total",
+          "Bytes appended by producers")),
+      writtenBytes_(MetricsRegistry::instance().counter(
+          "lute_async_logger_written_bytes_total",
+          "Bytes written to the log file by the backend")),
+      droppedBuffers_(MetricsRegistry::instance().counter(
+          "lute_async_logger_dropped_buffers_total",
+          "Full buffers dropped because the backend fell behind")),
+      droppedLines_(MetricsRegistry::instance().counter(
+          "lute_async_logger_dropped_lines_total",
+          "Lines dropped because the backend fell behind")),
+      buffersInFlight_(MetricsRegistry::instance().gauge(
+          "lute_async_logger_buffers_in_flight",
+          "Full buffers handed to the backend in the last swap")) {
     currentBuffer_->bzero();
     nextBuffer_->bzero();
 
@@ -543,28 +990,109 @@ Lute::AsyncLogger::AsyncLogger(const std::string& basename, off_t rollSize,
 /// @param logline 日志信息
 /// @param len 日志信息长度
 void Lute::AsyncLogger::append(const char* logline, int len) {
-    MutexLockGuard lock(mutex_);
-
-    /// 当前写缓冲有足够的空间放置日志信息
-    /// 直接放入
-    if (currentBuffer_->avail() > len) {
-        currentBuffer_->append(logline, static_cast<size_t>(len));
-    } else {  /// 当前缓冲空间不足
-        /// 将当前缓冲移动到 buffers_ 集合中，等待写入文件系统
-        buffers_.push_back(std::move(currentBuffer_));  /// 利用 移动 而非 复制
-
-        /// 如果 预备缓冲 未被移动，则将预备缓冲移动做到当前缓冲
-        /// 也就是说，前端线程的写入速度小于后端线程的文件写入速度
-        if (nextBuffer_) {
-            currentBuffer_ = std::move(nextBuffer_);
-        } else {  /// 前端线程写入太快，需要重新申请一块新的缓冲作为当前缓冲
-            // Rarely happens
-            currentBuffer_.reset(new Buffer);
+    Logger::Reservation line;
+    if (!reserve(len, &line)) return;
+    ::memcpy(line.data, logline, static_cast<size_t>(len));
+    commit(line, len);
+}
+
+/// @brief 前端线程调用，在当前缓冲中预留 maxLen 字节，由调用者直接写入
+bool Lute::AsyncLogger::reserve(int maxLen, Logger::Reservation* line) {
+    if (maxLen >= Buffer::kSize) return false;
+
+    bool wake = false;
+    {
+        MutexLockGuard lock(mutex_);
+        int offset = 0;
+        /// 当前写缓冲有足够的空间，直接预留
+        if (!currentBuffer_->tryReserve(maxLen, &offset)) {  /// 空间不足
+            LUTE_TRACE_SCOPE("AsyncLogger::append.swap");
+            /// 将当前缓冲移动到 buffers_ 集合中，等待写入文件系统
+            buffers_.push_back(std::move(currentBuffer_));  /// 移动而非复制
+
+            /// 如果 预备缓冲 未被移动，则将预备缓冲移动做到当前缓冲
+            /// 也就是说，前端线程的写入速度小于后端线程的文件写入速度
+            if (nextBuffer_) {
+                currentBuffer_ = std::move(nextBuffer_);
+            } else if (!spareBuffers_.empty()) {  /// 复用后端回收的缓冲
+                currentBuffer_ = std::move(spareBuffers_.back());
+                spareBuffers_.pop_back();
+            } else {  /// 前端写入太快，需要重新申请一块新的缓冲作为当前缓冲
+                // Rarely happens
+                currentBuffer_.reset(new Buffer);
+            }
+
+            /// 在新缓冲中预留，空缓冲一定放得下
+            currentBuffer_->tryReserve(maxLen, &offset);
+            wake = true;
+        }
+        /// 低延迟模式：空缓冲的第一行唤醒后端开始计时
+        if (offset == 0 && maxDelayMs_ > 0) {
+            firstLineMs_ = monotonicMs();
+            wake = true;
+        }
+        /// 越过阈值立即唤醒
+        if (notifyBytes_ > 0 && offset < notifyBytes_ &&
+            offset + maxLen >= notifyBytes_) {
+            flushNow_ = true;
+            wake = true;
+        }
+        line->data = currentBuffer_->data() + offset;
+        line->capacity = maxLen;
+        line->token = currentBuffer_.get();
+    }
+    /// 系统调用放在锁外
+    if (wake) wakeBackend();
+    return true;
+}
+
+/// @brief 前端线程调用，提交预留区域中实际写入的 len 字节，无需加锁
+void Lute::AsyncLogger::commit(const Logger::Reservation& line, int len) {
+    appendedLines_.inc();
+    appendedBytes_.inc(len);
+    /// 提交之后缓冲可能已被后端写出并复用，不能再访问 line
+    Buffer* buffer = static_cast<Buffer*>(line.token);
+    buffer->commit(static_cast<int>(line.data - buffer->data()),
+                   line.capacity, len);
+}
+
+void Lute::AsyncLogger::wakeBackend() {
+    wakeSeq_.fetch_add(1);
+    /// pairs with sleeping_ = true then the futex word check in waitForWork
+    if (sleeping_.load())
+        ::syscall(SYS_futex, &wakeSeq_, FUTEX_WAKE_PRIVATE, 1, nullptr,
+                  nullptr, 0);
+}
+
+///
+/// @brief 后端等待：缓冲写满、越过阈值、低延迟模式的最大延迟到期，
+///        或 flushInterval_ 秒超时
+///
+void Lute::AsyncLogger::waitForWork() {
+    while (running_) {
+        const uint32_t seq = wakeSeq_.load();
+        int64_t timeoutMs = int64_t(flushInterval_) * 1000;
+        bool idle = true;
+        {
+            MutexLockGuard lock(mutex_);
+            if (!buffers_.empty() || flushNow_) return;
+            if (maxDelayMs_ > 0 && currentBuffer_->length() > 0) {
+                timeoutMs = firstLineMs_ + maxDelayMs_ - monotonicMs();
+                if (timeoutMs <= 0) return;
+                idle = false;
+            }
         }
 
-        /// 日志文件写入
-        currentBuffer_->append(logline, static_cast<size_t>(len));
-        cond_.notify();
+        struct timespec timeout;
+        timeout.tv_sec = static_cast<time_t>(timeoutMs / 1000);
+        timeout.tv_nsec = static_cast<long>(timeoutMs % 1000 * 1000000);
+        sleeping_.store(true);
+        const long rc = ::syscall(SYS_futex, &wakeSeq_, FUTEX_WAIT_PRIVATE,
+                                  seq, &timeout, nullptr, 0);
+        const int savedErrno = errno;
+        sleeping_.store(false);
+        /// the flushInterval_ timeout writes whatever there is, as before
+        if (rc != 0 && savedErrno == ETIMEDOUT && idle) return;
     }
 }
 
@@ -575,6 +1103,7 @@ void Lute::AsyncLogger::threadFunc() {
 
     // LogFile output(basename_, rollSize_, false);
     LogFile output(basename_, rollSize_, false, flushInterval_);
+    output.setRollPeriod(rollPeriod_);
 
     BufferPtr newBuffer1(new Buffer);
     BufferPtr newBuffer2(new Buffer);
@@ -584,6 +1113,9 @@ void Lute::AsyncLogger::threadFunc() {
     /// 申请一块大小为16的缓冲集，一般只会用到2块，除非前端写入速度太快
     BufferVector buffersToWrite;
     buffersToWrite.reserve(16);
+    /// 本轮多出的缓冲，下次交换时放回 spareBuffers_
+    BufferVector spares;
+    spares.reserve(kMaxSpareBuffers);
 
     // currentBuffer_->length() 确保当前缓冲区数据写入完毕
     while (running_ || currentBuffer_->length() > 0) {
@@ -591,11 +1123,13 @@ void Lute::AsyncLogger::threadFunc() {
         assert(newBuffer2 && newBuffer2->length() == 0);
         assert(buffersToWrite.empty());
 
+        waitForWork();
+
         /// Swap out what need to be written, keep CS short
         {
             MutexLockGuard lock(mutex_);
-            if (buffers_.empty())  // unusual usage!
-                cond_.waitForSeconds(flushInterval_);
+            LUTE_TRACE_SCOPE("AsyncLogger::swap");
+            flushNow_ = false;
 
             /// 采用move 提高效率
             buffers_.push_back(std::move(currentBuffer_));
@@ -604,9 +1138,17 @@ void Lute::AsyncLogger::threadFunc() {
             /// 最核心操作，前后端缓冲交换
             buffersToWrite.swap(buffers_);
             if (!nextBuffer_) nextBuffer_ = std::move(newBuffer2);
+            for (auto& buffer : spares) {
+                if (spareBuffers_.size() >= kMaxSpareBuffers) break;
+                spareBuffers_.push_back(std::move(buffer));
+            }
         }
+        spares.clear();
 
         assert(!buffersToWrite.empty());
+        buffersInFlight_.set(static_cast<int64_t>(buffersToWrite.size()));
+        /// 等待前端提交已预留的区域
+        for (const auto& buffer : buffersToWrite) buffer->waitCommitted();
 
         /// 待写入缓冲集长度不对 输出错误
         /// 将错误数据写入文件，并裁剪待写入缓冲集
@@ -618,19 +1160,36 @@ void Lute::AsyncLogger::threadFunc() {
                      buffersToWrite.size() - 2);
             fputs(buf, stderr);
             output.append(buf, static_cast<int>(strlen(buf)));
+            droppedBuffers_.inc(
+                static_cast<int64_t>(buffersToWrite.size() - 2));
+            for (auto it = buffersToWrite.begin() + 2;
+                 it != buffersToWrite.end(); ++it) {
+                (*it)->forEachSegment([this](const char* data, int len) {
+                    droppedLines_.inc(std::count(data, data + len, '\n'));
+                });
+            }
             buffersToWrite.erase(buffersToWrite.begin() + 2,
                                  buffersToWrite.end());
         }
 
         /// 迭代待写入缓冲集，将缓冲日志写入文件系统
+        LUTE_TRACE_SCOPE("AsyncLogger::write");
         for (const auto& buffer : buffersToWrite) {
             // FIXME: use unbuffered stdio FILE ? or use ::writev ?
-            output.append(buffer->data(), buffer->length());
+            buffer->forEachSegment([&](const char* data, int len) {
+                output.append(data, len);
+                writtenBytes_.inc(len);
+            });
         }
 
-        if (buffersToWrite.size() > 2) {
-            // drop non-bzero-ed buffers, avoid trashing
-            buffersToWrite.resize(2);
+        /// keep a few of the extra buffers for the front end instead of
+        /// freeing them, the rest are dropped to bound the memory
+        while (buffersToWrite.size() > 2) {
+            if (spares.size() < kMaxSpareBuffers) {
+                buffersToWrite.back()->reset();
+                spares.push_back(std::move(buffersToWrite.back()));
+            }
+            buffersToWrite.pop_back();
         }
 
         if (!newBuffer1) {
@@ -653,3 +1212,45 @@ void Lute::AsyncLogger::threadFunc() {
 
     output.flush();
 }
+
+/// NOTE ----------- ShardedAsyncLogger -----------
+Lute::ShardedAsyncLogger::ShardedAsyncLogger(const std::string& basename,
+                                             off_t rollSize, int shards,
+                                             int flushInterval) {
+    assert(shards > 0);
+    shards_.reserve(static_cast<size_t>(shards));
+    for (int i = 0; i < shards; ++i) {
+        shards_.emplace_back(new AsyncLogger(
+            basename + "-" + std::to_string(i), rollSize, flushInterval));
+    }
+}
+
+int Lute::ShardedAsyncLogger::shardOf(const string_view& category) const {
+    /// FNV-1a, std::hash may differ between builds
+    uint32_t h = 2166136261u;
+    for (char c : category) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return static_cast<int>(h % static_cast<uint32_t>(shards_.size()));
+}
+
+void Lute::ShardedAsyncLogger::setMaxDelay(int ms) {
+    for (auto& shard : shards_) shard->setMaxDelay(ms);
+}
+
+void Lute::ShardedAsyncLogger::setNotifyBytes(int bytes) {
+    for (auto& shard : shards_) shard->setNotifyBytes(bytes);
+}
+
+void Lute::ShardedAsyncLogger::setRollPeriod(int seconds) {
+    for (auto& shard : shards_) shard->setRollPeriod(seconds);
+}
+
+void Lute::ShardedAsyncLogger::start() {
+    for (auto& shard : shards_) shard->start();
+}
+
+void Lute::ShardedAsyncLogger::stop() {
+    for (auto& shard : shards_) shard->stop();
+}
@@ -0,0 +1,405 @@
+#include <Base/logger.h>  // LogFile
+#include <Base/metrics.h>
+#include <Base/resourceSampler.h>  // ResourceSampler
+#include <Base/singleton.h>        // Singleton
+#include <Base/utils.h>            // integer2Str ProcessInfo
+
+#include <cmath>   // ceil
+#include <cstdio>  // fopen fwrite rename
+#include <mutex>   // call_once
+
+namespace Lute {
+namespace detail {
+    std::atomic<int> g_nextMetricShard(0);
+    __thread int t_metricShard = -1;
+
+    int metricShard() {
+        if (__builtin_expect(t_metricShard < 0, 0)) {
+            t_metricShard =
+                g_nextMetricShard.fetch_add(1, std::memory_order_relaxed) &
+                (kMetricShards - 1);
+        }
+        return t_metricShard;
+    }
+
+    void appendInteger(std::string* out, int64_t v) {
+        char buf[32];
+        size_t len = integer2Str(buf, v);
+        out->append(buf, len);
+    }
+
+    /// @brief Quantiles exposed for histograms, with their label text
+    const struct {
+        double q;
+        const char* label;
+        const char* jsonKey;
+    } kQuantiles[] = {
+        {0.5, "0.5", "p50"},
+        {0.9, "0.9", "p90"},
+        {0.99, "0.99", "p99"},
+        {0.999, "0.999", "p999"},
+    };
+
+    /// @brief Escape a Prometheus HELP text: only `\` and newline
+    void appendHelpEscaped(std::string* out, const std::string& s) {
+        for (char c : s) {
+            if (c == '\\') {
+                out->append("\\\\");
+            } else if (c == '\n') {
+                out->append("\\n");
+            } else {
+                out->push_back(c);
+            }
+        }
+    }
+
+    /// @brief Write `text` to `filename.tmp`, then rename it over `filename`
+    bool replaceFile(const std::string& filename, const std::string& text) {
+        std::string tmp = filename + ".tmp";
+        FILE* fp = ::fopen(tmp.c_str(), "we");
+        if (fp == nullptr) return false;
+        bool ok = ::fwrite(text.data(), 1, text.size(), fp) == text.size();
+        ok = (::fclose(fp) == 0) && ok;
+        return ok && ::rename(tmp.c_str(), filename.c_str()) == 0;
+    }
+}  // namespace detail
+}  // namespace Lute
+
+/// NOTE ----------- Counter -----------
+int64_t Lute::Counter::value() const {
+    int64_t sum = 0;
+    for (const auto& shard : shards_)
+        sum += shard.value.load(std::memory_order_relaxed);
+    return sum;
+}
+
+/// NOTE ----------- Histogram -----------
+void Lute::Histogram::snapshot(Snapshot* snap) const {
+    snap->count = 0;
+    snap->sum = 0;
+    for (auto& bucket : snap->buckets) bucket = 0;
+    for (const auto& shard : shards_) {
+        for (int i = 0; i < kNumBuckets; ++i) {
+            const uint64_t n =
+                shard.buckets[i].load(std::memory_order_relaxed);
+            snap->buckets[i] += n;
+            /// count is derived from buckets, so it always matches them
+            snap->count += n;
+        }
+        snap->sum += shard.sum.load(std::memory_order_relaxed);
+    }
+}
+
+int64_t Lute::Histogram::bucketUpperBound(int index) {
+    if (index < kSubBuckets) return index;
+    const int shift = index / kSubBuckets - 1;
+    const auto sub = static_cast<uint64_t>(index % kSubBuckets);
+    const uint64_t lower = (kSubBuckets + sub) << shift;
+    const uint64_t upper = lower + (static_cast<uint64_t>(1) << shift) - 1;
+    const auto limit = static_cast<uint64_t>(INT64_MAX);
+    return static_cast<int64_t>(upper > limit || upper < lower ? limit : upper);
+}
+
+int64_t Lute::Histogram::Snapshot::percentile(double q) const {
+    if (count == 0) return 0;
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    auto rank =
+        static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return bucketUpperBound(i);
+    }
+    return max();
+}
+
+int64_t Lute::Histogram::Snapshot::max() const {
+    for (int i = kNumBuckets - 1; i >= 0; --i) {
+        if (buckets[i]) return bucketUpperBound(i);
+    }
+    return 0;
+}
+
+/// NOTE ----------- MetricsRegistry -----------
+Lute::MetricsRegistry& Lute::MetricsRegistry::instance() {
+    return *Singleton<MetricsRegistry>::GetInstance();
+}
+
+Lute::MetricsRegistry::Entry& Lute::MetricsRegistry::getOrCreate(
+    const std::string& name, const std::string& help, Type type) {
+    auto it = metrics_.find(name);
+    if (it != metrics_.end()) {
+        if (it->second.type != type) {
+            ::fprintf(stderr, "metric %s registered with another type\n",
+                      name.c_str());
+            ::abort();
+        }
+        return it->second;
+    }
+
+    Entry& entry = metrics_[name];
+    entry.type = type;
+    entry.help = help;
+    switch (type) {
+        case Type::kCounter:
+            entry.counter.reset(new Counter);
+            break;
+        case Type::kGauge:
+            entry.gauge.reset(new Gauge);
+            break;
+        case Type::kHistogram:
+            entry.histogram.reset(new Histogram);
+            break;
+    }
+    return entry;
+}
+
+Lute::Counter& Lute::MetricsRegistry::counter(const std::string& name,
+                                              const std::string& help) {
+    MutexLockGuard lock(mutex_);
+    return *getOrCreate(name, help, Type::kCounter).counter;
+}
+
+Lute::Gauge& Lute::MetricsRegistry::gauge(const std::string& name,
+                                          const std::string& help) {
+    MutexLockGuard lock(mutex_);
+    return *getOrCreate(name, help, Type::kGauge).gauge;
+}
+
+Lute::Histogram& Lute::MetricsRegistry::histogram(const std::string& name,
+                                                  const std::string& help) {
+    MutexLockGuard lock(mutex_);
+    return *getOrCreate(name, help, Type::kHistogram).histogram;
+}
+
+///
+/// # HELP name help
+/// # TYPE name counter|gauge|summary
+/// name value
+///
+std::string Lute::MetricsRegistry::toPrometheus() const {
+    std::string out;
+    out.reserve(4096);
+    std::unique_ptr<Histogram::Snapshot> snap(new Histogram::Snapshot);
+
+    MutexLockGuard lock(mutex_);
+    for (const auto& kv : metrics_) {
+        const std::string& name = kv.first;
+        const Entry& entry = kv.second;
+        if (!entry.help.empty()) {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            detail::appendHelpEscaped(&out, entry.help);
+            out += '\n';
+        }
+
+        out += "# TYPE ";
+        out += name;
+        switch (entry.type) {
+            case Type::kCounter:
+                out += " counter\n";
+                out += name;
+                out += ' ';
+                detail::appendInteger(&out, entry.counter->value());
+                out += '\n';
+                break;
+            case Type::kGauge:
+                out += " gauge\n";
+                out += name;
+                out += ' ';
+                detail::appendInteger(&out, entry.gauge->value());
+                out += '\n';
+                break;
+            case Type::kHistogram:
+                out += " summary\n";
+                entry.histogram->snapshot(snap.get());
+                for (const auto& quantile : detail::kQuantiles) {
+                    out += name;
+                    out += "{quantile=\"";
+                    out += quantile.label;
+                    out += "\"} ";
+                    detail::appendInteger(&out, snap->percentile(quantile.q));
+                    out += '\n';
+                }
+                out += name;
+                out += "_sum ";
+                detail::appendInteger(&out, snap->sum);
+                out += '\n';
+                out += name;
+                out += "_count ";
+                detail::appendInteger(&out, static_cast<int64_t>(snap->count));
+                out += '\n';
+                break;
+        }
+    }
+    return out;
+}
+
+///
+/// {"name":{"type":"counter","value":1},
+///  "name2":{"type":"histogram","count":1,"sum":1,"p50":1,...,"max":1}}
+///
+std::string Lute::MetricsRegistry::toJson() const {
+    std::string out;
+    out.reserve(4096);
+    std::unique_ptr<Histogram::Snapshot> snap(new Histogram::Snapshot);
+
+    out += '{';
+    MutexLockGuard lock(mutex_);
+    bool first = true;
+    for (const auto& kv : metrics_) {
+        const Entry& entry = kv.second;
+        if (!first) out += ',';
+        first = false;
+
+        out += '"';
+        appendJsonEscaped(&out, kv.first);
+        out += "\":{\"type\":";
+        switch (entry.type) {
+            case Type::kCounter:
+                out += "\"counter\",\"value\":";
+                detail::appendInteger(&out, entry.counter->value());
+                break;
+            case Type::kGauge:
+                out += "\"gauge\",\"value\":";
+                detail::appendInteger(&out, entry.gauge->value());
+                break;
+            case Type::kHistogram:
+                entry.histogram->snapshot(snap.get());
+                out += "\"histogram\",\"count\":";
+                detail::appendInteger(&out, static_cast<int64_t>(snap->count));
+                out += ",\"sum\":";
+                detail::appendInteger(&out, snap->sum);
+                for (const auto& quantile : detail::kQuantiles) {
+                    out += ",\"";
+                    out += quantile.jsonKey;
+                    out += "\":";
+                    detail::appendInteger(&out, snap->percentile(quantile.q));
+                }
+                out += ",\"max\":";
+                detail::appendInteger(&out, snap->max());
+                break;
+        }
+        out += '}';
+    }
+    out += "}\n";
+    return out;
+}
+
+void Lute::MetricsRegistry::writeTo(LogFile& file, Format format) const {
+    std::string text = dump(format);
+    file.append(text.data(), static_cast<int>(text.size()));
+    file.flush();
+}
+
+bool Lute::MetricsRegistry::writeToFile(const std::string& filename,
+                                        Format format) const {
+    return detail::replaceFile(filename, dump(format));
+}
+
+/// NOTE ----------- MetricsReporter -----------
+Lute::MetricsReporter::MetricsReporter(MetricsRegistry& registry,
+                                       double interval, Sink sink,
+                                       MetricsRegistry::Format format)
+    : registry_(registry),
+      interval_(interval),
+      sink_(std::move(sink)),
+      format_(format),
+      running_(false),
+      thread_(std::bind(&MetricsReporter::threadFunc, this), "MetricsReport"),
+      mutex_(),
+      cond_(mutex_) {}
+
+Lute::MetricsReporter::Sink Lute::MetricsReporter::logFileSink(LogFile& file) {
+    LogFile* fp = &file;
+    return [fp](const std::string& text) {
+        fp->append(text.data(), static_cast<int>(text.size()));
+        fp->flush();
+    };
+}
+
+Lute::MetricsReporter::Sink Lute::MetricsReporter::fileSink(
+    const std::string& filename) {
+    return [filename](const std::string& text) {
+        detail::replaceFile(filename, text);
+    };
+}
+
+void Lute::MetricsReporter::start() {
+    assert(!running_);
+    running_ = true;
+    thread_.start();
+}
+
+void Lute::MetricsReporter::stop() {
+    {
+        /// under the lock: the notify can't fall between threadFunc's
+        /// running_ check and its wait
+        MutexLockGuard lock(mutex_);
+        running_ = false;
+        cond_.notify();
+    }
+    thread_.join();
+}
+
+void Lute::MetricsReporter::report() { sink_(registry_.dump(format_)); }
+
+void Lute::MetricsReporter::threadFunc() {
+    while (running_) {
+        {
+            MutexLockGuard lock(mutex_);
+            if (running_) cond_.waitForSeconds(interval_);
+        }
+        report();
+    }
+}
+
+/// NOTE ----------- Process metrics -----------
+void Lute::metrics::registerProcessMetrics(MetricsRegistry& registry) {
+    /// One sampler shared by all registries, refreshed in the background so
+    /// that exposition only reads its lock-free snapshot.
+    static ResourceSampler sampler(1.0);
+    static std::once_flag once;
+    std::call_once(once, [] {
+        sampler.sample();
+        sampler.start();
+    });
+
+    using Snapshot = ResourceSampler::Snapshot;
+    const struct {
+        const char* name;
+        const char* help;
+        int64_t Snapshot::*field;
+    } kGauges[] = {
+        {"lute_process_resident_memory_bytes", "Resident set size",
+         &Snapshot::rssBytes},
+        {"lute_process_virtual_memory_bytes", "Virtual memory size",
+         &Snapshot::vmBytes},
+        {"lute_process_cpu_user_ticks", "User mode CPU time in clock ticks",
+         &Snapshot::userTicks},
+        {"lute_process_cpu_system_ticks", "Kernel mode CPU time in clock ticks",
+         &Snapshot::systemTicks},
+        {"lute_process_minor_faults", "Page faults without IO",
+         &Snapshot::minorFaults},
+        {"lute_process_major_faults", "Page faults with IO",
+         &Snapshot::majorFaults},
+        {"lute_process_voluntary_ctxt_switches", "Voluntary context switches",
+         &Snapshot::voluntaryCtxSwitches},
+        {"lute_process_nonvoluntary_ctxt_switches",
+         "Involuntary context switches", &Snapshot::involuntaryCtxSwitches},
+        {"lute_process_threads", "Number of threads", &Snapshot::numThreads},
+        {"lute_process_open_fds", "Number of open file descriptors",
+         &Snapshot::openedFiles},
+    };
+    for (const auto& g : kGauges) {
+        int64_t Snapshot::*field = g.field;
+        registry.gauge(g.name, g.help).setCallback([field] {
+            return sampler.snapshot().*field;
+        });
+    }
+    registry.gauge("lute_process_start_time_seconds", "Process start time")
+        .set(ProcessInfo::startTime().secondsSinceEpoch());
+}
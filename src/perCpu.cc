@@ -0,0 +1,79 @@
+#include <Base/perCpu.h>
+#include <dirent.h>       // opendir readdir
+#include <sys/mman.h>     // mmap munmap
+#include <sys/syscall.h>  // SYS_mbind
+#include <unistd.h>       // sysconf syscall
+
+#include <cstdio>   // snprintf
+#include <cstdlib>  // atoi
+#include <cstring>  // strncmp
+#include <new>      // bad_alloc
+
+namespace Lute {
+namespace detail {
+    namespace {
+        /// from <linux/mempolicy.h>
+        const int kMpolPreferred = 1;
+
+        /// @brief Node of `cpu` from /sys/devices/system/cpu/cpuN/nodeM
+        int readNodeOfCpu(int cpu) {
+            char path[64];
+            ::snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d",
+                       cpu);
+            DIR* dir = ::opendir(path);
+            if (dir == nullptr) return 0;
+            int node = 0;
+            while (struct dirent* entry = ::readdir(dir)) {
+                if (::strncmp(entry->d_name, "node", 4) == 0 &&
+                    entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                    node = ::atoi(entry->d_name + 4);
+                    break;
+                }
+            }
+            ::closedir(dir);
+            return node;
+        }
+
+        CpuTopology* readTopology() {
+            auto* topo = new CpuTopology;
+            const long cpus = ::sysconf(_SC_NPROCESSORS_CONF);
+            topo->cpus = cpus > 0 ? static_cast<int>(cpus) : 1;
+            topo->nodes = 1;
+            topo->nodeOfCpu.resize(static_cast<size_t>(topo->cpus));
+            for (int cpu = 0; cpu < topo->cpus; ++cpu) {
+                const int node = readNodeOfCpu(cpu);
+                topo->nodeOfCpu[static_cast<size_t>(cpu)] = node;
+                if (node >= topo->nodes) topo->nodes = node + 1;
+            }
+            return topo;
+        }
+    }  // namespace
+
+    const CpuTopology& cpuTopology() {
+        /// leaked, PerCpu objects may be static
+        static const CpuTopology* topo = readTopology();
+        return *topo;
+    }
+
+    void* allocateOnNode(size_t bytes, int node) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+
+        /// pages are placed at first touch, before that the policy decides
+        if (cpuTopology().nodes > 1) {
+            const size_t kBits = 8 * sizeof(unsigned long);
+            unsigned long mask[16] = {};
+            if (static_cast<size_t>(node) < kBits * 16) {
+                mask[static_cast<size_t>(node) / kBits] |=
+                    1UL << (static_cast<size_t>(node) % kBits);
+                ::syscall(SYS_mbind, p, bytes, kMpolPreferred, mask,
+                          kBits * 16, 0);
+            }
+        }
+        return p;
+    }
+
+    void freeOnNode(void* p, size_t bytes) { ::munmap(p, bytes); }
+}  // namespace detail
+}  // namespace Lute
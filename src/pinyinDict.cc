@@ -0,0 +1,118 @@
+#include <Base/pinyinDict.h>
+
+#include <fstream>  // ifstream
+
+namespace Lute {
+
+PinyinDict::PinyinDict()
+    : ownedEntries_(kSize, 0),
+      owned_(true),
+      entries_(nullptr),
+      blob_(nullptr),
+      blobSize_(0),
+      size_(0) {
+    rebind();
+}
+
+PinyinDict::PinyinDict(const uint32_t* entries, const char* blob,
+                       size_t blobSize, size_t size)
+    : owned_(false),
+      entries_(entries),
+      blob_(blob),
+      blobSize_(blobSize),
+      size_(size) {}
+
+PinyinDict::PinyinDict(const PinyinDict& rhs)
+    : ownedEntries_(rhs.ownedEntries_),
+      ownedBlob_(rhs.ownedBlob_),
+      owned_(rhs.owned_),
+      entries_(rhs.entries_),
+      blob_(rhs.blob_),
+      blobSize_(rhs.blobSize_),
+      size_(rhs.size_) {
+    if (owned_) rebind();
+}
+
+PinyinDict& PinyinDict::operator=(const PinyinDict& rhs) {
+    if (this != &rhs) {
+        ownedEntries_ = rhs.ownedEntries_;
+        ownedBlob_ = rhs.ownedBlob_;
+        owned_ = rhs.owned_;
+        entries_ = rhs.entries_;
+        blob_ = rhs.blob_;
+        blobSize_ = rhs.blobSize_;
+        size_ = rhs.size_;
+        if (owned_) rebind();
+    }
+    return *this;
+}
+
+void PinyinDict::own() {
+    if (owned_) return;
+    ownedEntries_.assign(entries_, entries_ + kSize);
+    ownedBlob_.assign(blob_, blobSize_);
+    owned_ = true;
+    rebind();
+}
+
+void PinyinDict::rebind() {
+    entries_ = ownedEntries_.data();
+    blob_ = ownedBlob_.data();
+    blobSize_ = ownedBlob_.size();
+}
+
+void PinyinDict::add(uint32_t codepoint, const string_view& readings) {
+    const uint32_t index = codepoint - kFirst;
+    if (index >= kSize || readings.size() > 255) return;
+
+    /// the first reading and its tone digit
+    size_t first = readings.find(',');
+    if (first == string_view::npos) first = readings.size();
+    bool tone = false;
+    if (first > 0 && readings[first - 1] >= '0' && readings[first - 1] <= '9') {
+        --first;
+        tone = true;
+    }
+    if (first > kFirstMask) return;
+
+    own();
+    uint32_t& entry = ownedEntries_[index];
+    if (first == 0) {
+        if (entry != 0) --size_;
+        entry = 0;
+        return;
+    }
+
+    /// Reuse the same list if it is already pooled; ~2800 distinct lists
+    /// for ~20k characters
+    size_t offset = ownedBlob_.find(readings.data(), 0, readings.size());
+    if (offset == std::string::npos) {
+        offset = ownedBlob_.size();
+        if (offset + readings.size() > kOffsetMask + 1) return;
+        ownedBlob_.append(readings.data(), readings.size());
+        rebind();
+    }
+    if (entry == 0) ++size_;
+    entry = static_cast<uint32_t>(offset) |
+            (static_cast<uint32_t>(first) << kFirstShift) |
+            (tone ? kToneBit : 0) |
+            (static_cast<uint32_t>(readings.size()) << kLengthShift);
+}
+
+int PinyinDict::load(const std::string& path) {
+    std::ifstream is(path.c_str());
+    if (!is.is_open()) return -1;
+
+    std::string line;
+    while (std::getline(is, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        /// 王=wang2,wang4, the character is 3 bytes of UTF-8
+        if (line.size() < 5 || line[3] != '=') continue;
+        const uint32_t codepoint = decode3(line.data());
+        if (codepoint == 0) continue;
+        add(codepoint, string_view(line.data() + 4, line.size() - 4));
+    }
+    return 0;
+}
+
+}  // namespace Lute
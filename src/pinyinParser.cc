@@ -1,47 +1,28 @@
 #include <Base/pinyinParser.h>
+#include <Base/thread.h>  // Thread
+
+#include <cstring>  // memchr
+#include <memory>   // unique_ptr
+#include <thread>   // hardware_concurrency
+
+#if defined(__x86_64__)
+#include <emmintrin.h>  // SSE2
+#endif
 
 int Lute::PinyinParser::InitPinyinMap(std::string path) {
     if (path.empty()) {
-        std::cout << "path emtpy, invalid param" << std::endl;
-        return -1;
+        dict_ = PinyinDict::builtin();
+        return 0;
     }
 
-    // 读取拼音文件
-    std::ifstream is(path.c_str());
-    if (!is.is_open()) {
+    // 读取拼音文件，拼音文件格式：王=wang1,wang2，数字表示声调
+    // 发音有多个，我们只取一个，并去掉末尾声调
+    PinyinDict dict;
+    if (dict.load(path) != 0) {
         std::cout << "open file:" << path << " error" << std::endl;
         return -1;
     }
-
-    while (!is.eof()) {
-        std::string tmp_pinyin;
-
-        // 每次读取一行，这里拼音文件格式：王=wang1,wang2，数字表示声调
-        getline(is, tmp_pinyin);
-        // std::cout<<"getline:"<<tmp_pinyin<<std::endl;
-        if (tmp_pinyin.find("=") != std::string::npos) {
-            std::string zh, pinyin;
-            size_t i = tmp_pinyin.find_first_of('=');
-            if (i != std::string::npos && i != tmp_pinyin.size() - 1) {
-                // 发音有多个，我们只取一个
-                zh.assign(tmp_pinyin, 0, i);
-                pinyin.assign(tmp_pinyin, i + 1, tmp_pinyin.size() - i - 1);
-
-                // 去掉拼音末尾声调
-                if (pinyin.find(",") != std::string::npos) {
-                    size_t j = pinyin.find(",");
-                    pinyin.assign(pinyin, 0, j - 1);
-                } else {
-                    pinyin.assign(pinyin.begin(), pinyin.end() - 1);
-                }
-                // 取出来后放到字典里
-                map_[zh] = pinyin;
-            }
-        }
-    }
-
-    // 关闭文件
-    is.close();
+    dict_ = dict;
     return 0;
 }
 
@@ -51,87 +32,241 @@ int Lute::PinyinParser::ConvertZh2Pinyin(std::string& src, std::string& dst) {
         return -1;
     }
 
-    {
-        size_t i = 0;
-        std::string tmp_str;
-
-        // 逐个字符检查
-        while (i < src.length()) {
-            try {
-                tmp_str.clear();
-                const char* p = &src.at(i);
-                // 中文占用三字节，utf8中三字节编码第一个字节前四位是1110
-                if ((*p & 0xF0) == 0xE0 && IsZh(p)) {
-                    tmp_str.append(&src.at(i), 3);
-                    // 从字典里找对应的拼音
-                    if (map_.find(tmp_str) != map_.end()) {
-                        dst.append(map_[tmp_str]);
-                    } else {
-                        std::cout << "can't find zh pinyin,zh:" << tmp_str
-                                  << std::endl;
-                        dst.append(tmp_str);
-                    }
-                    i += 3;
-                } else {
-                    dst.append(p, 1);
-                    i += 1;
+    // 查不到的汉字原样输出，只计数不打印
+    PinyinStats stats;
+    convert(src, &dst, &stats);
+    misses_.fetch_add(stats.misses, std::memory_order_relaxed);
+    return 0;
+}
+
+namespace {
+/// @brief Length of the run of ASCII bytes at the start of [p, p + n)
+inline size_t asciiRun(const char* p, size_t n) {
+    size_t i = 0;
+#if defined(__x86_64__)
+    for (; i + 16 <= n; i += 16) {
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))));
+        if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+#endif
+    while (i < n && static_cast<unsigned char>(p[i]) < 0x80) ++i;
+    return i;
+}
+
+/// @brief Length of the UTF-8 sequence at p, 0 if malformed
+inline size_t sequenceLength(const char* p, size_t n) {
+    const auto lead = static_cast<unsigned char>(p[0]);
+    size_t len = lead >= 0xF8 ? 0 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3
+               : lead >= 0xC0 ? 2 : 0;
+    if (len > n) return 0;
+    for (size_t i = 1; i < len; ++i) {
+        if ((static_cast<unsigned char>(p[i]) & 0xC0) != 0x80) return 0;
+    }
+    return len;
+}
+
+const size_t kMinBatchPerThread = 256;
+
+///
+/// @brief The single pass over `src` behind every mode: `text(p, n)` for
+///        bytes copied as is, `character(p, codepoint, pinyin)` for
+///        characters with a reading in `dict` (3 bytes at p)
+///
+template <typename Text, typename Character>
+inline void scan(const Lute::PinyinDict& dict, const Lute::string_view& src,
+                 Text&& text, Character&& character, Lute::PinyinStats* stats) {
+    Lute::PinyinStats local;
+    const char* p = src.data();
+    const char* const end = p + src.size();
+    while (p < end) {
+        const size_t run = asciiRun(p, static_cast<size_t>(end - p));
+        if (run > 0) {
+            text(p, run);
+            p += run;
+            if (p == end) break;
+        }
+
+        const size_t len = sequenceLength(p, static_cast<size_t>(end - p));
+        if (len == 3) {
+            const uint32_t codepoint = Lute::PinyinDict::decode3(p);
+            if (codepoint - Lute::PinyinDict::kFirst < Lute::PinyinDict::kSize) {
+                const Lute::string_view pinyin = dict.lookup(codepoint);
+                if (!pinyin.empty()) {
+                    character(p, codepoint, pinyin);
+                    ++local.converted;
+                    p += 3;
+                    continue;
                 }
-            } catch (...) {
-                std::cout << "exception occurs" << std::endl;
-                return -1;
+                ++local.misses;
             }
+        } else if (len == 0) {
+            ++local.invalid;
+            text(p++, 1);
+            continue;
         }
+        text(p, len);
+        p += len;
     }
+    if (stats) *stats += local;
+}
+}  // namespace
 
-    return 0;
+void Lute::PinyinResult::clear() {
+    plain.clear();
+    tone.clear();
+    initials.clear();
+    segments.clear();
+}
+
+void Lute::PinyinParser::convert(const string_view& src, std::string* out,
+                                 PinyinStats* stats) const {
+    scan(
+        dict_, src, [out](const char* p, size_t n) { out->append(p, n); },
+        [out](const char*, uint32_t, const string_view& pinyin) {
+            out->append(pinyin.data(), pinyin.size());
+        },
+        stats);
+}
+
+void Lute::PinyinParser::convert(const string_view& src, unsigned modes,
+                                 PinyinResult* result,
+                                 PinyinStats* stats) const {
+    const bool plain = modes & kPlain;
+    const bool tone = modes & kTone;
+    const bool initials = modes & kInitials;
+    const bool segments = modes & kSegments;
+    const char* const base = src.data();
+
+    auto segment = [result, base](const char* p, size_t n,
+                                  const string_view& readings) {
+        PinyinSegment seg;
+        seg.begin = static_cast<uint32_t>(p - base);
+        seg.end = static_cast<uint32_t>(p - base + n);
+        seg.plain = static_cast<uint32_t>(result->plain.size());
+        seg.tone = static_cast<uint32_t>(result->tone.size());
+        seg.initials = static_cast<uint32_t>(result->initials.size());
+        seg.readings = readings;
+        result->segments.push_back(seg);
+    };
+
+    scan(
+        dict_, src,
+        [&](const char* p, size_t n) {
+            if (segments) {
+                /// consecutive text is one segment
+                PinyinSegment* last = result->segments.empty()
+                                          ? nullptr
+                                          : &result->segments.back();
+                if (last && last->readings.empty() &&
+                    last->end == static_cast<uint32_t>(p - base))
+                    last->end += static_cast<uint32_t>(n);
+                else
+                    segment(p, n, string_view());
+            }
+            if (plain) result->plain.append(p, n);
+            if (tone) result->tone.append(p, n);
+            if (initials) result->initials.append(p, n);
+        },
+        [&](const char* p, uint32_t codepoint, const string_view& pinyin) {
+            if (segments) segment(p, 3, dict_.readings(codepoint));
+            if (plain) result->plain.append(pinyin.data(), pinyin.size());
+            if (tone) {
+                const string_view toned = dict_.lookupTone(codepoint);
+                result->tone.append(toned.data(), toned.size());
+            }
+            if (initials) result->initials.push_back(pinyin[0]);
+        },
+        stats);
+}
+
+void Lute::PinyinParser::convertBatch(const std::vector<std::string>& inputs,
+                                      PinyinArena* arena, int threads,
+                                      PinyinStats* stats) const {
+    arena->records_.clear();
+    for (const std::string& input : inputs)
+        arena->records_.emplace_back(input.data(), input.size());
+    convertRecords(arena, threads, stats);
 }
 
-bool Lute::PinyinParser::IsZh(const char* p) {
-    if (NULL == p) {
-        std::cout << "input param null" << std::endl;
-        return false;
+void Lute::PinyinParser::convertLines(const string_view& buffer,
+                                      PinyinArena* arena, int threads,
+                                      PinyinStats* stats) const {
+    arena->records_.clear();
+    const char* p = buffer.data();
+    const char* const end = p + buffer.size();
+    while (p < end) {
+        const void* nl = ::memchr(p, '\n', static_cast<size_t>(end - p));
+        const char* lineEnd = nl ? static_cast<const char*>(nl) : end;
+        arena->records_.emplace_back(p, static_cast<size_t>(lineEnd - p));
+        p = lineEnd + 1;
     }
+    convertRecords(arena, threads, stats);
+}
 
-    // 中文unicode编码范围是0X4E00~0X9FA5,即utf8范围0xe4b880 ~ 0xe9baa5
-    // 使用utf8编码占3个字节，下面是分别对三个字节校验，utf8编码介绍
-    // javascript:void(0)
+void Lute::PinyinParser::convertRecords(PinyinArena* arena, int threads,
+                                        PinyinStats* stats) const {
+    const std::vector<string_view>& records = arena->records_;
+    const size_t n = records.size();
 
-    if ((*p & 0xF0) == 0xE0) {
-        if (*(p + 1) == '\0' || *(p + 2) == '\0') {
-            return false;
-        }
-        unsigned char v = *p;
-        unsigned char v1 = *(p + 1);
-        unsigned char v2 = *(p + 2);
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    const size_t maxThreads = (n + kMinBatchPerThread - 1) / kMinBatchPerThread;
+    if (static_cast<size_t>(threads) > maxThreads)
+        threads = static_cast<int>(maxThreads);
 
-        if ((v1 & 0xC0) != 0x80 || (v2 & 0xC0) != 0x80) {
-            return false;
+    if (threads <= 1) {
+        PinyinStats local;
+        for (const string_view& record : records) {
+            convert(record, &arena->data_, &local);
+            arena->offsets_.push_back(arena->data_.size());
         }
+        if (stats) *stats += local;
+        return;
+    }
 
-        if (v < 0xE4) {
-            return false;
-        }
-        if (v == 0xE4 && v1 < 0xB8) {
-            return false;
-        }
-        if (v == 0xE4 && v1 == 0xB8 && v2 < 0x80) {
-            return false;
-        }
+    /// Contiguous ranges of about the same number of input bytes
+    size_t total = 0;
+    for (const string_view& record : records) total += record.size();
+    std::vector<size_t> bounds(1, 0);
+    size_t acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+        acc += records[i].size();
+        if (acc * static_cast<size_t>(threads) >= total * bounds.size() &&
+            bounds.size() < static_cast<size_t>(threads))
+            bounds.push_back(i + 1);
+    }
+    bounds.push_back(n);
 
-        if (v > 0xE9) {
-            return false;
-        }
-        if (v == 0xE9 && v1 > 0xBE) {
-            return false;
-        }
-        if (v == 0xE9 && v1 == 0xBE && v2 > 0xB5) {
-            return false;
+    const size_t numChunks = bounds.size() - 1;
+    if (arena->chunks_.size() < numChunks) arena->chunks_.resize(numChunks);
+    auto work = [this, arena, &records, &bounds](size_t c) {
+        PinyinArena::Chunk& chunk = arena->chunks_[c];
+        chunk.data.clear();
+        chunk.ends.clear();
+        chunk.stats = PinyinStats();
+        for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+            convert(records[i], &chunk.data, &chunk.stats);
+            chunk.ends.push_back(chunk.data.size());
         }
+    };
 
-        p += 3;
-
-        return true;
+    std::vector<std::unique_ptr<Thread>> workers;
+    for (size_t c = 1; c < numChunks; ++c) {
+        workers.emplace_back(new Thread(std::bind(work, c), "PinyinBatch"));
+        workers.back()->start();
     }
+    work(0);
+    for (auto& worker : workers) worker->join();
 
-    return false;
+    size_t bytes = arena->data_.size();
+    for (size_t c = 0; c < numChunks; ++c) bytes += arena->chunks_[c].data.size();
+    arena->data_.reserve(bytes);
+    arena->offsets_.reserve(arena->offsets_.size() + n);
+    for (size_t c = 0; c < numChunks; ++c) {
+        const PinyinArena::Chunk& chunk = arena->chunks_[c];
+        const size_t base = arena->data_.size();
+        arena->data_.append(chunk.data);
+        for (size_t e : chunk.ends) arena->offsets_.push_back(base + e);
+        if (stats) *stats += chunk.stats;
+    }
 }
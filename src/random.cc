@@ -0,0 +1,199 @@
+#include <Base/random.h>
+#include <time.h>    // clock_gettime
+#include <unistd.h>  // getpid
+
+#include <atomic>   // atomic
+#include <cstring>  // memcpy
+
+namespace Lute {
+
+void Xoshiro256ss::jump() {
+    static const uint64_t kJump[] = {0x180ec6d33cfd0abaULL,
+                                     0xd5a61266f0c9392cULL,
+                                     0xa9582618e03fc9aaULL,
+                                     0x39abdc4529b1661cULL};
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (uint64_t jump : kJump) {
+        for (int b = 0; b < 64; ++b) {
+            if (jump & (uint64_t(1) << b)) {
+                for (int i = 0; i < 4; ++i) s[i] ^= s_[i];
+            }
+            (*this)();
+        }
+    }
+    for (int i = 0; i < 4; ++i) s_[i] = s[i];
+}
+
+namespace {
+    const int kLanes = 8;
+
+    /// Structure of arrays so each step is a straight loop over the lanes
+    struct BulkState {
+        uint64_t s0[kLanes];
+        uint64_t s1[kLanes];
+        uint64_t s2[kLanes];
+        uint64_t s3[kLanes];
+    };
+
+    __thread BulkState t_bulk;
+    __thread bool t_bulkSeeded = false;
+
+    /// Lane i continues from threadRandom() jumped i + 1 times
+    void seedBulk() {
+        Xoshiro256ss rng = threadRandom();
+        for (int i = 0; i < kLanes; ++i) {
+            rng.jump();
+            const uint64_t* s = rng.state();
+            t_bulk.s0[i] = s[0];
+            t_bulk.s1[i] = s[1];
+            t_bulk.s2[i] = s[2];
+            t_bulk.s3[i] = s[3];
+        }
+        t_bulkSeeded = true;
+    }
+
+    /// 4 x 64-bit lanes: one AVX2 register, two SSE2 registers. The
+    /// helpers taking them are always inlined, their ABI never matters.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+    typedef uint64_t u64x4 __attribute__((vector_size(32), aligned(8)));
+
+    __attribute__((always_inline)) inline u64x4 rotl(u64x4 x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    /// xoshiro256** step on 4 lanes; * 5 and * 9 as shift + add, AVX2 has
+    /// no 64-bit multiply
+    __attribute__((always_inline)) inline u64x4 next(u64x4& s0, u64x4& s1,
+                                                     u64x4& s2, u64x4& s3) {
+        const u64x4 x = (s1 << 2) + s1;
+        const u64x4 r = rotl(x, 7);
+        const u64x4 result = (r << 3) + r;
+        const u64x4 t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rotl(s3, 45);
+        return result;
+    }
+
+    /// `blocks` x kLanes words, xoshiro256** in every lane
+    __attribute__((always_inline)) inline void fillBlocks(BulkState& st,
+                                                          uint64_t* out,
+                                                          size_t blocks) {
+        static_assert(kLanes == 8, "two vectors of 4 lanes");
+        u64x4 a0, a1, a2, a3, b0, b1, b2, b3;
+        ::memcpy(&a0, st.s0, sizeof a0);
+        ::memcpy(&b0, st.s0 + 4, sizeof b0);
+        ::memcpy(&a1, st.s1, sizeof a1);
+        ::memcpy(&b1, st.s1 + 4, sizeof b1);
+        ::memcpy(&a2, st.s2, sizeof a2);
+        ::memcpy(&b2, st.s2 + 4, sizeof b2);
+        ::memcpy(&a3, st.s3, sizeof a3);
+        ::memcpy(&b3, st.s3 + 4, sizeof b3);
+        for (size_t b = 0; b < blocks; ++b, out += kLanes) {
+            const u64x4 ra = next(a0, a1, a2, a3);
+            const u64x4 rb = next(b0, b1, b2, b3);
+            ::memcpy(out, &ra, sizeof ra);
+            ::memcpy(out + 4, &rb, sizeof rb);
+        }
+        ::memcpy(st.s0, &a0, sizeof a0);
+        ::memcpy(st.s0 + 4, &b0, sizeof b0);
+        ::memcpy(st.s1, &a1, sizeof a1);
+        ::memcpy(st.s1 + 4, &b1, sizeof b1);
+        ::memcpy(st.s2, &a2, sizeof a2);
+        ::memcpy(st.s2 + 4, &b2, sizeof b2);
+        ::memcpy(st.s3, &a3, sizeof a3);
+        ::memcpy(st.s3 + 4, &b3, sizeof b3);
+    }
+
+    void fillBlocksDefault(BulkState& st, uint64_t* out, size_t blocks) {
+        fillBlocks(st, out, blocks);
+    }
+
+#if defined(__x86_64__)
+    __attribute__((target("avx2"))) void fillBlocksAvx2(BulkState& st,
+                                                        uint64_t* out,
+                                                        size_t blocks) {
+        fillBlocks(st, out, blocks);
+    }
+#endif
+
+    using FillFunc = void (*)(BulkState&, uint64_t*, size_t);
+
+    /// Picked once on first use, AVX2 if the CPU has it
+    FillFunc fillKernel() {
+        static const FillFunc kernel = [] {
+#if defined(__x86_64__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return &fillBlocksAvx2;
+#endif
+            return &fillBlocksDefault;
+        }();
+        return kernel;
+    }
+
+    uint64_t processSeed() {
+        struct timespec ts {};
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        SplitMix64 sm(static_cast<uint64_t>(ts.tv_sec) * 1000000000 +
+                      static_cast<uint64_t>(ts.tv_nsec));
+        return sm() ^ (static_cast<uint64_t>(::getpid()) << 32);
+    }
+}  // namespace
+
+namespace detail {
+    __thread Xoshiro256ss t_random;
+    __thread bool t_randomSeeded = false;
+
+    void seedThreadRandom() {
+        static const uint64_t kProcessSeed = processSeed();
+        static std::atomic<uint64_t> threads(0);
+        SplitMix64 sm(kProcessSeed +
+                      threads.fetch_add(1, std::memory_order_relaxed));
+        t_random.seed(sm());
+        t_randomSeeded = true;
+    }
+}  // namespace detail
+
+void seedThreadRandom(uint64_t seed) {
+    detail::t_random.seed(seed);
+    detail::t_randomSeeded = true;
+    t_bulkSeeded = false;
+}
+
+void fillRandom(uint64_t* data, size_t n) {
+    if (__builtin_expect(!t_bulkSeeded, 0)) seedBulk();
+    const size_t blocks = n / kLanes;
+    if (blocks > 0) fillKernel()(t_bulk, data, blocks);
+    const size_t rest = n - blocks * kLanes;
+    if (rest > 0) {
+        uint64_t tail[kLanes];
+        fillBlocksDefault(t_bulk, tail, 1);
+        ::memcpy(data + blocks * kLanes, tail, rest * sizeof(uint64_t));
+    }
+}
+
+void fillRandom(void* buf, size_t bytes) {
+    auto* p = static_cast<unsigned char*>(buf);
+    /// whole words straight into an aligned destination, bounce otherwise
+    if (reinterpret_cast<uintptr_t>(p) % alignof(uint64_t) == 0) {
+        const size_t words = bytes / sizeof(uint64_t);
+        fillRandom(reinterpret_cast<uint64_t*>(p), words);
+        p += words * sizeof(uint64_t);
+        bytes -= words * sizeof(uint64_t);
+    }
+    uint64_t chunk[64];
+    while (bytes > 0) {
+        const size_t len = bytes < sizeof chunk ? bytes : sizeof chunk;
+        fillRandom(chunk, (len + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        ::memcpy(p, chunk, len);
+        p += len;
+        bytes -= len;
+    }
+}
+
+}  // namespace Lute
@@ -0,0 +1,214 @@
+#include <Base/resourceSampler.h>
+#include <Base/timestamp.h>  // Timestamp
+#include <Base/utils.h>      // ProcessInfo
+#include <dirent.h>          // dirent64
+#include <fcntl.h>           // open O_RDONLY O_CLOEXEC O_DIRECTORY
+#include <sys/syscall.h>     // SYS_getdents64
+#include <unistd.h>          // pread lseek close syscall
+
+#include <cstring>  // memmem memrchr
+#include <ctime>    // clock_gettime CLOCK_THREAD_CPUTIME_ID
+
+namespace Lute {
+namespace detail {
+    static_assert(sizeof(ResourceSampler::Snapshot) % sizeof(int64_t) == 0,
+                  "Snapshot must only hold int64_t fields");
+
+    /// @brief Parse an unsigned decimal at `p`, skipping leading blanks.
+    /// @return The first character after the number
+    const char* parseInt64(const char* p, const char* end, int64_t* value) {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        int64_t v = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            v = v * 10 + (*p - '0');
+            ++p;
+        }
+        *value = v;
+        return p;
+    }
+
+    /// @brief Skip `n` blank separated fields
+    const char* skipFields(const char* p, const char* end, int n) {
+        while (n-- > 0 && p < end) {
+            while (p < end && *p == ' ') ++p;
+            while (p < end && *p != ' ') ++p;
+        }
+        return p;
+    }
+
+    /// @brief Find "key" in /proc/.../status content and parse its value
+    bool findStatusValue(const char* buf, size_t len, const char* key,
+                         size_t keyLen, int64_t* value) {
+        const void* pos = ::memmem(buf, len, key, keyLen);
+        if (pos == nullptr) return false;
+        parseInt64(static_cast<const char*>(pos) + keyLen, buf + len, value);
+        return true;
+    }
+
+    int openProc(const char* path, int flags = 0) {
+        return ::open(path, O_RDONLY | O_CLOEXEC | flags);
+    }
+}  // namespace detail
+}  // namespace Lute
+
+Lute::ResourceSampler::ResourceSampler(double interval)
+    : interval_(interval),
+      statFd_(detail::openProc("/proc/self/stat")),
+      statusFd_(detail::openProc("/proc/self/status")),
+      fdDirFd_(detail::openProc("/proc/self/fd", O_DIRECTORY)),
+      running_(false),
+      thread_(std::bind(&ResourceSampler::threadFunc, this), "ResSampler"),
+      mutex_(),
+      cond_(mutex_),
+      seq_(0) {
+    for (auto& field : fields_) field.store(0, std::memory_order_relaxed);
+}
+
+Lute::ResourceSampler::~ResourceSampler() {
+    if (running_) stop();
+    if (statFd_ >= 0) ::close(statFd_);
+    if (statusFd_ >= 0) ::close(statusFd_);
+    if (fdDirFd_ >= 0) ::close(fdDirFd_);
+}
+
+void Lute::ResourceSampler::start() {
+    assert(!running_);
+    running_ = true;
+    thread_.start();
+}
+
+void Lute::ResourceSampler::stop() {
+    {
+        /// under the lock: the notify can't fall between threadFunc's
+        /// running_ check and its wait
+        MutexLockGuard lock(mutex_);
+        running_ = false;
+        cond_.notify();
+    }
+    thread_.join();
+}
+
+void Lute::ResourceSampler::threadFunc() {
+    while (running_) {
+        sample();
+        MutexLockGuard lock(mutex_);
+        if (running_) cond_.waitForSeconds(interval_);
+    }
+}
+
+bool Lute::ResourceSampler::sample(Snapshot* snap) {
+    Snapshot s{};
+    bool ok;
+    {
+        /// buf_ is shared by the sampling thread and direct callers
+        MutexLockGuard lock(mutex_);
+        s.sampleTime = Timestamp::now().microSecondsSinceEpoch();
+        ok = readStat(&s);
+        ok = readStatus(&s) && ok;
+        s.openedFiles = countOpenedFiles();
+        /// single writer for the seqlock
+        if (ok) publish(s);
+    }
+    if (snap) *snap = s;
+    return ok;
+}
+
+///
+/// /proc/self/stat: pid (comm) state ppid ... , fields after ')' are
+///   [0]state [7]minflt [9]majflt [11]utime [12]stime [17]num_threads
+///   [20]vsize [21]rss(pages)
+///
+bool Lute::ResourceSampler::readStat(Snapshot* snap) {
+    if (statFd_ < 0) return false;
+    ssize_t n = ::pread(statFd_, buf_, sizeof buf_, 0);
+    if (n <= 0) return false;
+
+    const char* end = buf_ + n;
+    /// comm may contain ' ' and ')', so search from the right
+    const void* rp = ::memrchr(buf_, ')', static_cast<size_t>(n));
+    if (rp == nullptr) return false;
+    const char* p = static_cast<const char*>(rp) + 1;
+
+    int64_t pages = 0;
+    p = detail::skipFields(p, end, 7);  // state .. flags
+    p = detail::parseInt64(p, end, &snap->minorFaults);
+    p = detail::skipFields(p, end, 1);  // cminflt
+    p = detail::parseInt64(p, end, &snap->majorFaults);
+    p = detail::skipFields(p, end, 1);  // cmajflt
+    p = detail::parseInt64(p, end, &snap->userTicks);
+    p = detail::parseInt64(p, end, &snap->systemTicks);
+    p = detail::skipFields(p, end, 4);  // cutime cstime priority nice
+    p = detail::parseInt64(p, end, &snap->numThreads);
+    p = detail::skipFields(p, end, 2);  // itrealvalue starttime
+    p = detail::parseInt64(p, end, &snap->vmBytes);
+    detail::parseInt64(p, end, &pages);
+    snap->rssBytes = pages * ProcessInfo::pageSize();
+    return true;
+}
+
+bool Lute::ResourceSampler::readStatus(Snapshot* snap) {
+    if (statusFd_ < 0) return false;
+    ssize_t n = ::pread(statusFd_, buf_, sizeof buf_, 0);
+    if (n <= 0) return false;
+
+    const auto len = static_cast<size_t>(n);
+    static const char kVoluntary[] = "\nvoluntary_ctxt_switches:";
+    static const char kInvoluntary[] = "\nnonvoluntary_ctxt_switches:";
+    bool ok = detail::findStatusValue(buf_, len, kVoluntary,
+                                      sizeof kVoluntary - 1,
+                                      &snap->voluntaryCtxSwitches);
+    ok = detail::findStatusValue(buf_, len, kInvoluntary,
+                                 sizeof kInvoluntary - 1,
+                                 &snap->involuntaryCtxSwitches) &&
+         ok;
+    return ok;
+}
+
+/// @note Counts the sampler's own fds too, like ProcessInfo::openedFiles()
+int64_t Lute::ResourceSampler::countOpenedFiles() {
+    if (fdDirFd_ < 0 || ::lseek(fdDirFd_, 0, SEEK_SET) < 0) return 0;
+
+    int64_t count = 0;
+    for (;;) {
+        long n = ::syscall(SYS_getdents64, fdDirFd_, buf_, sizeof buf_);
+        if (n <= 0) break;
+        for (long off = 0; off < n;) {
+            const auto* d =
+                reinterpret_cast<const struct dirent64*>(buf_ + off);
+            if (d->d_name[0] >= '0' && d->d_name[0] <= '9') ++count;
+            off += d->d_reclen;
+        }
+    }
+    return count;
+}
+
+void Lute::ResourceSampler::publish(const Snapshot& snap) {
+    const auto* src = reinterpret_cast<const int64_t*>(&snap);
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < kNumFields; ++i)
+        fields_[i].store(src[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+}
+
+Lute::ResourceSampler::Snapshot Lute::ResourceSampler::snapshot() const {
+    Snapshot snap{};
+    auto* dst = reinterpret_cast<int64_t*>(&snap);
+    uint64_t before, after;
+    do {
+        before = seq_.load(std::memory_order_acquire);
+        for (int i = 0; i < kNumFields; ++i)
+            dst[i] = fields_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = seq_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return snap;
+}
+
+int64_t Lute::ResourceSampler::threadCpuTimeNanos() {
+    struct timespec ts {};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    const int64_t kNanoSecondsPerSecond = 1E9;
+    return static_cast<int64_t>(ts.tv_sec) * kNanoSecondsPerSecond + ts.tv_nsec;
+}
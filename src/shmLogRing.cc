@@ -0,0 +1,277 @@
+#include <Base/shmLogRing.h>
+#include <fcntl.h>        // O_CREAT
+#include <linux/futex.h>  // FUTEX_WAIT
+#include <pthread.h>      // pthread_atfork
+#include <signal.h>       // kill
+#include <sys/mman.h>     // shm_open mmap
+#include <sys/stat.h>     // fstat
+#include <sys/syscall.h>  // SYS_futex
+#include <time.h>         // timespec
+#include <unistd.h>       // ftruncate getpid
+
+#include <algorithm>  // min
+#include <cassert>    // assert
+#include <cerrno>     // errno
+#include <cstring>    // memcpy
+#include <mutex>      // call_once
+
+namespace Lute {
+namespace {
+    const uint32_t kMagic = 0x4c555445;  // "LUTE"
+    const uint32_t kVersion = 1;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "the ring is shared between processes");
+    static_assert(sizeof(detail::ShmRingHeader) % ShmLogRing::kAlign == 0,
+                  "records start aligned");
+    static_assert(sizeof(detail::ShmRingRecord) == ShmLogRing::kAlign,
+                  "a line starts right after its header");
+
+    /// getpid() is a syscall, cache it per process
+    pid_t g_pid;
+    void refreshPid() { g_pid = ::getpid(); }
+    void initPid() {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            refreshPid();
+            ::pthread_atfork(nullptr, nullptr, refreshPid);
+        });
+    }
+
+    uint64_t spanOf(int len) {
+        const uint64_t bytes =
+            sizeof(detail::ShmRingRecord) + static_cast<uint64_t>(len);
+        return (bytes + ShmLogRing::kAlign - 1) & ~(ShmLogRing::kAlign - 1);
+    }
+
+    /// @brief Map all of `fd`, which it closes
+    void* mapShared(int fd, size_t bytes) {
+        void* memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0);
+        const int savedErrno = errno;
+        ::close(fd);
+        errno = savedErrno;
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    /// @brief A header a ring of `bytes` can trust
+    bool validHeader(const detail::ShmRingHeader* header, size_t bytes) {
+        const uint64_t capacity = header->capacity;
+        return header->magic.load(std::memory_order_acquire) == kMagic &&
+               header->version == kVersion &&
+               capacity >= ShmLogRing::kMinCapacity &&
+               (capacity & (capacity - 1)) == 0 &&
+               bytes == sizeof(detail::ShmRingHeader) + capacity;
+    }
+}  // namespace
+
+ShmLogRing::ShmLogRing(void* memory, size_t bytes)
+    : memory_(memory),
+      bytes_(bytes),
+      header_(static_cast<detail::ShmRingHeader*>(memory)),
+      data_(static_cast<char*>(memory) + sizeof(detail::ShmRingHeader)),
+      capacity_(static_cast<size_t>(header_->capacity)) {
+    initPid();
+}
+
+ShmLogRing::~ShmLogRing() { ::munmap(memory_, bytes_); }
+
+std::unique_ptr<ShmLogRing> ShmLogRing::create(const std::string& name,
+                                               size_t capacity) {
+    size_t rounded = kMinCapacity;
+    while (rounded < capacity) rounded <<= 1;
+    const size_t bytes = sizeof(detail::ShmRingHeader) + rounded;
+
+    /// a ring left by the previous consumer: carry on draining it
+    std::unique_ptr<ShmLogRing> ring = open(name);
+    if (ring && ring->capacity_ == rounded) return ring;
+    ring.reset();
+
+    ::shm_unlink(name.c_str());
+    const int fd =
+        ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0) return nullptr;
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        const int savedErrno = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        errno = savedErrno;
+        return nullptr;
+    }
+    void* memory = mapShared(fd, bytes);
+    if (memory == nullptr) return nullptr;
+
+    /// ftruncate zero-fills: cursors at 0, no tag matches an empty record
+    auto* header = static_cast<detail::ShmRingHeader*>(memory);
+    header->version = kVersion;
+    header->capacity = rounded;
+    header->magic.store(kMagic, std::memory_order_release);
+    return std::unique_ptr<ShmLogRing>(new ShmLogRing(memory, bytes));
+}
+
+std::unique_ptr<ShmLogRing> ShmLogRing::open(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(detail::ShmRingHeader)) {
+        ::close(fd);
+        errno = EINVAL;
+        return nullptr;
+    }
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    void* memory = mapShared(fd, bytes);
+    if (memory == nullptr) return nullptr;
+    if (!validHeader(static_cast<detail::ShmRingHeader*>(memory), bytes)) {
+        ::munmap(memory, bytes);
+        errno = EINVAL;
+        return nullptr;
+    }
+    return std::unique_ptr<ShmLogRing>(new ShmLogRing(memory, bytes));
+}
+
+bool ShmLogRing::unlink(const std::string& name) {
+    return ::shm_unlink(name.c_str()) == 0;
+}
+
+bool ShmLogRing::append(const char* line, int len) {
+    Logger::Reservation reservation;
+    if (!reserve(len, &reservation)) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ::memcpy(reservation.data, line, static_cast<size_t>(len));
+    commit(reservation, len);
+    return true;
+}
+
+bool ShmLogRing::reserve(int maxLen, Logger::Reservation* reservation) {
+    if (maxLen < 0) return false;
+    const uint64_t span = spanOf(maxLen);
+    /// a line may need the room left before the end as well
+    if (span > capacity_ / 2) return false;
+
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t padding;
+    do {
+        const uint64_t offset = head & (capacity_ - 1);
+        padding = offset + span > capacity_ ? capacity_ - offset : 0;
+        /// pairs with the consumer handing the room back in drain()
+        const uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        if (head + padding + span - tail > capacity_) return false;
+    } while (!header_->head.compare_exchange_weak(
+        head, head + padding + span, std::memory_order_relaxed));
+
+    if (padding > 0) {
+        detail::ShmRingRecord* filler = recordAt(head);
+        filler->length = kPadding;
+        filler->pid = g_pid;
+        filler->word.store(tagOf(head) << 32 | padding,
+                           std::memory_order_release);
+        head += padding;
+    }
+    /// published busy with its span, see skipDeadWriter()
+    detail::ShmRingRecord* record = recordAt(head);
+    record->length = 0;
+    record->pid = g_pid;
+    record->word.store(tagOf(head) << 32 | kBusy | span,
+                       std::memory_order_release);
+
+    reservation->data = reinterpret_cast<char*>(record + 1);
+    reservation->capacity = maxLen;
+    reservation->token = reinterpret_cast<void*>(static_cast<uintptr_t>(head));
+    return true;
+}
+
+void ShmLogRing::commit(const Logger::Reservation& reservation, int len) {
+    assert(len >= 0 && len <= reservation.capacity);
+    const uint64_t start = reinterpret_cast<uintptr_t>(reservation.token);
+    const uint64_t reserved = spanOf(reservation.capacity);
+    uint64_t span = spanOf(len);
+    detail::ShmRingRecord* record = recordAt(start);
+    /// hand back the unused room while nobody has claimed past it. The
+    /// headers go first so a producer dying anywhere in here leaves the
+    /// claim readable by skipDeadWriter(): the shrunk record, then a
+    /// filler for the rest as long as the room may still be ours
+    if (span < reserved) {
+        detail::ShmRingRecord* filler = recordAt(start + span);
+        const uint64_t fillerWord = tagOf(start + span) << 32 |
+                                    (reserved - span);
+        filler->length = kHandedBack;
+        filler->pid = g_pid;
+        filler->word.store(fillerWord, std::memory_order_release);
+        record->word.store(tagOf(start) << 32 | kBusy | span,
+                           std::memory_order_release);
+        uint64_t expected = start + reserved;
+        if (header_->head.compare_exchange_strong(expected, start + span)) {
+            /// the room is another producer's now, unless it has already
+            /// put its header there
+            uint64_t stale = fillerWord;
+            filler->word.compare_exchange_strong(stale, 0);
+        } else {
+            span = reserved;
+        }
+    }
+    record->length = static_cast<uint32_t>(len);
+    record->word.store(tagOf(start) << 32 | span, std::memory_order_release);
+    wakeConsumer();
+}
+
+void ShmLogRing::wakeConsumer() {
+    /// pairs with sleeping = 1 then the record check in waitForData()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->sleeping.load(std::memory_order_relaxed) == 0) return;
+    if (header_->sleeping.exchange(0) == 0) return;
+    header_->wakeSeq.fetch_add(1);
+    /// shared futex: the consumer is another process
+    ::syscall(SYS_futex, &header_->wakeSeq, FUTEX_WAKE, 1, nullptr, nullptr,
+              0);
+}
+
+bool ShmLogRing::waitForData(int timeoutMs) {
+    const uint32_t seq = header_->wakeSeq.load();
+    header_->sleeping.store(1);
+    const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    if (tail != header_->head.load()) {
+        const uint64_t word = recordAt(tail)->word.load();
+        if ((word >> 32) == tagOf(tail) && !(word & kBusy)) {
+            header_->sleeping.store(0);
+            return true;
+        }
+    }
+
+    struct timespec timeout;
+    timeout.tv_sec = static_cast<time_t>(timeoutMs / 1000);
+    timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000;
+    const long rc = ::syscall(SYS_futex, &header_->wakeSeq, FUTEX_WAIT, seq,
+                              &timeout, nullptr, 0);
+    const int savedErrno = errno;
+    header_->sleeping.store(0);
+    return !(rc != 0 && savedErrno == ETIMEDOUT);
+}
+
+bool ShmLogRing::skipDeadWriter() {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    if (tail == header_->head.load(std::memory_order_acquire)) return false;
+    detail::ShmRingRecord* record = recordAt(tail);
+    const uint64_t word = record->word.load(std::memory_order_acquire);
+    if ((word >> 32) != tagOf(tail) || !(word & kBusy)) return false;
+    if (::kill(record->pid, 0) == 0 || errno != ESRCH) return false;
+    /// never past the head: the ring would look over-full for good
+    const uint64_t head = header_->head.load(std::memory_order_acquire);
+    tail = std::min(tail + (word & kSpanMask), head);
+    /// it died handing back room: the filler covers what is still its own
+    if (tail != head) {
+        detail::ShmRingRecord* filler = recordAt(tail);
+        const uint64_t fillerWord =
+            filler->word.load(std::memory_order_acquire);
+        if ((fillerWord >> 32) == tagOf(tail) && !(fillerWord & kBusy) &&
+            filler->length == kHandedBack && filler->pid == record->pid)
+            tail = std::min(tail + (fillerWord & kSpanMask), head);
+    }
+    header_->tail.store(tail, std::memory_order_release);
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace Lute
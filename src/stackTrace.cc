@@ -0,0 +1,292 @@
+#include <Base/mutex.h>  // MutexLock
+#include <Base/stackTrace.h>
+#include <cxxabi.h>    // abi
+#include <dlfcn.h>     // dladdr
+#include <execinfo.h>  // backtrace
+#include <link.h>      // dl_iterate_phdr
+#include <unistd.h>    // write readlink
+
+#include <atomic>         // atomic
+#include <cstdint>        // uintptr_t
+#include <cstdlib>        // free
+#include <cstring>        // memmove
+#include <list>           // list
+#include <unordered_map>  // unordered_map
+
+namespace Lute {
+namespace {
+    void appendHex(std::string* out, uintptr_t v) {
+        char buf[2 + 2 * sizeof v];
+        char* p = buf + sizeof buf;
+        do {
+            *--p = "0123456789abcdef"[v & 0xf];
+            v >>= 4;
+        } while (v != 0);
+        *--p = 'x';
+        *--p = '0';
+        out->append(p, buf + sizeof buf);
+    }
+
+    ///
+    /// @brief LRU cache of resolved return addresses, each entry holds the
+    ///        text of a frame without its `[0xpc]` suffix
+    ///
+    class SymbolCache {
+    public:
+        void append(std::string* out, void* pc, bool demangle) {
+            const uintptr_t key = reinterpret_cast<uintptr_t>(pc);
+            {
+                MutexLockGuard lock(mutex_);
+                auto it = index_.find(key);
+                if (it != index_.end()) {
+                    lru_.splice(lru_.begin(), lru_, it->second);
+                    appendEntry(out, it->second->second, demangle);
+                    return;
+                }
+            }
+
+            /// dladdr and the demangler run without the lock
+            Entry entry = resolve(pc);
+            MutexLockGuard lock(mutex_);
+            if (index_.find(key) == index_.end() && capacity_ > 0) {
+                lru_.emplace_front(key, entry);
+                index_[key] = lru_.begin();
+                while (lru_.size() > capacity_) {
+                    index_.erase(lru_.back().first);
+                    lru_.pop_back();
+                }
+            }
+            appendEntry(out, entry, demangle);
+        }
+
+        void setCapacity(size_t capacity) {
+            MutexLockGuard lock(mutex_);
+            capacity_ = capacity;
+            while (lru_.size() > capacity_) {
+                index_.erase(lru_.back().first);
+                lru_.pop_back();
+            }
+        }
+
+        size_t size() {
+            MutexLockGuard lock(mutex_);
+            return lru_.size();
+        }
+
+    private:
+        struct Entry {
+            std::string mangled;
+            /// empty if the name doesn't demangle
+            std::string demangled;
+        };
+        using Lru = std::list<std::pair<uintptr_t, Entry>>;
+
+        static void appendEntry(std::string* out, const Entry& entry,
+                                bool demangle) {
+            if (demangle && !entry.demangled.empty())
+                out->append(entry.demangled);
+            else
+                out->append(entry.mangled);
+        }
+
+        static Entry resolve(void* pc) {
+            Entry entry;
+            Dl_info info;
+            if (::dladdr(pc, &info) == 0 || info.dli_fname == nullptr)
+                return entry;
+
+            const uintptr_t addr = reinterpret_cast<uintptr_t>(pc);
+            std::string module(info.dli_fname);
+            module.push_back('(');
+            if (info.dli_sname == nullptr) {
+                entry.mangled = module + "+";
+                appendHex(&entry.mangled,
+                          addr - reinterpret_cast<uintptr_t>(info.dli_fbase));
+                entry.mangled.append(") ");
+                return entry;
+            }
+
+            std::string offset("+");
+            appendHex(&offset,
+                      addr - reinterpret_cast<uintptr_t>(info.dli_saddr));
+            offset.append(") ");
+            entry.mangled = module + info.dli_sname + offset;
+
+            int status = 0;
+            char* name =
+                abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            if (status == 0 && name != nullptr)
+                entry.demangled = module + name + offset;
+            ::free(name);
+            return entry;
+        }
+
+        MutexLock mutex_;
+        Lru lru_ GUARDED_BY(mutex_);
+        std::unordered_map<uintptr_t, Lru::iterator> index_ GUARDED_BY(mutex_);
+        size_t capacity_ GUARDED_BY(mutex_) = 1024;
+    };
+
+    /// Leaked, exceptions may be formatted by static destructors
+    SymbolCache* symbolCache() {
+        static SymbolCache* cache = new SymbolCache;
+        return cache;
+    }
+
+    /// NOTE ----------- async-signal-safe path -----------
+
+    struct Module {
+        uintptr_t begin;
+        uintptr_t end;
+        /// load bias, `pc - base` is the address addr2line expects
+        uintptr_t base;
+        const char* name;
+    };
+
+    const int kMaxModules = 256;
+    Module g_modules[kMaxModules];
+    std::atomic<int> g_moduleCount(0);
+    char g_exePath[256];
+    MutexLock g_prepareMutex;
+
+    int collectModule(struct dl_phdr_info* info, size_t, void* data) {
+        int* count = static_cast<int*>(data);
+        if (*count == kMaxModules) return 1;
+
+        uintptr_t begin = UINTPTR_MAX;
+        uintptr_t end = 0;
+        for (int i = 0; i < info->dlpi_phnum; ++i) {
+            const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+            if (phdr.p_type != PT_LOAD) continue;
+            const uintptr_t b = info->dlpi_addr + phdr.p_vaddr;
+            if (b < begin) begin = b;
+            if (b + phdr.p_memsz > end) end = b + phdr.p_memsz;
+        }
+        if (begin >= end) return 0;
+
+        /// the main program has an empty name
+        const char* name = info->dlpi_name;
+        if (name == nullptr || name[0] == '\0') name = g_exePath;
+        g_modules[(*count)++] = Module{begin, end, info->dlpi_addr, name};
+        return 0;
+    }
+
+    /// @brief Fixed-size line builder, no allocation
+    class SignalSafeLine {
+    public:
+        SignalSafeLine() : len_(0) {}
+
+        void append(const char* s) {
+            while (*s && len_ < sizeof buf_) buf_[len_++] = *s++;
+        }
+        void appendHex(uintptr_t v) {
+            char tmp[2 * sizeof v];
+            int n = 0;
+            do {
+                tmp[n++] = "0123456789abcdef"[v & 0xf];
+                v >>= 4;
+            } while (v != 0);
+            append("0x");
+            while (n > 0 && len_ < sizeof buf_) buf_[len_++] = tmp[--n];
+        }
+        void appendDec(int v) {
+            char tmp[12];
+            int n = 0;
+            do {
+                tmp[n++] = static_cast<char>('0' + v % 10);
+                v /= 10;
+            } while (v != 0);
+            while (n > 0 && len_ < sizeof buf_) buf_[len_++] = tmp[--n];
+        }
+
+        void writeTo(int fd) {
+            const char* p = buf_;
+            size_t left = len_;
+            while (left > 0) {
+                const ssize_t n = ::write(fd, p, left);
+                if (n <= 0) break;
+                p += n;
+                left -= static_cast<size_t>(n);
+            }
+            len_ = 0;
+        }
+
+    private:
+        char buf_[512];
+        size_t len_;
+    };
+}  // namespace
+
+__attribute__((noinline)) StackTrace StackTrace::capture(int skip) {
+    StackTrace trace;
+    trace.size_ = ::backtrace(trace.frames_, kMaxFrames);
+    /// drop this function too
+    const int drop = skip + 1 < trace.size_ ? skip + 1 : trace.size_;
+    trace.size_ -= drop;
+    ::memmove(trace.frames_, trace.frames_ + drop,
+              static_cast<size_t>(trace.size_) * sizeof(void*));
+    return trace;
+}
+
+std::string StackTrace::toString(bool demangle) const {
+    std::string stack;
+    SymbolCache* cache = symbolCache();
+    for (int i = 0; i < size_; ++i) {
+        cache->append(&stack, frames_[i], demangle);
+        stack.push_back('[');
+        appendHex(&stack, reinterpret_cast<uintptr_t>(frames_[i]));
+        stack.append("]\n");
+    }
+    return stack;
+}
+
+void StackTrace::setSymbolCacheCapacity(size_t capacity) {
+    symbolCache()->setCapacity(capacity);
+}
+
+size_t StackTrace::symbolCacheSize() { return symbolCache()->size(); }
+
+void StackTrace::prepareSignalSafe() {
+    MutexLockGuard lock(g_prepareMutex);
+    /// the first backtrace() loads libgcc_s, which allocates
+    void* pc;
+    ::backtrace(&pc, 1);
+
+    const ssize_t n = ::readlink("/proc/self/exe", g_exePath,
+                                 sizeof g_exePath - 1);
+    g_exePath[n > 0 ? n : 0] = '\0';
+
+    /// readers only look at the first g_moduleCount entries
+    g_moduleCount.store(0, std::memory_order_release);
+    int count = 0;
+    ::dl_iterate_phdr(collectModule, &count);
+    g_moduleCount.store(count, std::memory_order_release);
+}
+
+__attribute__((noinline)) void StackTrace::writeSignalSafe(int fd, int skip) {
+    void* frames[kMaxFrames];
+    const int size = ::backtrace(frames, kMaxFrames);
+    const int modules = g_moduleCount.load(std::memory_order_acquire);
+
+    SignalSafeLine line;
+    for (int i = skip + 1; i < size; ++i) {
+        const uintptr_t pc = reinterpret_cast<uintptr_t>(frames[i]);
+        line.append("#");
+        line.appendDec(i - skip - 1);
+        line.append(" ");
+        line.appendHex(pc);
+        for (int m = 0; m < modules; ++m) {
+            if (pc >= g_modules[m].begin && pc < g_modules[m].end) {
+                line.append(" ");
+                line.append(g_modules[m].name);
+                line.append("+");
+                line.appendHex(pc - g_modules[m].base);
+                break;
+            }
+        }
+        line.append("\n");
+        line.writeTo(fd);
+    }
+}
+
+}  // namespace Lute
@@ -1,13 +1,19 @@
 #include <Base/currentThread.h>
 #include <Base/exception.h>
 #include <Base/thread.h>
+#include <linux/futex.h>  // FUTEX_WAIT_PRIVATE
 #include <sys/prctl.h>    // prctl
 #include <sys/syscall.h>  // SYS_gettid
 #include <unistd.h>       // syscall getpid
 
+#include <cassert>  // assert
+
 namespace Lute {
 
 namespace detail {
+    // impl in currentThread.cc
+    void resetThreadRegistry();
+
     /// @brief 该系统调用的返回值作为线程 ID
     /// 优点：
     ///   1. 类型是 pid_t，通常是小整数，便于在日志中输出
@@ -32,10 +38,11 @@ namespace detail {
     /// stale 的缓存结果？ 利用 pthread_atfork
     /// 注册一个回调函数，用于清空缓存的线程ID
     void afterFork() {
-        Lute::CurrentThread::t_cachedTid = 0;
-        Lute::CurrentThread::t_threadName = "main";
+        Lute::CurrentThread::t_context.tid = 0;
+        Lute::CurrentThread::t_context.name = "main";
 
         Lute::CurrentThread::tid();
+        resetThreadRegistry();
 
         // no need to call pthread_atfork(NULL, NULL, &afterFork);
     }
@@ -44,8 +51,8 @@ namespace detail {
     class ThreadNameInitializer {
     public:
         ThreadNameInitializer() {
-            Lute::CurrentThread::t_threadName = "main";
-            Lute::CurrentThread::tid();
+            Lute::CurrentThread::setName("main");
+            Lute::CurrentThread::registerThread();
             pthread_atfork(nullptr, nullptr, &afterFork);
         }
     };
@@ -53,57 +60,56 @@ namespace detail {
     ThreadNameInitializer init;
 
     /**
-     * @brief func_ / name_ / tid_ / latch_
+     * @brief func_ / name_ / tid_
      */
     struct ThreadData {
         using ThreadFunc = Thread::ThreadFunc;
 
         ThreadFunc func_;
         std::string name_;
-        pid_t* tid_;
-        Lute::CountDownLatch* latch_;
+        std::shared_ptr<std::atomic<pid_t>> tid_;
 
         /// @brief Constructor
         /// @param func
         /// @param name
         /// @param tid
-        /// @param latch
-        ThreadData(ThreadFunc func, std::string name, pid_t* tid,
-                   Lute::CountDownLatch* latch)
+        ThreadData(ThreadFunc func, std::string name,
+                   std::shared_ptr<std::atomic<pid_t>> tid)
             : func_(std::move(func)),
               name_(std::move(name)),
-              tid_(tid),
-              latch_(latch) {}
+              tid_(std::move(tid)) {}
 
         /// @brief Call this->func_()
         void runThread() {
-            *tid_ = Lute::CurrentThread::tid();
-            tid_ = nullptr;
-            latch_->countDown();
-            latch_ = nullptr;
+            Lute::CurrentThread::setName(name_.empty() ? "LuteThread"
+                                                       : name_.c_str());
+            Lute::CurrentThread::registerThread();
+            ::prctl(PR_SET_NAME, Lute::CurrentThread::name());
 
-            Lute::CurrentThread::t_threadName =
-                name_.empty() ? "LuteThread" : name_.c_str();
-            ::prctl(PR_SET_NAME, Lute::CurrentThread::t_threadName);
+            /// publish the tid, Thread::tid() waits for it only if asked
+            tid_->store(Lute::CurrentThread::tid(), std::memory_order_release);
+            ::syscall(SYS_futex, tid_.get(), FUTEX_WAKE_PRIVATE, INT32_MAX,
+                      nullptr, nullptr, 0);
+            tid_.reset();
 
             try {
                 func_();
-                Lute::CurrentThread::t_threadName = "finished";
+                Lute::CurrentThread::setName("finished");
             } catch (const Lute::Exception& ex) {
-                Lute::CurrentThread::t_threadName = "crashed";
+                Lute::CurrentThread::setName("crashed");
                 fprintf(stderr, "exception caught in Thread %s\n",
                         name_.c_str());
                 fprintf(stderr, "reason: %s\n", ex.what());
                 fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
                 abort();
             } catch (const std::exception& ex) {
-                Lute::CurrentThread::t_threadName = "crashed";
+                Lute::CurrentThread::setName("crashed");
                 fprintf(stderr, "exception caught in Thread %s\n",
                         name_.c_str());
                 fprintf(stderr, "reason: %s\n", ex.what());
                 abort();
             } catch (...) {
-                Lute::CurrentThread::t_threadName = "crashed";
+                Lute::CurrentThread::setName("crashed");
                 fprintf(stderr, "unknown exception caught in Thread %s\n",
                         name_.c_str());
                 throw;  // rethrow
@@ -126,10 +132,11 @@ namespace detail {
 /// 这样只有在本线程第一次调用的时候才进行系统调用,以后都是直接从thread
 /// local缓存的线程id拿到结果
 void CurrentThread::cacheTid() {
-    if (t_cachedTid == 0) {
-        t_cachedTid = detail::gettid();
-        t_tidStringLength =
-            snprintf(t_tidString, sizeof(t_tidString), "%5d ", t_cachedTid);
+    if (t_context.tid == 0) {
+        t_context.tid = detail::gettid();
+        t_context.tidStringLength =
+            snprintf(t_context.tidString, sizeof(t_context.tidString), "%5d ",
+                     t_context.tid);
     }
 }
 
@@ -156,10 +163,9 @@ Thread::Thread(ThreadFunc func, std::string name)
     : started_(false),
       joined_(false),
       pthreadId_(0),
-      tid_(0),
+      tid_(std::make_shared<std::atomic<pid_t>>(0)),
       func_(std::move(func)),
-      name_(std::move(name)),
-      latch_(1) {
+      name_(std::move(name)) {
     setDefaultName();
 }
 
@@ -183,16 +189,13 @@ void Thread::setDefaultName() {
 /// @brief Thread start including:
 /// 1. pthread_create()
 /// 2. startThread()
-/// 3. latch_.wait()
+/// The new thread publishes its tid, start() doesn't wait for it
 void Thread::start() {
     // Ensure the thread is not started
     assert(!started_);
     started_ = true;
 
-    // FIXME: move(func_)
-    auto* data = new detail::ThreadData(func_, name_, &tid_, &latch_);
-    // auto* data =
-    //     new detail::ThreadData(std::move(func_), name_, &tid_, &latch_);
+    auto* data = new detail::ThreadData(std::move(func_), name_, tid_);
 
     // 当线程创建时，线程函数就已经开始执行
     if (pthread_create(&pthreadId_, nullptr, &detail::startThread, data)) {
@@ -201,12 +204,20 @@ void Thread::start() {
         // LOG_SYSFATAL << "Failed in pthread_create";
         perror("Failed in pthread_create");
         abort();
-    } else {
-        latch_.wait();
-        assert(tid_ > 0);
     }
 }
 
+/// @brief Wait on the futex until the new thread stored its tid
+pid_t Thread::tid() const {
+    if (!started_) return 0;
+    pid_t tid;
+    while ((tid = tid_->load(std::memory_order_acquire)) == 0) {
+        ::syscall(SYS_futex, tid_.get(), FUTEX_WAIT_PRIVATE, 0, nullptr,
+                  nullptr, 0);
+    }
+    return tid;
+}
+
 /// @brief thread join
 /// @return pthread_join(pthreadId_, nullptr)
 int Thread::join() {
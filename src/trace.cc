@@ -0,0 +1,322 @@
+#include <Base/condition_variable.h>  // Condition
+#include <Base/currentThread.h>       // CurrentThread
+#include <Base/mutex.h>               // MutexLock
+#include <Base/thread.h>              // Thread
+#include <Base/trace.h>
+#include <Base/utils.h>  // appendJsonEscaped
+#include <unistd.h>      // getpid
+
+#include <cstdio>   // FILE fprintf
+#include <cstring>  // strncpy
+#include <memory>   // unique_ptr
+#include <string>   // string
+#include <vector>   // vector
+
+namespace Lute {
+namespace trace {
+    namespace detail {
+        std::atomic<bool> g_enabled(false);
+
+        struct Event {
+            const char* name;
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        ///
+        /// @brief Single producer (the owning thread) / single consumer (the
+        ///        writer thread) ring of events
+        ///
+        class ThreadBuffer {
+        public:
+            static const uint64_t kCapacity = 8192;  // power of 2
+
+            /// non-copyable
+            ThreadBuffer(const ThreadBuffer&) = delete;
+            ThreadBuffer& operator=(ThreadBuffer&) = delete;
+
+            ThreadBuffer(int tid, const char* name)
+                : tid_(tid), retired_(false), dropped_(0), head_(0), tail_(0) {
+                ::strncpy(name_, name ? name : "unknown", sizeof name_ - 1);
+                name_[sizeof name_ - 1] = '\0';
+            }
+
+            void push(const char* name, uint64_t begin, uint64_t end) {
+                const uint64_t head = head_.load(std::memory_order_relaxed);
+                if (head - tail_.load(std::memory_order_acquire) >= kCapacity) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                Event& e = events_[head & (kCapacity - 1)];
+                e.name = name;
+                e.begin = begin;
+                e.end = end;
+                head_.store(head + 1, std::memory_order_release);
+            }
+
+            template <typename Func>
+            void drain(Func&& func) {
+                uint64_t tail = tail_.load(std::memory_order_relaxed);
+                const uint64_t head = head_.load(std::memory_order_acquire);
+                for (; tail != head; ++tail)
+                    func(events_[tail & (kCapacity - 1)]);
+                tail_.store(tail, std::memory_order_release);
+            }
+
+            int tid() const { return tid_; }
+            const char* name() const { return name_; }
+            uint64_t dropped() const {
+                return dropped_.load(std::memory_order_relaxed);
+            }
+            bool retired() const {
+                return retired_.load(std::memory_order_acquire);
+            }
+            void retire() { retired_.store(true, std::memory_order_release); }
+
+            /// Only touched by the writer thread
+            bool named = false;
+
+        private:
+            const int tid_;
+            char name_[32];
+            std::atomic<bool> retired_;
+            std::atomic<uint64_t> dropped_;
+            alignas(64) std::atomic<uint64_t> head_;
+            alignas(64) std::atomic<uint64_t> tail_;
+            Event events_[kCapacity];
+        };
+
+        MutexLock g_buffersMutex;
+        std::vector<ThreadBuffer*> g_buffers GUARDED_BY(g_buffersMutex);
+        /// Dropped events of buffers that have been reclaimed
+        uint64_t g_reclaimedDropped GUARDED_BY(g_buffersMutex) = 0;
+
+        /// @brief Marks the thread's ring as retired when the thread exits,
+        ///        the writer reclaims it after the last drain.
+        struct LocalBuffer {
+            ThreadBuffer* buffer = nullptr;
+            ~LocalBuffer() {
+                if (buffer) buffer->retire();
+            }
+        };
+        thread_local LocalBuffer t_localBuffer;
+
+        ThreadBuffer* localBuffer() {
+            ThreadBuffer* buffer = t_localBuffer.buffer;
+            if (__builtin_expect(buffer == nullptr, 0)) {
+                buffer = new ThreadBuffer(CurrentThread::tid(),
+                                          CurrentThread::name());
+                {
+                    MutexLockGuard lock(g_buffersMutex);
+                    g_buffers.push_back(buffer);
+                }
+                t_localBuffer.buffer = buffer;
+            }
+            return buffer;
+        }
+
+        void record(const char* name, uint64_t begin, uint64_t end) {
+            localBuffer()->push(name, begin, end);
+        }
+
+        int64_t monotonicNanos() {
+            struct timespec ts {};
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        ///
+        /// @brief Background writer of the trace_event JSON document
+        ///
+        class Writer {
+        public:
+            /// non-copyable
+            Writer(const Writer&) = delete;
+            Writer& operator=(Writer&) = delete;
+
+            Writer(FILE* fp, double flushInterval)
+                : fp_(fp),
+                  interval_(flushInterval),
+                  pid_(::getpid()),
+                  running_(false),
+                  thread_(std::bind(&Writer::threadFunc, this), "TraceWriter"),
+                  mutex_(),
+                  cond_(mutex_),
+                  first_(true) {
+                calibrate();
+            }
+
+            ~Writer() {
+                if (running_) stop();
+            }
+
+            void start() {
+                {
+                    /// rings that outlived a previous trace need their
+                    /// thread_name metadata in this file too
+                    MutexLockGuard lock(g_buffersMutex);
+                    for (ThreadBuffer* buffer : g_buffers)
+                        buffer->named = false;
+                }
+                ::fputs("{\"traceEvents\":[\n", fp_);
+                running_ = true;
+                thread_.start();
+            }
+
+            void stop() {
+                {
+                    /// under the lock: the notify can't fall between
+                    /// threadFunc's running_ check and its wait
+                    MutexLockGuard lock(mutex_);
+                    running_ = false;
+                    cond_.notify();
+                }
+                thread_.join();
+                drainAll();
+                ::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", fp_);
+                ::fclose(fp_);
+            }
+
+        private:
+            /// @brief Estimate ticks per nanosecond over ~10ms
+            void calibrate() {
+                tick0_ = ticks();
+                ns0_ = monotonicNanos();
+                CurrentThread::sleepUsec(10 * 1000);
+                updateScale();
+            }
+
+            void updateScale() {
+                const uint64_t t = ticks();
+                const int64_t ns = monotonicNanos();
+                if (t > tick0_ && ns > ns0_) {
+                    usPerTick_ = static_cast<double>(ns - ns0_) / 1000.0 /
+                                 static_cast<double>(t - tick0_);
+                }
+            }
+
+            double toMicros(uint64_t tick) const {
+                return static_cast<double>(tick - tick0_) * usPerTick_;
+            }
+
+            /// @brief `name` as JSON string contents, valid until the next call
+            const char* escaped(const char* name) {
+                escaped_.clear();
+                appendJsonEscaped(&escaped_, name);
+                return escaped_.c_str();
+            }
+
+            void separator() {
+                if (!first_) ::fputs(",\n", fp_);
+                first_ = false;
+            }
+
+            void threadFunc() {
+                while (running_) {
+                    {
+                        MutexLockGuard lock(mutex_);
+                        if (running_) cond_.waitForSeconds(interval_);
+                    }
+                    drainAll();
+                }
+            }
+
+            void drainAll() {
+                updateScale();
+                std::vector<ThreadBuffer*> buffers;
+                {
+                    MutexLockGuard lock(g_buffersMutex);
+                    buffers = g_buffers;
+                }
+
+                for (ThreadBuffer* buffer : buffers) {
+                    /// read before draining, so nothing pushed before the
+                    /// thread exited can be missed
+                    const bool retired = buffer->retired();
+                    if (!buffer->named) {
+                        separator();
+                        ::fprintf(fp_,
+                                  "{\"name\":\"thread_name\",\"ph\":\"M\","
+                                  "\"pid\":%d,\"tid\":%d,"
+                                  "\"args\":{\"name\":\"%s\"}}",
+                                  pid_, buffer->tid(), escaped(buffer->name()));
+                        buffer->named = true;
+                    }
+                    buffer->drain([this, buffer](const Event& e) {
+                        if (e.begin < tick0_) return;
+                        separator();
+                        ::fprintf(fp_,
+                                  "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                                  "\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                                  escaped(e.name), toMicros(e.begin),
+                                  toMicros(e.end) - toMicros(e.begin), pid_,
+                                  buffer->tid());
+                    });
+                    if (retired) reclaim(buffer);
+                }
+                ::fflush(fp_);
+            }
+
+            static void reclaim(ThreadBuffer* buffer) {
+                MutexLockGuard lock(g_buffersMutex);
+                for (auto it = g_buffers.begin(); it != g_buffers.end(); ++it) {
+                    if (*it == buffer) {
+                        g_buffers.erase(it);
+                        break;
+                    }
+                }
+                g_reclaimedDropped += buffer->dropped();
+                delete buffer;
+            }
+
+            FILE* fp_;
+            const double interval_;
+            std::string escaped_;
+            const int pid_;
+            std::atomic<bool> running_;
+            Thread thread_;
+            MutexLock mutex_;
+            Condition cond_ GUARDED_BY(mutex_);
+
+            /// Only touched by the writer thread once started
+            bool first_;
+            uint64_t tick0_ = 0;
+            int64_t ns0_ = 0;
+            double usPerTick_ = 0.001;
+        };
+
+        MutexLock g_writerMutex;
+        std::unique_ptr<Writer> g_writer GUARDED_BY(g_writerMutex);
+    }  // namespace detail
+
+    bool start(const std::string& filename, double flushInterval) {
+        MutexLockGuard lock(detail::g_writerMutex);
+        if (detail::g_writer) return false;
+
+        FILE* fp = ::fopen(filename.c_str(), "we");
+        if (fp == nullptr) return false;
+
+        detail::g_writer.reset(new detail::Writer(fp, flushInterval));
+        detail::g_writer->start();
+        detail::g_enabled.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    void stop() {
+        MutexLockGuard lock(detail::g_writerMutex);
+        if (!detail::g_writer) return;
+
+        detail::g_enabled.store(false, std::memory_order_relaxed);
+        detail::g_writer->stop();
+        detail::g_writer.reset();
+    }
+
+    uint64_t droppedEvents() {
+        MutexLockGuard lock(detail::g_buffersMutex);
+        uint64_t dropped = detail::g_reclaimedDropped;
+        for (const auto* buffer : detail::g_buffers)
+            dropped += buffer->dropped();
+        return dropped;
+    }
+}  // namespace trace
+}  // namespace Lute
@@ -7,132 +7,538 @@
 #include <sys/times.h>     // tms
 #include <unistd.h>        // sysconf _SC_CLK_TCK _SC_PAGE_SIZE
 
+#if defined(__x86_64__)
+#include <immintrin.h>  // SSE2 AVX2
+#endif
+
+namespace {
+/// ASCII only: the "C" locale `::toupper` / `::tolower` the old
+/// std::transform version used agree with these on every byte.
+inline char upperAscii(char c) {
+    return static_cast<unsigned char>(c - 'a') < 26 ? static_cast<char>(c ^ 0x20)
+                                                    : c;
+}
+inline char lowerAscii(char c) {
+    return static_cast<unsigned char>(c - 'A') < 26 ? static_cast<char>(c ^ 0x20)
+                                                    : c;
+}
+/// " \t\n\r\f\v"
+inline bool spaceAscii(char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+}
+
+template <char (*Convert)(char)>
+void convertScalar(char* dst, const char* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = Convert(src[i]);
+}
+
+/// Index of the first non-space byte in [p, p + n), n if none
+size_t skipSpaceScalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && spaceAscii(p[i])) ++i;
+    return i;
+}
+/// One past the last non-space byte in [p, p + n), 0 if none
+size_t skipSpaceBackScalar(const char* p, size_t n) {
+    while (n > 0 && spaceAscii(p[n - 1])) --n;
+    return n;
+}
+
+#if defined(__x86_64__)
+///
+/// Flip bit 5 of the bytes in [first, first + 26). Shifting the range to
+/// start at -128 turns the unsigned range check into a single signed
+/// compare, bytes >= 0x80 never match.
+///
+inline __m128i convertSse2(__m128i v, char first) {
+    const __m128i shifted =
+        _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(-128 - first)));
+    const __m128i inRange = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return _mm_xor_si128(v, _mm_and_si128(inRange, _mm_set1_epi8(0x20)));
+}
+
+/// Bit i set if byte i isn't whitespace
+inline unsigned nonSpaceMaskSse2(__m128i v) {
+    const __m128i shifted =
+        _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(-128 - '\t')));
+    const __m128i ctrl = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 5));
+    const __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    return ~static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(ctrl, space))) &
+           0xFFFFu;
+}
+
+template <char First, char (*Convert)(char)>
+void convertSse2(char* dst, const char* src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         convertSse2(v, First));
+    }
+    convertScalar<Convert>(dst + i, src + i, n - i);
+}
+
+template <char First, char (*Convert)(char)>
+__attribute__((target("avx2"))) void convertAvx2(char* dst, const char* src,
+                                                 size_t n) {
+    const __m256i bias = _mm256_set1_epi8(static_cast<char>(-128 - First));
+    const __m256i limit = _mm256_set1_epi8(-128 + 26);
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i inRange =
+            _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, bias));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_xor_si256(v, _mm256_and_si256(inRange, flip)));
+    }
+    convertSse2<First, Convert>(dst + i, src + i, n - i);
+}
+
+size_t skipSpaceSse2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const unsigned mask = nonSpaceMaskSse2(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+        if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + skipSpaceScalar(p + i, n - i);
+}
+
+size_t skipSpaceBackSse2(const char* p, size_t n) {
+    for (; n >= 16; n -= 16) {
+        const unsigned mask = nonSpaceMaskSse2(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n - 16)));
+        if (mask != 0) return n - 16 + 32 - static_cast<size_t>(__builtin_clz(mask));
+    }
+    return skipSpaceBackScalar(p, n);
+}
+#endif
+
+using ConvertFunc = void (*)(char*, const char*, size_t);
+
+struct CaseKernels {
+    ConvertFunc upper;
+    ConvertFunc lower;
+};
+
+/// Picked once on first use, AVX2 if the CPU has it
+const CaseKernels& caseKernels() {
+    static const CaseKernels kernels = [] {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return CaseKernels{convertAvx2<'a', upperAscii>,
+                               convertAvx2<'A', lowerAscii>};
+        return CaseKernels{convertSse2<'a', upperAscii>,
+                           convertSse2<'A', lowerAscii>};
+#else
+        return CaseKernels{convertScalar<upperAscii>,
+                           convertScalar<lowerAscii>};
+#endif
+    }();
+    return kernels;
+}
+
+/// Most keys are short, don't pay for the dispatch
+const size_t kSimdThreshold = 16;
+
+inline size_t skipSpace(const char* p, size_t n) {
+#if defined(__x86_64__)
+    if (n >= kSimdThreshold) return skipSpaceSse2(p, n);
+#endif
+    return skipSpaceScalar(p, n);
+}
+inline size_t skipSpaceBack(const char* p, size_t n) {
+#if defined(__x86_64__)
+    if (n >= kSimdThreshold) return skipSpaceBackSse2(p, n);
+#endif
+    return skipSpaceBackScalar(p, n);
+}
+
+inline bool isDefaultSpaces(const Lute::string_view& delimiters) {
+    return delimiters == Lute::string_view(" \t\n\r\f\v");
+}
+}  // namespace
+
+void Lute::toUpper(char* dst, const char* src, size_t n) {
+    if (n < kSimdThreshold)
+        convertScalar<upperAscii>(dst, src, n);
+    else
+        caseKernels().upper(dst, src, n);
+}
+
+void Lute::toLower(char* dst, const char* src, size_t n) {
+    if (n < kSimdThreshold)
+        convertScalar<lowerAscii>(dst, src, n);
+    else
+        caseKernels().lower(dst, src, n);
+}
+
 std::string Lute::toUpper(const std::string& str) {
-    std::string rt = str;
-    std::transform(rt.begin(), rt.end(), rt.begin(), ::toupper);
+    std::string rt(str.size(), '\0');
+    toUpper(&rt[0], str.data(), str.size());
     return rt;
 }
 void Lute::toUpper(std::string& str) {
-    std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+    toUpper(&str[0], str.data(), str.size());
 }
 
 std::string Lute::toLower(const std::string& str) {
-    std::string rt = str;
-    std::transform(rt.begin(), rt.end(), rt.begin(), ::tolower);
+    std::string rt(str.size(), '\0');
+    toLower(&rt[0], str.data(), str.size());
     return rt;
 }
 void Lute::toLower(std::string& str) {
-    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+    toLower(&str[0], str.data(), str.size());
+}
+
+Lute::string_view Lute::toUpper(const string_view& str, char* buf) {
+    toUpper(buf, str.data(), str.size());
+    return string_view(buf, str.size());
+}
+
+Lute::string_view Lute::toLower(const string_view& str, char* buf) {
+    toLower(buf, str.data(), str.size());
+    return string_view(buf, str.size());
+}
+
+Lute::string_view Lute::trimView(const string_view& str,
+                                 const string_view& whitespaceDelimiters) {
+    const char* p = str.data();
+    size_t end;
+    size_t begin;
+    if (isDefaultSpaces(whitespaceDelimiters)) {
+        end = skipSpaceBack(p, str.size());
+        begin = skipSpace(p, end);
+    } else {
+        bool table[256] = {false};
+        for (char c : whitespaceDelimiters)
+            table[static_cast<unsigned char>(c)] = true;
+        end = str.size();
+        while (end > 0 && table[static_cast<unsigned char>(p[end - 1])]) --end;
+        begin = 0;
+        while (begin < end && table[static_cast<unsigned char>(p[begin])])
+            ++begin;
+    }
+    return string_view(p + begin, end - begin);
 }
 
 void Lute::trim(std::string& str, const string_view& whitespaceDelimiters) {
-    str.erase(str.find_last_not_of(whitespaceDelimiters.data()) + 1);
-    str.erase(0, str.find_first_not_of(whitespaceDelimiters.data()));
+    const string_view view = trimView(str, whitespaceDelimiters);
+    const size_t begin = static_cast<size_t>(view.data() - str.data());
+    str.erase(begin + view.size());
+    str.erase(0, begin);
+}
+
+const char* Lute::search(const char* haystack, size_t n, const char* needle,
+                         size_t m) {
+    if (m == 0) return haystack;
+    if (n < m) return nullptr;
+    const char* p = haystack;
+    const char* const last = haystack + n - m;
+    /// Candidates from memchr are cheap and usually right; once they keep
+    /// failing hand the rest to memmem, glibc's linear Two-Way search
+    size_t budget = 16;
+    while (p <= last) {
+        p = static_cast<const char*>(
+            ::memchr(p, needle[0], static_cast<size_t>(last - p) + 1));
+        if (p == nullptr) return nullptr;
+        if (::memcmp(p + 1, needle + 1, m - 1) == 0) return p;
+        ++p;
+        if (--budget == 0) {
+            const size_t rest = static_cast<size_t>(haystack + n - p);
+            return static_cast<const char*>(::memmem(p, rest, needle, m));
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+/// @brief True if [p, p + n) overlaps the characters of `str`
+inline bool overlaps(const std::string& str, const char* p, size_t n) {
+    const char* begin = str.data();
+    return n > 0 && p < begin + str.size() && begin < p + n;
 }
+}  // namespace
 
 void Lute::replace(std::string& src, const string_view& target,
                    const string_view& dst) {
-    if (!target.empty()) {
-        std::size_t pos = 0;
-        while ((pos = src.find(target.data(), pos)) != std::string::npos) {
-            src.replace(pos, target.size(), dst.data());
-            pos += dst.size();
+    const size_t tlen = target.size();
+    const size_t dlen = dst.size();
+    if (tlen == 0 || src.size() < tlen) return;
+
+    /// Views into `src` itself would be clobbered while rewriting it
+    if (overlaps(src, target.data(), tlen) || overlaps(src, dst.data(), dlen)) {
+        const std::string t(target.data(), tlen);
+        const std::string d(dst.data(), dlen);
+        replace(src, t, d);
+        return;
+    }
+
+    const char* base = src.data();
+    const size_t n = src.size();
+    auto find = [base, n, &target, tlen](size_t pos) -> size_t {
+        const char* p = search(base + pos, n - pos, target.data(), tlen);
+        return p ? static_cast<size_t>(p - base) : std::string::npos;
+    };
+
+    size_t pos = find(0);
+    if (pos == std::string::npos) return;
+
+    if (dlen <= tlen) {
+        /// Shrinking or same size: compact in place, the write cursor never
+        /// passes the read cursor
+        char* out = &src[0];
+        size_t w = pos;
+        size_t r = pos;
+        while (pos != std::string::npos) {
+            if (w != r) ::memmove(out + w, out + r, pos - r);
+            w += pos - r;
+            ::memcpy(out + w, dst.data(), dlen);
+            w += dlen;
+            r = pos + tlen;
+            pos = find(r);
+        }
+        ::memmove(out + w, out + r, n - r);
+        src.resize(w + n - r);
+        return;
+    }
+
+    /// Growing: find the matches first. Up to kMaxInPlace of them are
+    /// remembered and src is expanded in place from the back, reusing
+    /// its capacity; with more, the result is built in one forward pass
+    const size_t kMaxInPlace = 64;
+    size_t matches[kMaxInPlace];
+    size_t count = 0;
+    size_t p = pos;
+    for (; p != std::string::npos && count < kMaxInPlace; p = find(p + tlen))
+        matches[count++] = p;
+
+    if (p == std::string::npos) {
+        const size_t grown = n + count * (dlen - tlen);
+        src.resize(grown);
+        char* out = &src[0];
+        size_t r = n;
+        size_t w = grown;
+        for (size_t i = count; i-- > 0;) {
+            const size_t tail = r - (matches[i] + tlen);
+            w -= tail;
+            ::memmove(out + w, out + matches[i] + tlen, tail);
+            w -= dlen;
+            ::memcpy(out + w, dst.data(), dlen);
+            r = matches[i];
+        }
+        return;
+    }
+
+    for (; p != std::string::npos; p = find(p + tlen)) ++count;
+    std::string result;
+    result.reserve(n + count * (dlen - tlen));
+    size_t r = 0;
+    for (; pos != std::string::npos; pos = find(r)) {
+        result.append(base + r, pos - r);
+        result.append(dst.data(), dlen);
+        r = pos + tlen;
+    }
+    result.append(base + r, n - r);
+    src.swap(result);
+}
+
+namespace {
+///
+/// Shared by formatSI / formatIEC: pick the largest unit and precision the
+/// rounded value fits in, with integers only (no snprintf, no locale).
+/// `limits[d]` bounds the scaled value printed with 2 - d decimals.
+///
+size_t formatUnits(char* buf, int64_t s, const int64_t* units,
+                   const char* const* suffixes, int numUnits,
+                   const int* limits) {
+    if (s < units[0]) return Lute::integer2Str(buf, s);
+
+    const auto v = static_cast<uint64_t>(s);
+    for (int u = 0; u < numUnits; ++u) {
+        const auto base = static_cast<uint64_t>(units[u]);
+        const bool last = u == numUnits - 1;
+        for (int d = 0; d < 3; ++d) {
+            const int decimals = 2 - d;
+            const uint64_t scale = decimals == 2 ? 100 : decimals == 1 ? 10 : 1;
+            /// round(v * scale / base) < limit; a tie at limit - 0.5 goes
+            /// to the (even) limit. Multiplies only, no division yet.
+            const auto lhs = static_cast<__uint128_t>(v) * scale * 2;
+            const auto rhs = static_cast<__uint128_t>(2 * limits[d] - 1) * base;
+            if (lhs >= rhs && !(last && decimals == 1)) continue;
+
+            /// round half to even, like printf does on exact values
+            uint64_t q;
+            uint64_t rem;
+            if (v <= UINT64_MAX / scale) {
+                q = v * scale / base;
+                rem = v * scale % base;
+            } else {
+                const __uint128_t scaled = static_cast<__uint128_t>(v) * scale;
+                q = static_cast<uint64_t>(scaled / base);
+                rem = static_cast<uint64_t>(scaled % base);
+            }
+            if (rem > base - rem || (rem == base - rem && (q & 1))) ++q;
+
+            char* p = buf + Lute::integer2Str(buf, q / scale);
+            if (decimals > 0) {
+                *p++ = '.';
+                const uint64_t frac = q % scale;
+                if (decimals == 2) *p++ = static_cast<char>('0' + frac / 10);
+                *p++ = static_cast<char>('0' + frac % 10);
+            }
+            for (const char* x = suffixes[u]; *x; ++x) *p++ = *x;
+            *p = '\0';
+            return static_cast<size_t>(p - buf);
         }
     }
+    return 0;  // unreachable, the last unit always fits
+}
+}  // namespace
+
+size_t Lute::formatSI(char* buf, int64_t s) {
+    static const int64_t kUnits[] = {1000LL,
+                                     1000LL * 1000,
+                                     1000LL * 1000 * 1000,
+                                     1000LL * 1000 * 1000 * 1000,
+                                     1000LL * 1000 * 1000 * 1000 * 1000,
+                                     1000LL * 1000 * 1000 * 1000 * 1000 * 1000};
+    static const char* const kSuffixes[] = {"k", "M", "G", "T", "P", "E"};
+    static const int kLimits[] = {1000, 1000, 1000};
+    return formatUnits(buf, s, kUnits, kSuffixes, 6, kLimits);
+}
+
+size_t Lute::formatIEC(char* buf, int64_t s) {
+    static const int64_t kUnits[] = {1LL << 10, 1LL << 20, 1LL << 30,
+                                     1LL << 40, 1LL << 50, 1LL << 60};
+    static const char* const kSuffixes[] = {"Ki", "Mi", "Gi",
+                                            "Ti", "Pi", "Ei"};
+    /// up to "1023Ki" before moving to Mi
+    static const int kLimits[] = {1000, 1000, 1024};
+    return formatUnits(buf, s, kUnits, kSuffixes, 6, kLimits);
 }
 
 std::string Lute::formatSI(int64_t s) {
-    auto n = static_cast<double>(s);
-    char buf[64];
-    if (s < 1000)
-        ::snprintf(buf, sizeof(buf), "%" PRId64, s);
-    else if (s < 9995)
-        ::snprintf(buf, sizeof(buf), "%.2fk", n / 1e3);
-    else if (s < 99950)
-        ::snprintf(buf, sizeof(buf), "%.1fk", n / 1e3);
-    else if (s < 999500)
-        ::snprintf(buf, sizeof(buf), "%.0fk", n / 1e3);
-    else if (s < 9995000)
-        ::snprintf(buf, sizeof(buf), "%.2fM", n / 1e6);
-    else if (s < 99950000)
-        ::snprintf(buf, sizeof(buf), "%.1fM", n / 1e6);
-    else if (s < 999500000)
-        ::snprintf(buf, sizeof(buf), "%.0fM", n / 1e6);
-    else if (s < 9995000000)
-        ::snprintf(buf, sizeof(buf), "%.2fG", n / 1e9);
-    else if (s < 99950000000)
-        ::snprintf(buf, sizeof(buf), "%.1fG", n / 1e9);
-    else if (s < 999500000000)
-        ::snprintf(buf, sizeof(buf), "%.0fG", n / 1e9);
-    else if (s < 9995000000000)
-        ::snprintf(buf, sizeof(buf), "%.2fT", n / 1e12);
-    else if (s < 99950000000000)
-        ::snprintf(buf, sizeof(buf), "%.1fT", n / 1e12);
-    else if (s < 999500000000000)
-        ::snprintf(buf, sizeof(buf), "%.0fT", n / 1e12);
-    else if (s < 9995000000000000)
-        ::snprintf(buf, sizeof(buf), "%.2fP", n / 1e15);
-    else if (s < 99950000000000000)
-        ::snprintf(buf, sizeof(buf), "%.1fP", n / 1e15);
-    else if (s < 999500000000000000)
-        ::snprintf(buf, sizeof(buf), "%.0fP", n / 1e15);
-    else
-        ::snprintf(buf, sizeof(buf), "%.2fE", n / 1e18);
-    return buf;
+    char buf[kFormatUnitsSize];
+    return std::string(buf, formatSI(buf, s));
 }
 
 std::string Lute::formatIEC(int64_t s) {
-    auto n = static_cast<double>(s);
-    char buf[64];
-    const double Ki = 1024.0;
-    const double Mi = Ki * 1024.0;
-    const double Gi = Mi * 1024.0;
-    const double Ti = Gi * 1024.0;
-    const double Pi = Ti * 1024.0;
-    const double Ei = Pi * 1024.0;
-
-    if (n < Ki)
-        ::snprintf(buf, sizeof buf, "%" PRId64, s);
-    else if (n < Ki * 9.995)
-        ::snprintf(buf, sizeof buf, "%.2fKi", n / Ki);
-    else if (n < Ki * 99.95)
-        ::snprintf(buf, sizeof buf, "%.1fKi", n / Ki);
-    else if (n < Ki * 1023.5)
-        ::snprintf(buf, sizeof buf, "%.0fKi", n / Ki);
-
-    else if (n < Mi * 9.995)
-        ::snprintf(buf, sizeof buf, "%.2fMi", n / Mi);
-    else if (n < Mi * 99.95)
-        ::snprintf(buf, sizeof buf, "%.1fMi", n / Mi);
-    else if (n < Mi * 1023.5)
-        ::snprintf(buf, sizeof buf, "%.0fMi", n / Mi);
-
-    else if (n < Gi * 9.995)
-        ::snprintf(buf, sizeof buf, "%.2fGi", n / Gi);
-    else if (n < Gi * 99.95)
-        ::snprintf(buf, sizeof buf, "%.1fGi", n / Gi);
-    else if (n < Gi * 1023.5)
-        ::snprintf(buf, sizeof buf, "%.0fGi", n / Gi);
-
-    else if (n < Ti * 9.995)
-        ::snprintf(buf, sizeof buf, "%.2fTi", n / Ti);
-    else if (n < Ti * 99.95)
-        ::snprintf(buf, sizeof buf, "%.1fTi", n / Ti);
-    else if (n < Ti * 1023.5)
-        ::snprintf(buf, sizeof buf, "%.0fTi", n / Ti);
-
-    else if (n < Pi * 9.995)
-        ::snprintf(buf, sizeof buf, "%.2fPi", n / Pi);
-    else if (n < Pi * 99.95)
-        ::snprintf(buf, sizeof buf, "%.1fPi", n / Pi);
-    else if (n < Pi * 1023.5)
-        ::snprintf(buf, sizeof buf, "%.0fPi", n / Pi);
-
-    else if (n < Ei * 9.995)
-        ::snprintf(buf, sizeof buf, "%.2fEi", n / Ei);
-    else
-        ::snprintf(buf, sizeof buf, "%.1fEi", n / Ei);
-    return buf;
+    char buf[kFormatUnitsSize];
+    return std::string(buf, formatIEC(buf, s));
+}
+
+namespace {
+///
+/// [-]digits[.digits][ ]*[k|K|M|G|T|P|E][i][B]. A suffix without 'i' is a
+/// power of 1000 if `decimal`, of 1024 otherwise; with 'i' always 1024.
+///
+bool parseUnits(const Lute::string_view& str, bool decimal, int64_t* value) {
+    const char* p = str.data();
+    const char* const end = p + str.size();
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    /// the digits as one integer, `fraction` of them after the point
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fraction = -1;
+    for (; p < end; ++p) {
+        if (*p == '.' && fraction < 0) {
+            fraction = 0;
+            continue;
+        }
+        if (*p < '0' || *p > '9') break;
+        if (digits == 19) return false;  // would overflow
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        ++digits;
+        if (fraction >= 0) ++fraction;
+    }
+    if (digits == 0) return false;
+    if (fraction < 0) fraction = 0;
+
+    while (p < end && *p == ' ') ++p;
+    int power = 0;
+    if (p < end) {
+        static const char kPrefixes[] = "KMGTPE";
+        const char c = *p == 'k' ? 'K' : *p;
+        const char* prefix = ::strchr(kPrefixes, c);
+        if (c != '\0' && prefix != nullptr) {
+            power = static_cast<int>(prefix - kPrefixes) + 1;
+            ++p;
+            if (p < end && *p == 'i') {
+                decimal = false;
+                ++p;
+            }
+        }
+    }
+    if (p < end && *p == 'B') ++p;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p != end) return false;
+
+    __uint128_t multiplier = 1;
+    for (int i = 0; i < power; ++i) multiplier *= decimal ? 1000 : 1024;
+    __uint128_t divisor = 1;
+    for (int i = 0; i < fraction; ++i) divisor *= 10;
+
+    /// round half up, e.g. "1.5" -> 2
+    const __uint128_t product = static_cast<__uint128_t>(mantissa) * multiplier;
+    const __uint128_t v =
+        divisor == 1 ? product : (product + divisor / 2) / divisor;
+    const auto limit =
+        static_cast<__uint128_t>(INT64_MAX) + (negative ? 1 : 0);
+    if (v > limit) return false;
+
+    *value = negative ? static_cast<int64_t>(0 - static_cast<uint64_t>(v))
+                      : static_cast<int64_t>(v);
+    return true;
+}
+}  // namespace
+
+bool Lute::parseSI(const string_view& str, int64_t* value) {
+    return parseUnits(str, true, value);
+}
+
+bool Lute::parseIEC(const string_view& str, int64_t* value) {
+    return parseUnits(str, false, value);
+}
+
+void Lute::appendJsonEscaped(std::string* out, const string_view& str) {
+    for (size_t i = 0; i < str.size(); ++i) {
+        const char c = str[i];
+        switch (c) {
+            case '"':
+                out->append("\\\"");
+                break;
+            case '\\':
+                out->append("\\\\");
+                break;
+            case '\n':
+                out->append("\\n");
+                break;
+            case '\r':
+                out->append("\\r");
+                break;
+            case '\t':
+                out->append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    ::snprintf(buf, sizeof buf, "\\u%04x",
+                               static_cast<unsigned>(c));
+                    out->append(buf);
+                } else {
+                    out->push_back(c);
+                }
+        }
+    }
 }
 
 /// ----------------------
@@ -0,0 +1,57 @@
+#include <Base/ahoCorasick.h>
+
+#include <cassert>
+#include <iostream>
+#include <string>
+
+int main() {
+    {
+        Lute::AhoCorasick ac({{"", "ignored"},
+                              {"${host}", "lute"},
+                              {"${pid}", "42"},
+                              {"${level}", "INFO"}});
+        const std::string line = ac.replace("[${level}] ${host}:${pid} up");
+        std::cout << line << std::endl;
+        assert(line == "[INFO] lute:42 up");
+        assert(ac.count("${pid}${pid}${unknown}") == 2);
+        assert(ac.replace("") == "");
+        assert(ac.replace("nothing here") == "nothing here");
+    }
+
+    {
+        /// leftmost wins, then longest
+        Lute::AhoCorasick ac({{"bc", "X"}, {"abcd", "Y"}, {"ab", "Z"}});
+        assert(ac.replace("abcd") == "Y");
+        assert(ac.replace("abce") == "Zce");
+        assert(ac.replace("xbcd") == "xXd");
+
+        Lute::AhoCorasick::Match m = ac.find("__abcd", 0);
+        assert(m.found() && m.start == 2 && m.length == 4 && m.index == 1);
+        assert(!ac.find("__abcd", 5).found());
+    }
+
+    {
+        /// replacements aren't rescanned, matches don't overlap
+        Lute::AhoCorasick ac({{"a", "aa"}, {"aa", "b"}});
+        assert(ac.replace("aaa") == "baa");
+
+        Lute::AhoCorasick classic({{"he", "1"}, {"she", "2"},
+                                   {"his", "3"}, {"hers", "4"}});
+        assert(classic.replace("ushers") == "u2rs");
+        assert(classic.replace("ahishers") == "a34");
+    }
+
+    {
+        /// all 256 byte values in the patterns
+        std::string all;
+        for (int c = 0; c < 256; ++c) all.push_back(static_cast<char>(c));
+        Lute::AhoCorasick ac({{all.substr(250), "<tail>"},
+                              {std::string(1, '\0'), "<nul>"}});
+        assert(ac.replace(all + all) ==
+               "<nul>" + all.substr(1, 249) + "<tail><nul>" +
+                   all.substr(1, 249) + "<tail>");
+    }
+
+    std::cout << "ahoCorasick_test passed" << std::endl;
+    return 0;
+}
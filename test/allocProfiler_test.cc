@@ -0,0 +1,146 @@
+///
+/// Runs itself under LD_PRELOAD of the allocation profiler, sampling every
+/// allocation, then checks the folded report names each allocating function.
+///
+
+#include <dirent.h>    // opendir
+#include <signal.h>    // raise SIGUSR2
+#include <sys/wait.h>  // waitpid
+#include <unistd.h>    // fork execv getpid
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+__attribute__((noinline)) void* hotMalloc() { return malloc(100); }
+__attribute__((noinline)) void* hotCalloc() { return calloc(10, 10); }
+__attribute__((noinline)) void* hotRealloc(void* p) { return realloc(p, 1000); }
+__attribute__((noinline)) void* hotMemalign() {
+    void* p = nullptr;
+    return posix_memalign(&p, 64, 256) == 0 ? p : nullptr;
+}
+__attribute__((noinline)) std::vector<int>* hotNew() {
+    return new std::vector<int>(100);
+}
+}
+
+/// @brief Remove the dumps of `pid`
+int removeDumps(const std::string& prefix, pid_t pid) {
+    const std::string dir = prefix.substr(0, prefix.rfind('/'));
+    const std::string name = prefix.substr(prefix.rfind('/') + 1) + "." +
+                             std::to_string(pid) + ".";
+    int found = 0;
+    DIR* d = ::opendir(dir.c_str());
+    while (struct dirent* entry = ::readdir(d)) {
+        if (::strncmp(entry->d_name, name.c_str(), name.size()) != 0)
+            continue;
+        ::unlink((dir + "/" + entry->d_name).c_str());
+        ++found;
+    }
+    ::closedir(d);
+    return found;
+}
+
+/// @brief fork() while another thread is inside the profiler: the child
+///        must not inherit its lock held and dumps on its own
+void forkWhileAllocating() {
+    const std::string prefix = ::getenv("LUTE_ALLOCPROF_OUT");
+    std::atomic<bool> stop(false);
+    std::thread churn([&stop] {
+        while (!stop) free(hotMalloc());
+    });
+    for (int i = 0; i < 20; ++i) {
+        const pid_t pid = ::fork();
+        if (pid == 0) {
+            free(hotMalloc());
+            ::raise(SIGUSR2);
+            ::usleep(50 * 1000);
+            /// runs the exit dump
+            std::exit(0);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        /// the signal dump and the exit dump
+        const int dumps = removeDumps(prefix, pid);
+        assert(dumps == 4);
+        (void)dumps;
+    }
+    stop = true;
+    churn.join();
+}
+
+int child() {
+    void* a = hotMalloc();
+    void* b = hotCalloc();
+    void* c = hotRealloc(malloc(10));
+    void* d = hotMemalign();
+    std::vector<int>* v = hotNew();
+
+    /// first dump from the signal, the second one at exit
+    ::raise(SIGUSR2);
+    ::usleep(200 * 1000);
+
+    free(a);
+    free(b);
+    free(c);
+    free(d);
+    delete v;
+
+    forkWhileAllocating();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (::getenv("LUTE_ALLOCPROF_CHILD") != nullptr) return child();
+
+    char prefix[64];
+    ::snprintf(prefix, sizeof prefix, "/tmp/allocprof_test");
+    ::setenv("LD_PRELOAD", ALLOC_PROFILER_LIB, 1);
+    ::setenv("LUTE_ALLOCPROF_RATE", "1", 1);
+    ::setenv("LUTE_ALLOCPROF_OUT", prefix, 1);
+    ::setenv("LUTE_ALLOCPROF_CHILD", "1", 1);
+
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        ::execv(argv[0], argv);
+        _exit(127);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    (void)argc;
+
+    for (int seq = 1; seq <= 2; ++seq) {
+        const std::string base =
+            std::string(prefix) + "." + std::to_string(pid) + "." +
+            std::to_string(seq);
+        std::ifstream folded(base + ".folded");
+        std::stringstream ss;
+        ss << folded.rdbuf();
+        const std::string report = ss.str();
+        for (const char* name :
+             {"hotMalloc", "hotCalloc", "hotRealloc", "hotMemalign", "hotNew"})
+            assert(report.find(name) != std::string::npos);
+
+        std::ifstream heap(base + ".heap");
+        std::string header;
+        std::getline(heap, header);
+        assert(header.find("heap profile:") == 0);
+        assert(header.find("@ heap_v2/1") != std::string::npos);
+        std::cout << base << ": " << header << std::endl;
+
+        ::unlink((base + ".folded").c_str());
+        ::unlink((base + ".heap").c_str());
+    }
+    return 0;
+}
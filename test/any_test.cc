@@ -40,6 +40,26 @@ struct regression1_type {
     regression1_type& operator=(regression1_type&&) { return *this; }
 };
 
+/// Stateless allocator counting allocations, shared by every rebind
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+    static int allocations;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        ++CountingAllocator<char>::allocations;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+};
+
+template <typename T>
+int CountingAllocator<T>::allocations = 0;
+
 int main() {
 #if __cplusplus >= 201703L
     std::cout << std::boolalpha;
@@ -231,4 +251,68 @@ int main() {
 #endif
     }
 #endif
+
+    // basic_any: bigger inline buffer
+    {
+        Lute::basic_any<64> small = words<8>();
+        CHECK(small.is_inline());
+        Lute::basic_any<64> large = words<9>();
+        CHECK(large.has_value() && !large.is_inline());
+        Lute::basic_any<64> copy = small;
+        CHECK(Lute::any_cast<words<8> >(&copy) != nullptr);
+        CHECK(Lute::any_cast<int>(&copy) == nullptr);
+
+        std::shared_ptr<int> ptr_count(new int);
+        std::weak_ptr<int> weak = ptr_count;
+        Lute::basic_any<64> p0 = ptr_count;
+        Lute::basic_any<64> p1 = p0;
+        CHECK(weak.use_count() == 3);
+        p0.swap(large);
+        CHECK(Lute::any_cast<words<9> >(&p0) != nullptr);
+        large = big_type();
+        CHECK(weak.use_count() == 2 && Lute::any_cast<big_type>(large).check());
+        p1.reset();
+        CHECK(weak.use_count() == 1 && !p1.has_value());
+
+        bool thrown = false;
+        try {
+            Lute::any_cast<float>(small);
+        } catch (const Lute::bad_any_cast&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    // unique_any: move-only values
+    {
+        Lute::unique_any<> u = std::unique_ptr<int>(new int(7));
+        CHECK(u.is_inline());
+        Lute::unique_any<> v = std::move(u);
+        CHECK(!u.has_value() && **Lute::any_cast<std::unique_ptr<int> >(&v) == 7);
+        std::unique_ptr<int> out =
+            Lute::any_cast<std::unique_ptr<int> >(std::move(v));
+        CHECK(*out == 7);
+
+        std::unique_ptr<int> captured(new int(9));
+        auto task = [p = std::move(captured)] { return *p; };
+        Lute::unique_any<> t;
+        t.emplace<decltype(task)>(std::move(task));
+        CHECK((*Lute::any_cast<decltype(task)>(&t))() == 9);
+        static_assert(!std::is_copy_constructible<Lute::unique_any<> >::value,
+                      "unique_any must be move-only");
+    }
+
+    // allocator hook for values that don't fit
+    {
+        CountingAllocator<char>::allocations = 0;
+        using counted_any =
+            Lute::basic_any<16, true, CountingAllocator<char> >;
+        counted_any a = words<2>();
+        CHECK(CountingAllocator<char>::allocations == 0);
+        counted_any b = big_type();
+        counted_any c = b;
+        CHECK(CountingAllocator<char>::allocations == 2);
+        CHECK(Lute::any_cast<big_type>(c).check());
+    }
+    std::cout << "basic_any / unique_any ok\n";
 }
@@ -0,0 +1,151 @@
+#include <Base/arena.h>
+#include <Base/bytearray.h>
+#include <Base/ini_config.h>
+#include <Base/thread.h>
+
+#include <cassert>
+#include <iostream>
+#include <list>
+#include <set>
+#include <vector>
+
+void testArena() {
+    Lute::Arena arena(1024);
+    const size_t reserved = arena.reservedBytes();
+
+    char* a = static_cast<char*>(arena.allocate(10, 1));
+    char* b = static_cast<char*>(arena.allocate(10, 1));
+    assert(b == a + 10);
+    auto* d = arena.create<double>(3.5);
+    assert(reinterpret_cast<uintptr_t>(d) % alignof(double) == 0);
+    assert(*d == 3.5);
+
+    /// spills into new blocks, the big one gets a block of its own
+    for (int i = 0; i < 100; ++i) arena.allocate(100);
+    arena.allocateArray<char>(4096);
+    assert(arena.allocatedBytes() == 20 + sizeof(double) + 100 * 100 + 4096);
+    const size_t grown = arena.reservedBytes();
+    assert(grown > reserved);
+
+    /// reset keeps the regular blocks, frees the big one
+    arena.reset();
+    assert(arena.allocatedBytes() == 0);
+    assert(arena.reservedBytes() < grown);
+    assert(arena.allocate(10, 1) == a);
+    const size_t kept = arena.reservedBytes();
+    for (int i = 0; i < 100; ++i) arena.allocate(100);
+    assert(arena.reservedBytes() == kept);
+
+    arena.release();
+    assert(arena.reservedBytes() == 0);
+    std::cout << "arena reserved " << grown << " bytes at most" << std::endl;
+}
+
+void testArenaResource() {
+    Lute::Arena arena;
+    Lute::ArenaResource resource(&arena);
+    {
+        std::pmr::vector<int> v(&resource);
+        for (int i = 0; i < 1000; ++i) v.push_back(i);
+        assert(v[999] == 999);
+    }
+    assert(arena.allocatedBytes() >= 1000 * sizeof(int));
+    arena.reset();
+}
+
+void testPool() {
+    assert(Lute::ThreadCachePool::roundUp(1) == 16);
+    assert(Lute::ThreadCachePool::roundUp(129) == 160);
+    assert(Lute::ThreadCachePool::roundUp(4096) == 4096);
+    assert(Lute::ThreadCachePool::roundUp(4097) == 5120);
+
+    /// a freed object is handed out again by the same thread
+    void* p = Lute::ThreadCachePool::allocate(24);
+    Lute::ThreadCachePool::deallocate(p, 24);
+    assert(Lute::ThreadCachePool::allocate(20) == p);
+    Lute::ThreadCachePool::deallocate(p, 20);
+
+    /// distinct live objects
+    std::set<void*> live;
+    for (int i = 0; i < 1000; ++i)
+        assert(live.insert(Lute::ThreadCachePool::allocate(100)).second);
+    for (void* q : live) Lute::ThreadCachePool::deallocate(q, 100);
+
+    /// larger than kMaxSize falls through to operator new
+    void* big = Lute::ThreadCachePool::allocate(1 << 20);
+    Lute::ThreadCachePool::deallocate(big, 1 << 20);
+
+    std::list<int, Lute::PoolAllocator<int>> list;
+    for (int i = 0; i < 1000; ++i) list.push_back(i);
+    assert(list.size() == 1000 && list.back() == 999);
+
+    std::pmr::vector<std::pmr::string> strings(
+        Lute::PoolResource::instance());
+    for (int i = 0; i < 100; ++i)
+        strings.emplace_back(100, static_cast<char>('a' + i % 26));
+    assert(strings[27] == std::pmr::string(100, 'b'));
+    std::cout << "pool reserved " << Lute::ThreadCachePool::reservedBytes()
+              << " bytes" << std::endl;
+}
+
+void testPoolThreads() {
+    /// objects allocated by one thread and freed by others
+    const int kObjects = 10000;
+    std::vector<void*> objects(kObjects);
+    for (auto& p : objects) p = Lute::ThreadCachePool::allocate(64);
+
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back(new Lute::Thread([&objects, t] {
+            for (int i = t; i < kObjects; i += 4)
+                Lute::ThreadCachePool::deallocate(objects[i], 64);
+            /// churn in the thread's own cache, flushed when it exits
+            for (int i = 0; i < 1000; ++i) {
+                void* p = Lute::ThreadCachePool::allocate(48);
+                Lute::ThreadCachePool::deallocate(p, 48);
+            }
+        }));
+        threads.back()->start();
+    }
+    for (auto& thread : threads) thread->join();
+
+    const size_t reserved = Lute::ThreadCachePool::reservedBytes();
+    for (auto& p : objects) p = Lute::ThreadCachePool::allocate(64);
+    /// everything freed by the exited threads went back to the central lists
+    assert(Lute::ThreadCachePool::reservedBytes() == reserved);
+    for (auto& p : objects) Lute::ThreadCachePool::deallocate(p, 64);
+}
+
+void testByteArray() {
+    Lute::ByteArray ba(64, Lute::PoolResource::instance());
+    for (int i = 0; i < 100; ++i) ba.writeInt32(i);
+    ba.setPosition(0);
+    for (int i = 0; i < 100; ++i) assert(ba.readInt32() == i);
+    ba.clear();
+}
+
+void testINI() {
+    Lute::Arena arena;
+    Lute::ArenaResource resource(&arena);
+    Lute::ini::INIStructure ini(&resource);
+    ini["fruit"]["apple"] = "red";
+    ini["vegetable"]["carrot"] = "orange";
+    assert(ini["fruit"].get_allocator().resource() == &resource);
+    assert(ini.get("FRUIT").get("apple") == "red");
+    assert(arena.allocatedBytes() > 0);
+
+    Lute::ini::INIStructure copy(ini);
+    assert(copy.get_allocator().resource() == std::pmr::get_default_resource());
+    assert(copy["vegetable"]["carrot"] == "orange");
+}
+
+int main() {
+    testArena();
+    testArenaResource();
+    testPool();
+    testPoolThreads();
+    testByteArray();
+    testINI();
+    std::cout << "arena test passed" << std::endl;
+    return 0;
+}
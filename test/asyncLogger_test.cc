@@ -0,0 +1,288 @@
+#include <Base/logger.h>
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <Base/thread.h>
+#include <Base/utils.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+const char* kBasename = "asyncLogger_test";
+
+int64_t nowMs() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t cpuMs() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// @brief The log files named `prefix`* in the working directory
+std::vector<std::string> logFiles(const std::string& prefix) {
+    std::vector<std::string> names;
+    DIR* dir = ::opendir(".");
+    while (struct dirent* entry = ::readdir(dir)) {
+        if (::strncmp(entry->d_name, prefix.data(), prefix.size()) == 0)
+            names.push_back(entry->d_name);
+    }
+    ::closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::string logFileName() {
+    std::vector<std::string> names = logFiles(std::string(kBasename) + ".");
+    return names.empty() ? std::string() : names.back();
+}
+
+bool fileContains(const std::string& file, const std::string& text) {
+    std::ifstream in(file);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str().find(text) != std::string::npos;
+}
+
+/// @return ms until `text` shows up in the file, -1 after 2s
+int64_t waitForLine(const std::string& file, const std::string& text) {
+    const int64_t start = nowMs();
+    while (nowMs() - start < 2000) {
+        if (fileContains(file, text)) return nowMs() - start;
+        ::usleep(1000);
+    }
+    return -1;
+}
+}  // namespace
+
+int main() {
+    {
+        /// flushInterval 30s: without the max delay nothing shows up
+        const int kMaxDelayMs = 10;
+        Lute::AsyncLogger logger(kBasename, 64 * 1024 * 1024, 30);
+        logger.setMaxDelay(kMaxDelayMs);
+        logger.setNotifyBytes(64 * 1024);
+        logger.start();
+        /// the backend creates the file once it runs
+        std::string file;
+        for (int i = 0; i < 2000 && file.empty(); ++i) {
+            file = logFileName();
+            ::usleep(1000);
+        }
+        assert(!file.empty());
+
+        for (int i = 0; i < 5; ++i) {
+            /// an idle backend, then a single line
+            ::usleep(50 * 1000);
+            const std::string line = "audit line " + std::to_string(i) + "\n";
+            logger.append(line.data(), static_cast<int>(line.size()));
+            const int64_t ms = waitForLine(file, line);
+            std::cout << "line " << i << " on disk after " << ms << "ms"
+                      << std::endl;
+            /// the delay, plus slack for a busy machine
+            assert(ms >= 0 && ms < kMaxDelayMs + 100);
+        }
+
+        /// crossing the notify threshold doesn't wait for the delay
+        std::string chunk(1023, 'x');
+        chunk.push_back('\n');
+        for (int i = 0; i < 64; ++i)
+            logger.append(chunk.data(), static_cast<int>(chunk.size()));
+        assert(waitForLine(file, chunk) >= 0);
+
+        logger.stop();
+        ::unlink(file.c_str());
+    }
+    {
+        const std::string basename = std::string(kBasename) + "_sharded";
+        Lute::ShardedAsyncLogger logger(basename, 64 * 1024 * 1024, 3);
+        logger.start();
+        assert(logger.shardOf("audit") == logger.shardOf("audit"));
+
+        const int kThreads = 4;
+        const int kLines = 10000;
+        std::vector<std::unique_ptr<Lute::Thread>> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back(new Lute::Thread([&logger, t] {
+                for (int i = 0; i < kLines; ++i) {
+                    const std::string line = "thread " + std::to_string(t) +
+                                             " line " + std::to_string(i) +
+                                             "\n";
+                    logger.append(line.data(), static_cast<int>(line.size()));
+                }
+            }));
+            threads.back()->start();
+        }
+        for (auto& thread : threads) thread->join();
+        logger.stop();
+
+        /// every thread wrote all its lines to one shard, in order
+        std::vector<int> next(kThreads, 0);
+        const std::vector<std::string> files = logFiles(basename + "-");
+        assert(static_cast<int>(files.size()) == logger.size());
+        for (const std::string& file : files) {
+            std::ifstream in(file);
+            std::string word, text;
+            int t, i;
+            while (in >> word >> t >> text >> i) {
+                assert(i == next[static_cast<size_t>(t)]);
+                ++next[static_cast<size_t>(t)];
+            }
+            ::unlink(file.c_str());
+        }
+        for (int n : next) assert(n == kLines);
+        std::cout << files.size() << " shards, " << kThreads * kLines
+                  << " lines" << std::endl;
+    }
+    {
+        /// rolls by period every second and by size, the spare file is
+        /// swapped in while the roller thread renames and closes
+        const std::string basename = std::string(kBasename) + "_roll";
+        const std::string line(99, 'r');
+        int64_t lines = 0;
+        int64_t slowest = 0;
+        {
+            Lute::LogFile file(basename, 256 * 1024, false, 3, 1);
+            file.setRollPeriod(1);
+            const int64_t start = nowMs();
+            while (nowMs() - start < 3500) {
+                struct timespec t0, t1;
+                ::clock_gettime(CLOCK_MONOTONIC, &t0);
+                file.append((line + "\n").data(),
+                            static_cast<int>(line.size() + 1));
+                ::clock_gettime(CLOCK_MONOTONIC, &t1);
+                slowest = std::max<int64_t>(
+                    slowest, int64_t(t1.tv_sec - t0.tv_sec) * 1000000000 +
+                                 t1.tv_nsec - t0.tv_nsec);
+                ++lines;
+                if (lines % 1000 == 0) ::usleep(1000);
+            }
+        }
+        /// the hidden spare is gone with the LogFile
+        assert(logFiles("." + basename).empty());
+        const std::vector<std::string> files = logFiles(basename + ".");
+        int64_t total = 0;
+        for (const std::string& name : files) {
+            std::ifstream in(name);
+            std::string text;
+            while (std::getline(in, text)) {
+                assert(text == line);
+                ++total;
+            }
+            ::unlink(name.c_str());
+        }
+        assert(files.size() >= 4);
+        assert(total == lines);
+        std::cout << files.size() << " rolled files, " << lines
+                  << " lines, slowest append " << slowest / 1000 << "us"
+                  << std::endl;
+    }
+    {
+        /// regions shrunk out of order leave more holes than the buffer's
+        /// table holds: the rest spill over, nothing shows in the output
+        const std::string basename = std::string(kBasename) + "_holes";
+        const int kPairs = 3000;
+        {
+            Lute::AsyncLogger logger(basename, 64 * 1024 * 1024, 30);
+            logger.start();
+            for (int i = 0; i < kPairs; ++i) {
+                Lute::Logger::Reservation first, second;
+                assert(logger.reserve(64, &first));
+                assert(logger.reserve(64, &second));
+                const std::string a = "first " + std::to_string(i) + "\n";
+                const std::string b = "second " + std::to_string(i) + "\n";
+                ::memcpy(second.data, b.data(), b.size());
+                logger.commit(second, static_cast<int>(b.size()));
+                ::memcpy(first.data, a.data(), a.size());
+                logger.commit(first, static_cast<int>(a.size()));
+            }
+            logger.stop();
+        }
+        std::vector<std::string> files = logFiles(basename + ".");
+        assert(files.size() == 1);
+        std::ifstream in(files[0]);
+        std::string text;
+        int lines = 0;
+        while (std::getline(in, text)) {
+            const int i = lines / 2;
+            assert(text == (lines % 2 == 0 ? "first " : "second ") +
+                               std::to_string(i));
+            ++lines;
+        }
+        assert(lines == 2 * kPairs);
+        ::unlink(files[0].c_str());
+
+        /// the backend sleeps, rather than spins, on a line slow to commit
+        {
+            Lute::AsyncLogger logger(basename, 64 * 1024 * 1024, 30);
+            logger.setMaxDelay(10);
+            logger.start();
+            Lute::Logger::Reservation slow;
+            assert(logger.reserve(64, &slow));
+            ::memcpy(slow.data, "slow\n", 5);
+            const int64_t cpu = cpuMs();
+            ::usleep(300 * 1000);
+            const int64_t spent = cpuMs() - cpu;
+            logger.commit(slow, 5);
+            files = logFiles(basename + ".");
+            assert(files.size() == 1 && waitForLine(files[0], "slow\n") >= 0);
+            logger.stop();
+            std::cout << kPairs << " out of order pairs, " << spent
+                      << "ms cpu waiting for a slow line" << std::endl;
+            assert(spent < 100);
+        }
+        ::unlink(files[0].c_str());
+    }
+    {
+        /// a spare left by a dead process is removed; a forked child
+        /// rolls without the parent's roller thread and exits
+        const std::string basename = std::string(kBasename) + "_fork";
+        const pid_t dead = ::fork();
+        if (dead == 0) ::_exit(0);
+        ::waitpid(dead, nullptr, 0);
+        const std::string stale = "." + basename + "." +
+                                  Lute::ProcessInfo::hostname() + "." +
+                                  std::to_string(dead) + ".log.1.next";
+        std::ofstream(stale) << "stale";
+        {
+            Lute::LogFile file(basename, 1024 * 1024, false);
+            file.append("parent\n", 7);
+            const pid_t pid = ::fork();
+            if (pid == 0) {
+                /// a hang fails the test instead of blocking it
+                ::alarm(10);
+                ::sleep(1);
+                file.append("child\n", 6);
+                assert(file.rollFile());
+                file.append("child\n", 6);
+                file.flush();
+                return 0;
+            }
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        assert(logFiles(stale).empty());
+        assert(logFiles("." + basename).empty());
+        const std::vector<std::string> files = logFiles(basename + ".");
+        assert(files.size() >= 2);
+        for (const std::string& name : files) ::unlink(name.c_str());
+        std::cout << "forked child rolled " << files.size() - 1 << " file"
+                  << std::endl;
+    }
+    std::cout << "asyncLogger test passed" << std::endl;
+    return 0;
+}
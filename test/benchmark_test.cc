@@ -0,0 +1,64 @@
+#include <Base/benchmark.h>
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static int64_t g_runs = 0;
+static int64_t g_lastIterations = 0;
+
+static void BM_sum(Lute::bench::State& state) {
+    ++g_runs;
+    int64_t sum = 0;
+    while (state.keepRunning()) {
+        sum += state.iterations();
+        Lute::bench::DoNotOptimize(sum);
+    }
+    g_lastIterations = state.iterations();
+    assert(sum == state.iterations() * state.iterations());
+}
+LUTE_BENCHMARK(BM_sum);
+
+static void BM_arg(Lute::bench::State& state) {
+    assert(state.arg() == 7);
+    while (state.keepRunning()) {
+        Lute::bench::ClobberMemory();
+    }
+}
+LUTE_BENCHMARK_ARG(BM_arg, 7);
+
+/// a name the JSON report has to escape
+static int g_quoted = Lute::bench::registerBenchmark(
+    "BM_\"quoted\"\\", [](Lute::bench::State& state) {
+        while (state.keepRunning()) Lute::bench::ClobberMemory();
+    });
+
+int main() {
+    char prog[] = "benchmark_test";
+    char minTime[] = "--min_time=0.001";
+    char samples[] = "--samples=3";
+    char json[] = "--json=benchmark_test.json";
+    char* argv[] = {prog, minTime, samples, json};
+    int rc = Lute::bench::runBenchmarks(4, argv);
+    assert(rc == 0);
+    (void)rc;
+    (void)g_quoted;
+
+    /// scaling + warmup + 3 samples
+    assert(g_runs >= 5);
+    assert(g_lastIterations > 1);
+
+    std::ifstream ifs("benchmark_test.json");
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    const std::string out = ss.str();
+    printf("%s", out.c_str());
+    assert(out.find("\"BM_sum\"") != std::string::npos);
+    assert(out.find("\"BM_arg/7\"") != std::string::npos);
+    assert(out.find("\"BM_\\\"quoted\\\"\\\\\"") != std::string::npos);
+    assert(out.find("\"p99\"") != std::string::npos);
+    ::remove("benchmark_test.json");
+    return 0;
+}
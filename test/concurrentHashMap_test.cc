@@ -0,0 +1,137 @@
+#include <Base/concurrentHashMap.h>
+#include <Base/thread.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+struct Tracked {
+    static std::atomic<int> live;
+    explicit Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(const Tracked& other) : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked&) = default;
+    ~Tracked() { --live; }
+    int value;
+};
+std::atomic<int> Tracked::live(0);
+}  // namespace
+
+void testBasic() {
+    Lute::ConcurrentHashMap<std::string, int> map;
+    assert(map.empty());
+    assert(map.insertOrAssign("one", 1));
+    assert(map.insertOrAssign("two", 2));
+    assert(!map.insertOrAssign("one", 11));
+    assert(map.size() == 2);
+
+    int value = 0;
+    assert(map.find("one", &value) && value == 11);
+    assert(!map.find("three", &value));
+    assert(map.contains("two"));
+
+    assert(map.erase("two"));
+    assert(!map.erase("two"));
+    assert(!map.contains("two"));
+    assert(map.size() == 1);
+
+    auto entries = map.snapshot();
+    assert(entries.size() == 1 && entries[0].first == "one");
+}
+
+void testGrow() {
+    Lute::ConcurrentHashMap<int, int> map;
+    const size_t buckets = map.bucketCount();
+    for (int i = 0; i < 10000; ++i) map.insertOrAssign(i, i * 2);
+    assert(map.size() == 10000);
+    assert(map.bucketCount() > buckets);
+    for (int i = 0; i < 10000; ++i) {
+        int value = -1;
+        assert(map.find(i, &value) && value == i * 2);
+    }
+    int64_t sum = 0;
+    map.forEach([&sum](int, int v) { sum += v; });
+    assert(sum == 2LL * (9999LL * 10000 / 2));
+    std::cout << map.size() << " entries in " << map.bucketCount()
+              << " buckets" << std::endl;
+}
+
+void testConcurrent() {
+    {
+        Lute::ConcurrentHashMap<int, Tracked> map;
+        const int kKeys = 1000;
+        for (int i = 0; i < kKeys; ++i) map.insertOrAssign(i, Tracked(i));
+
+        std::atomic<bool> stop(false);
+        std::atomic<int64_t> misses(0);
+        std::vector<std::unique_ptr<Lute::Thread>> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back(new Lute::Thread([&] {
+                Tracked value;
+                int64_t n = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const int key = static_cast<int>(n++ % kKeys);
+                    /// even keys are never erased, values only grow by kKeys
+                    if (map.find(key, &value))
+                        assert(value.value % kKeys == key);
+                    else if (key % 2 == 0)
+                        ++misses;
+                }
+            }));
+            readers.back()->start();
+        }
+
+        Lute::Thread writer([&map] {
+            for (int round = 1; round <= 50; ++round) {
+                for (int i = 0; i < kKeys; ++i) {
+                    if (i % 2 == 1 && round % 2 == 1)
+                        map.erase(i);
+                    else
+                        map.insertOrAssign(i, Tracked(i + round * kKeys));
+                }
+            }
+            /// grows the table while the readers run
+            for (int i = kKeys; i < 20 * kKeys; i += 2)
+                map.insertOrAssign(i, Tracked(i));
+            Lute::Epoch::synchronize();
+        });
+        writer.start();
+        writer.join();
+        stop = true;
+        for (auto& reader : readers) reader->join();
+        assert(misses == 0);
+    }
+    Lute::Epoch::synchronize();
+    assert(Tracked::live == 0);
+}
+
+void testEpoch() {
+    static std::atomic<int> freed(0);
+    const uint64_t start = Lute::Epoch::current();
+    {
+        Lute::Epoch::Guard guard;
+        Lute::Epoch::retire(new int(1), [](void* p) {
+            delete static_cast<int*>(p);
+            ++freed;
+        });
+        /// our own guard holds the epoch back
+        Lute::Epoch::reclaim();
+        Lute::Epoch::reclaim();
+        assert(freed == 0);
+    }
+    Lute::Epoch::synchronize();
+    assert(freed == 1);
+    assert(Lute::Epoch::current() >= start + 2);
+}
+
+int main() {
+    testBasic();
+    testGrow();
+    testEpoch();
+    testConcurrent();
+    std::cout << "concurrentHashMap test passed" << std::endl;
+    return 0;
+}
@@ -1,7 +1,81 @@
+#include <Base/countDownLatch.h>
 #include <Base/currentThread.h>
+#include <Base/thread.h>
 #include <Base/utils.h>
+#include <sys/wait.h>  // waitpid
+#include <unistd.h>    // fork
 
+#include <cassert>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+void testRegistry() {
+    /// the main thread registers at startup
+    assert(Lute::CurrentThread::index() == 0);
+    assert(Lute::ThreadRegistry::size() == 1);
+
+    const int kThreads = 4;
+    Lute::CountDownLatch running(kThreads);
+    Lute::CountDownLatch done(1);
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    std::vector<int> indices(kThreads, -1);
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back(new Lute::Thread(
+            [&, i] {
+                indices[i] = Lute::CurrentThread::index();
+                running.countDown();
+                done.wait();
+            },
+            "worker"));
+        threads.back()->start();
+    }
+    running.wait();
+
+    /// dense: 0 is main, the workers took 1..kThreads
+    std::vector<bool> seen(kThreads + 1, false);
+    for (int index : indices) {
+        assert(index > 0 && index <= kThreads);
+        assert(!seen[index]);
+        seen[index] = true;
+    }
+    auto snapshot = Lute::ThreadRegistry::snapshot();
+    assert(snapshot.size() == kThreads + 1);
+    assert(snapshot[0].name == "main" && snapshot[0].tid == ::getpid());
+    for (int i = 1; i <= kThreads; ++i) {
+        assert(snapshot[i].index == i);
+        assert(snapshot[i].name == "worker");
+    }
+    for (const auto& info : snapshot)
+        std::cout << "thread " << info.index << " tid " << info.tid << " "
+                  << info.name << std::endl;
+    assert(threads[0]->tid() > 0 && threads[0]->tid() != ::getpid());
+
+    done.countDown();
+    for (auto& thread : threads) thread->join();
+    assert(Lute::ThreadRegistry::size() == 1);
+    assert(Lute::ThreadRegistry::indexLimit() == kThreads + 1);
+
+    /// freed indices are handed out again, lowest first
+    int reused = -1;
+    Lute::Thread again([&reused] { reused = Lute::CurrentThread::index(); });
+    again.start();
+    again.join();
+    assert(reused == 1);
+}
+
+void testFork() {
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        bool ok = Lute::CurrentThread::tid() == ::getpid() &&
+                  Lute::CurrentThread::index() == 0 &&
+                  Lute::ThreadRegistry::size() == 1;
+        ::_exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
 
 int main() {
     std::cout << Lute::CurrentThread::tid() << std::endl;
@@ -9,6 +83,8 @@ int main() {
     std::cout << Lute::CurrentThread::tidStringLength() << std::endl;
     std::cout << Lute::CurrentThread::tidString() << std::endl;
     std::cout << Lute::CurrentThread::isMainThread() << std::endl;
+    std::cout << "cpu " << Lute::CurrentThread::cpu() << std::endl;
+    assert(Lute::CurrentThread::cpu() >= 0);
     std::cout << Lute::CurrentThread::stackTrace(false) << std::endl;
     std::cout << " --- " << std::endl;
     std::cout << Lute::CurrentThread::stackTrace(true) << std::endl;
@@ -18,5 +94,8 @@ int main() {
     Lute::CurrentThread::sleepUsec(1000);
     PONG(sleepUsec);
 
+    testRegistry();
+    testFork();
+    std::cout << "currentThread test passed" << std::endl;
     return 0;
-}
\ No newline at end of file
+}
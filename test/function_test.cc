@@ -0,0 +1,83 @@
+#include <Base/MTQueue.h>
+#include <Base/function.h>
+#include <Base/thread.h>
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+
+int add(int a, int b) { return a + b; }
+
+struct Counter {
+    int value = 0;
+    void bump(int n) { value += n; }
+};
+
+int main() {
+    /// InplaceFunction: copyable, inline only
+    Lute::InplaceFunction<int(int, int)> f = add;
+    assert(f && f(2, 3) == 5 && f.is_inline());
+    Lute::InplaceFunction<int(int, int)> g = f;
+    assert(g(4, 5) == 9);
+    int base = 10;
+    g = [base](int a, int b) { return base + a * b; };
+    assert(g(2, 3) == 16);
+
+    Lute::InplaceFunction<int(int, int)> empty;
+    assert(!empty);
+    int (*null)(int, int) = nullptr;
+    empty = null;
+    assert(!empty);
+    bool thrown = false;
+    try {
+        empty(1, 2);
+    } catch (const std::bad_function_call&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    /// member function pointers go through std::invoke
+    Counter counter;
+    Lute::InplaceFunction<void(Counter&, int)> bump = &Counter::bump;
+    bump(counter, 3);
+    assert(counter.value == 3);
+
+    /// UniqueFunction: move-only captures, heap fallback when too big
+    std::unique_ptr<std::string> owned(new std::string("owned"));
+    Lute::UniqueFunction<std::string()> u = [p = std::move(owned)] {
+        return *p;
+    };
+    assert(u.is_inline() && u() == "owned");
+    Lute::UniqueFunction<std::string()> v = std::move(u);
+    assert(!u && v() == "owned");
+
+    char big[128] = "big";
+    Lute::UniqueFunction<std::string()> w = [big] { return std::string(big); };
+    assert(!w.is_inline() && w() == "big");
+    v.swap(w);
+    assert(v() == "big" && w() == "owned");
+    w = nullptr;
+    assert(!w);
+
+    /// a task queue of UniqueFunction, run by a Lute::Thread
+    Lute::MTQueue<Lute::UniqueFunction<void()> > tasks;
+    int sum = 0;
+    Lute::Thread worker(
+        [&tasks] {
+            for (int i = 0; i < 100; ++i) {
+                Lute::UniqueFunction<void()> task = tasks.pop();
+                task();
+            }
+        },
+        "worker");
+    worker.start();
+    for (int i = 1; i <= 100; ++i) tasks.emplace([&sum, i] { sum += i; });
+    worker.join();
+    assert(sum == 5050);
+
+    std::cout << "sizeof(UniqueFunction<void()>) = "
+              << sizeof(Lute::UniqueFunction<void()>) << ", sum = " << sum
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef LOG_MERGE
+#error "LOG_MERGE must name the logMerge binary"
+#endif
+
+namespace {
+const int kShards = 3;
+const int kRecords = 2000;
+
+/// @brief `2026/10/17 12:MM:SS.uuuuuu` for `us` microseconds past 12:00
+std::string timestamp(int64_t us) {
+    char buf[32];
+    ::snprintf(buf, sizeof buf, "2026/10/17 12:%02d:%02d.%06d",
+               static_cast<int>(us / 60000000),
+               static_cast<int>(us / 1000000 % 60),
+               static_cast<int>(us % 1000000));
+    return buf;
+}
+}  // namespace
+
+int main() {
+    char dir[] = "/tmp/logMerge_test.XXXXXX";
+    assert(::mkdtemp(dir) != nullptr);
+    const std::string prefix = std::string(dir) + "/Lute-";
+
+    /// record `j` of shard `s` is stamped j*300 + s*100 us: the shards
+    /// interleave. Every third block of 100 records is written backwards,
+    /// up to 30ms out of order, as by threads descheduled between stamping
+    /// and writing
+    std::vector<std::string> files;
+    for (int s = 0; s < kShards; ++s) {
+        files.push_back(prefix + std::to_string(s) + ".log");
+        std::ofstream out(files.back());
+        for (int i = 0; i < kRecords; ++i) {
+            const int j = i / 100 % 3 == 1 ? i / 100 * 100 + 99 - i % 100 : i;
+            const int64_t us = int64_t(j) * 300 + s * 100;
+            out << timestamp(us) << " 1234 INFO  shard " << s << " record "
+                << j << " - t.cc:1\n";
+            /// multi-line messages stay with their record
+            if (j % 10 == 0) out << "  detail of " << s << " " << j << "\n";
+        }
+    }
+
+    const std::string merged = std::string(dir) + "/merged.log";
+    std::string command = std::string(LOG_MERGE) + " -o " + merged;
+    for (const std::string& file : files) command += " " + file;
+    assert(::system(command.c_str()) == 0);
+
+    std::ifstream in(merged);
+    std::string line;
+    std::string last;
+    std::string pendingDetail;
+    int records = 0;
+    while (std::getline(in, line)) {
+        if (line[0] == ' ') {
+            assert(line == pendingDetail);
+            pendingDetail.clear();
+            continue;
+        }
+        assert(pendingDetail.empty());
+        /// timestamps sort as text
+        const std::string stamp = line.substr(0, 26);
+        assert(stamp >= last);
+        last = stamp;
+        int s = -1;
+        int j = -1;
+        ::sscanf(line.c_str() + line.find("shard"), "shard %d record %d", &s,
+                 &j);
+        assert(stamp == timestamp(int64_t(j) * 300 + s * 100));
+        if (j % 10 == 0)
+            pendingDetail =
+                "  detail of " + std::to_string(s) + " " + std::to_string(j);
+        ++records;
+    }
+    assert(pendingDetail.empty());
+    assert(records == kShards * kRecords);
+
+    for (const std::string& file : files) ::unlink(file.c_str());
+    ::unlink(merged.c_str());
+    ::rmdir(dir);
+    std::cout << records << " records merged in order" << std::endl;
+    std::cout << "logMerge test passed" << std::endl;
+    return 0;
+}
@@ -23,6 +23,9 @@ int main(int argc, char** argv) {
     // LOG_SYSERR << "This is log SYSERR TEST";
 
     LOG_INFO << "CurrentThread: " << Lute::CurrentThread::tid();
+    const auto lines = static_cast<int64_t>(g_threadNum * g_logNum);
+    LOG_INFO << "Logging " << Lute::FmtSI(lines) << " lines, "
+             << Lute::FmtIEC(lines * 256) << "B";
 
     for (size_t i = 0; i < g_threadNum; ++i) {
         threads.push_back(new Lute::Thread([]() {
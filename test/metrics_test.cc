@@ -0,0 +1,88 @@
+#include <Base/metrics.h>
+#include <Base/thread.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+int main() {
+    Lute::MetricsRegistry registry;
+    auto& requests = registry.counter("test_requests_total", "Requests");
+    auto& inflight = registry.gauge("test_inflight", "In-flight requests");
+    auto& latency = registry.histogram("test_latency_us", "Latency in us");
+
+    const int kThreads = 8;
+    const int kLoops = 100000;
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back(new Lute::Thread([&] {
+            for (int k = 0; k < kLoops; ++k) {
+                requests.inc();
+                latency.record(k % 1000);
+            }
+        }));
+    }
+    for (auto& thread : threads) thread->start();
+    for (auto& thread : threads) thread->join();
+    inflight.set(3);
+
+    assert(requests.value() == kThreads * kLoops);
+    assert(&requests == &registry.counter("test_requests_total"));
+
+    std::unique_ptr<Lute::Histogram::Snapshot> snap(
+        new Lute::Histogram::Snapshot);
+    latency.snapshot(snap.get());
+    assert(snap->count == static_cast<uint64_t>(kThreads * kLoops));
+    /// Within one sub-bucket (6.25%) of the exact value
+    assert(snap->percentile(0.5) >= 499 && snap->percentile(0.5) <= 531);
+    assert(snap->percentile(0.99) >= 989 && snap->percentile(0.99) <= 1023);
+    assert(snap->max() >= 999 && snap->max() <= 1023);
+    std::cout << "p50: " << snap->percentile(0.5)
+              << ", p99: " << snap->percentile(0.99)
+              << ", max: " << snap->max() << ", mean: " << snap->mean()
+              << std::endl;
+
+    for (uint64_t v : {0ULL, 15ULL, 16ULL, 100ULL, 1ULL << 40}) {
+        int index = Lute::Histogram::bucketIndex(v);
+        assert(static_cast<uint64_t>(Lute::Histogram::bucketUpperBound(
+                   index)) >= v);
+        (void)index;
+    }
+
+    Lute::metrics::registerProcessMetrics(registry);
+    assert(registry.gauge("lute_process_resident_memory_bytes").value() > 0);
+
+    std::cout << registry.toPrometheus() << std::endl;
+    std::cout << registry.toJson() << std::endl;
+    char path[] = "/tmp/metrics_test.XXXXXX";
+    const int fd = ::mkstemp(path);
+    assert(fd >= 0);
+    ::close(fd);
+    assert(registry.writeToFile(path));
+    ::unlink(path);
+
+    {
+        /// HELP text escapes only `\` and newline, JSON keys also escape
+        /// quotes and control characters
+        Lute::MetricsRegistry odd;
+        odd.counter("odd\"name\t", "a \"quoted\" C:\\dir\nnext");
+        assert(odd.toPrometheus().find(
+                   "# HELP odd\"name\t a \"quoted\" C:\\\\dir\\nnext\n") !=
+               std::string::npos);
+        assert(odd.toJson().find("{\"odd\\\"name\\t\":") != std::string::npos);
+    }
+
+    int reports = 0;
+    Lute::MetricsReporter reporter(
+        registry, 0.01, [&reports](const std::string&) { ++reports; });
+    reporter.start();
+    Lute::CurrentThread::sleepUsec(50 * 1000);
+    reporter.stop();
+    std::cout << "reports: " << reports << std::endl;
+    assert(reports > 0);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <Base/perCpu.h>
+#include <Base/thread.h>
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using Counter = std::atomic<int64_t>;
+
+int64_t sum(const Lute::PerCpu<Counter>& counters) {
+    return counters.reduce(int64_t(0), [](int64_t s, const Counter& c) {
+        return s + c.load(std::memory_order_relaxed);
+    });
+}
+
+void testTopology() {
+    const auto& topo = Lute::detail::cpuTopology();
+    std::cout << topo.cpus << " cpus, " << topo.nodes << " nodes"
+              << std::endl;
+    assert(topo.cpus >= 1 && topo.nodes >= 1);
+    assert(static_cast<int>(topo.nodeOfCpu.size()) == topo.cpus);
+}
+
+void testPerCpu() {
+    Lute::PerCpu<Counter> counters(10);
+    assert(counters.size() == Lute::detail::cpuTopology().cpus);
+    assert(sum(counters) == 10 * counters.size());
+
+    /// shards don't share cache lines
+    for (int i = 0; i < counters.size(); ++i) {
+        auto addr = reinterpret_cast<uintptr_t>(&counters.shard(i));
+        assert(addr % Lute::detail::kCacheLineSize == 0);
+    }
+    assert(&counters.local() == &counters.shard(Lute::CurrentThread::cpu()));
+
+    counters.forEach([](Counter& c) { c.store(0); });
+    const int kThreads = 4;
+    const int kIncrements = 100000;
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back(new Lute::Thread([&counters] {
+            for (int i = 0; i < kIncrements; ++i)
+                counters.local().fetch_add(1, std::memory_order_relaxed);
+        }));
+        threads.back()->start();
+    }
+    for (auto& thread : threads) thread->join();
+    assert(sum(counters) == kThreads * kIncrements);
+}
+
+struct Stats {
+    int64_t ops = 0;
+    int owner = -1;
+};
+
+void testPerThread() {
+    Lute::PerThread<Stats> stats;
+    const int kThreads = 8;
+    const int kOps = 1000;
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back(new Lute::Thread([&stats] {
+            Stats& local = stats.local();
+            /// a fresh shard, or one left by an exited thread
+            local.owner = Lute::CurrentThread::tid();
+            for (int i = 0; i < kOps; ++i) ++stats.local().ops;
+            assert(&stats.local() == &local);
+        }));
+        threads.back()->start();
+    }
+    for (auto& thread : threads) thread->join();
+
+    int64_t total = stats.reduce(
+        int64_t(0), [](int64_t s, const Stats& st) { return s + st.ops; });
+    assert(total == kThreads * kOps);
+
+    int shards = 0;
+    stats.forEach([&shards](Stats&) { ++shards; });
+    assert(shards == Lute::PerThread<Stats>::kChunkSize);
+
+    Lute::PerThread<Counter> counters(5);
+    assert(counters.local().load() == 5);
+}
+
+int main() {
+    testTopology();
+    testPerCpu();
+    testPerThread();
+    std::cout << "perCpu test passed" << std::endl;
+    return 0;
+}
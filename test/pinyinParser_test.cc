@@ -1,15 +1,39 @@
 #include <Base/pinyinParser.h>
 
+#include <cassert>
+
 using std::cout;
 using std::string;
 using std::endl;
 
 int main() {
+    /// the builtin dictionary is what the build step compiled from the file
+    Lute::PinyinDict loaded;
+    if (loaded.load(PINYIN_FILE) != 0) {
+        cout << "load " << PINYIN_FILE << " error" << endl;
+        return -1;
+    }
+    const Lute::PinyinDict& builtin = Lute::PinyinDict::builtin();
+    assert(!builtin.owned() && builtin.size() == loaded.size());
+    for (uint32_t cp = Lute::PinyinDict::kFirst; cp <= Lute::PinyinDict::kLast;
+         ++cp)
+        assert(builtin.lookup(cp) == loaded.lookup(cp));
+
+    /// copy on write, the builtin tables are read-only
+    Lute::PinyinDict custom = builtin;
+    custom.add(0x4E2D, "zhong4");
+    assert(custom.owned() && custom.lookupTone(0x4E2D) == "zhong4");
+    assert(custom.lookup(0x4E2D) == "zhong");
+    assert(builtin.lookupTone(0x4E2D) == "zhong1");
+    assert(builtin.readings(0x4E2D) == "zhong1,zhong4");
+
     Lute::PinyinParser parser;
     if (parser.InitPinyinMap(PINYIN_FILE) != 0) {
         cout << "GetPinYinMap error, ret:" << endl;
         return -1;
     }
+    assert(parser.InitPinyinMap("/nonexistent") == -1);
+    assert(parser.dict().size() == loaded.size());
 
     string zh = "哈哈";
     string zhpinyin;
@@ -19,5 +43,60 @@ int main() {
     }
 
     cout << "parse succ, zh: " << zh << ", pinyin: " << zhpinyin << endl;
+
+    const Lute::PinyinDict& dict = parser.dict();
+    cout << "dict: " << dict.size() << " characters, " << dict.memoryUsage()
+         << " bytes, 中 = " << dict.lookup(0x4E2D) << endl;
+
+    /// batch conversion, serial and parallel give the same arena
+    std::vector<string> lines;
+    for (int i = 0; i < 2000; ++i)
+        lines.push_back(i % 3 ? "中国 abc 汉字" : "hello, 世界!");
+    lines.push_back("");
+    lines.push_back("\xff 𠀀 é");
+    Lute::PinyinArena serial, parallel;
+    Lute::PinyinStats serialStats, parallelStats;
+    parser.convertBatch(lines, &serial, 1, &serialStats);
+    parser.convertBatch(lines, &parallel, 4, &parallelStats);
+    assert(serial.size() == lines.size());
+    assert(serial.buffer() == parallel.buffer());
+    for (size_t i = 0; i < serial.size(); ++i) assert(serial[i] == parallel[i]);
+    assert(serial[0] == "hello, shijie!");
+    assert(serial[1] == "zhongguo abc hanzi");
+    assert(serial[lines.size() - 2].empty());
+    assert(serial[lines.size() - 1] == "\xff 𠀀 é");
+    assert(serialStats.invalid == 1 && parallelStats.invalid == 1);
+    assert(serialStats.converted == parallelStats.converted);
+    cout << "batch: " << serial.size() << " records, " << serialStats.converted
+         << " converted, " << serialStats.misses << " misses" << endl;
+
+    /// one record per line of a buffer
+    Lute::PinyinArena arena;
+    parser.convertLines("哈哈\nabc\n", &arena);
+    assert(arena.size() == 2);
+    assert(arena[0] == "haha" && arena[1] == "abc");
+
+    /// every mode in one pass
+    Lute::PinyinResult result;
+    parser.convert("中国 ok", Lute::PinyinParser::kPlain |
+                                 Lute::PinyinParser::kTone |
+                                 Lute::PinyinParser::kInitials |
+                                 Lute::PinyinParser::kSegments,
+                   &result);
+    assert(result.plain == "zhongguo ok");
+    assert(result.tone == "zhong1guo2 ok");
+    assert(result.initials == "zg ok");
+    assert(result.segments.size() == 3);
+    const Lute::PinyinSegment& guo = result.segments[1];
+    assert(guo.begin == 3 && guo.end == 6);
+    assert(guo.plain == 5 && guo.tone == 6 && guo.initials == 1);
+    assert(result.segments[0].readings == "zhong1,zhong4");
+    assert(result.segments[2].readings.empty());
+    for (const auto& seg : result.segments)
+        cout << seg.begin << "-" << seg.end << " [" << seg.readings << "] ";
+    cout << endl;
+    result.clear();
+    parser.convert("长", Lute::PinyinParser::kInitials, &result);
+    assert(result.initials == "c" && result.plain.empty());
     return 0;
 }
\ No newline at end of file
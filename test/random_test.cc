@@ -0,0 +1,98 @@
+#include <Base/random.h>
+#include <Base/thread.h>
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main() {
+    {
+        /// reference outputs, seeded through SplitMix64 like Xoshiro256ss
+        Lute::Xoshiro256ss xoshiro(42);
+        assert(xoshiro() == 0x15780b2e0c2ec716ULL);
+        assert(xoshiro() == 0x6104d9866d113a7eULL);
+        assert(xoshiro() == 0xae17533239e499a1ULL);
+
+        Lute::WyRand wyrand(42);
+        assert(wyrand() == 0xae4a7cbfdda9b434ULL);
+        assert(wyrand() == 0xe9cc09d33d38d9d2ULL);
+        assert(wyrand() == 0xcb5756512b93433aULL);
+
+        /// works with <random>
+        std::uniform_int_distribution<int> dist(1, 6);
+        const int dice = dist(xoshiro);
+        assert(dice >= 1 && dice <= 6);
+    }
+
+    {
+        /// bounded values stay in range and hit every bucket evenly
+        Lute::seedThreadRandom(1);
+        int hist[10] = {0};
+        for (int i = 0; i < 100000; ++i) ++hist[Lute::randomBounded(10)];
+        for (int h : hist) assert(h > 9000 && h < 11000);
+
+        for (int i = 0; i < 10000; ++i) {
+            const int64_t v = Lute::randomInt(-3, 3);
+            assert(v >= -3 && v <= 3);
+            const double d = Lute::randomDouble();
+            assert(d >= 0.0 && d < 1.0);
+        }
+        assert(Lute::randomInt(INT64_MIN, INT64_MAX) != 0 ||
+               Lute::randomInt(INT64_MIN, INT64_MAX) != 0);
+        assert(Lute::randomBounded(1) == 0);
+    }
+
+    {
+        /// seeding is reproducible
+        Lute::seedThreadRandom(7);
+        const uint64_t a = Lute::randomU64();
+        Lute::seedThreadRandom(7);
+        assert(Lute::randomU64() == a);
+    }
+
+    {
+        /// fillRandom lane i is the thread generator jumped i + 1 times
+        Lute::seedThreadRandom(9);
+        uint64_t words[8 * 3 + 5];
+        Lute::fillRandom(words, 8 * 3 + 5);
+
+        Lute::Xoshiro256ss lane(9);
+        for (int i = 0; i < 8; ++i) {
+            lane.jump();
+            Lute::Xoshiro256ss rng = lane;
+            for (int b = 0; b < 4; ++b) {
+                const uint64_t expect = rng();
+                if (b * 8 + i < 8 * 3 + 5) assert(words[b * 8 + i] == expect);
+            }
+        }
+
+        unsigned char bytes[1001];
+        ::memset(bytes, 0, sizeof bytes);
+        Lute::fillRandom(bytes + 1, 1000);
+        int zeros = 0;
+        for (int i = 1; i < 1001; ++i) zeros += bytes[i] == 0;
+        assert(bytes[0] == 0);
+        assert(zeros < 20);
+    }
+
+    {
+        /// each thread gets its own stream
+        uint64_t first[4];
+        std::vector<std::unique_ptr<Lute::Thread>> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back(new Lute::Thread(
+                [&first, i] { first[i] = Lute::randomU64(); }));
+            threads.back()->start();
+        }
+        for (auto& thread : threads) thread->join();
+        for (int i = 0; i < 4; ++i)
+            for (int j = i + 1; j < 4; ++j) assert(first[i] != first[j]);
+        std::cout << std::hex << first[0] << " " << first[1] << " " << first[2]
+                  << " " << first[3] << std::endl;
+    }
+
+    std::cout << "random_test passed" << std::endl;
+    return 0;
+}
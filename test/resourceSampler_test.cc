@@ -0,0 +1,48 @@
+#include <Base/resourceSampler.h>
+#include <Base/utils.h>  // ProcessInfo
+
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+void print(const Lute::ResourceSampler::Snapshot& s) {
+    printf("time=%ld rss=%ld vm=%ld utime=%ld stime=%ld minflt=%ld "
+           "majflt=%ld vcsw=%ld ivcsw=%ld threads=%ld files=%ld\n",
+           s.sampleTime, s.rssBytes, s.vmBytes, s.userTicks, s.systemTicks,
+           s.minorFaults, s.majorFaults, s.voluntaryCtxSwitches,
+           s.involuntaryCtxSwitches, s.numThreads, s.openedFiles);
+}
+
+int main() {
+    Lute::ResourceSampler sampler(0.01);
+
+    Lute::ResourceSampler::Snapshot snap{};
+    bool ok = sampler.sample(&snap);
+    assert(ok);
+    (void)ok;
+    print(snap);
+    assert(snap.rssBytes > 0);
+    assert(snap.numThreads == Lute::ProcessInfo::numThreads());
+    assert(snap.openedFiles >= 3);
+
+    sampler.start();
+    /// Touch some memory so that rss / page faults move
+    std::vector<char> mem(16 * 1024 * 1024, 1);
+    Lute::CurrentThread::sleepUsec(50 * 1000);
+
+    Lute::ResourceSampler::Snapshot latest = sampler.snapshot();
+    print(latest);
+    assert(latest.sampleTime > snap.sampleTime);
+    assert(latest.numThreads == snap.numThreads + 1);
+    assert(latest.minorFaults >= snap.minorFaults);
+    sampler.stop();
+
+    int64_t cpu1 = Lute::ResourceSampler::threadCpuTimeNanos();
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 10000000; ++i) sum = sum + static_cast<uint64_t>(i);
+    int64_t cpu2 = Lute::ResourceSampler::threadCpuTimeNanos();
+    printf("thread cpu: %ld ns, sum = %lu\n", cpu2 - cpu1,
+           static_cast<uint64_t>(sum));
+    assert(cpu2 > cpu1);
+    return static_cast<int>(mem[0]) - 1;
+}
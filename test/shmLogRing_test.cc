@@ -0,0 +1,176 @@
+#include <Base/shmLogRing.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+const int kWriters = 3;
+const int kLines = 20000;
+
+/// @brief Child: log `kLines` numbered lines, half through reserve()
+void writer(const std::string& name, int id) {
+    auto ring = Lute::ShmLogRing::open(name);
+    assert(ring);
+    for (int i = 0; i < kLines; ++i) {
+        char line[64];
+        const int len = ::snprintf(line, sizeof line, "%d %d\n", id, i);
+        if (i % 2 == 0) {
+            while (!ring->append(line, len)) ::usleep(100);
+            continue;
+        }
+        Lute::Logger::Reservation reservation;
+        while (!ring->reserve(Lute::detail::kSmallBuffer, &reservation))
+            ::usleep(100);
+        ::memcpy(reservation.data, line, static_cast<size_t>(len));
+        ring->commit(reservation, len);
+    }
+}
+
+/// @brief Child: commit shrunk lines until killed. SIGTERM is held off
+///        across reserve() only, the one window a death still blocks in
+void dyingWriter(const std::string& name) {
+    auto ring = Lute::ShmLogRing::open(name);
+    assert(ring);
+    sigset_t term;
+    ::sigemptyset(&term);
+    ::sigaddset(&term, SIGTERM);
+    for (;;) {
+        Lute::Logger::Reservation reservation;
+        ::sigprocmask(SIG_BLOCK, &term, nullptr);
+        const bool reserved = ring->reserve(Lute::detail::kSmallBuffer,
+                                            &reservation);
+        ::sigprocmask(SIG_UNBLOCK, &term, nullptr);
+        if (!reserved) continue;
+        ::memcpy(reservation.data, "dying\n", 6);
+        ring->commit(reservation, 6);
+    }
+}
+
+/// @brief Drain what a killed writer left, skipping its claim
+void recover(Lute::ShmLogRing* ring) {
+    for (int i = 0; i < 100 && ring->used() > 0; ++i) {
+        if (ring->drain([](const char*, int) {}) == 0) ring->skipDeadWriter();
+    }
+    assert(ring->used() == 0);
+}
+}  // namespace
+
+int main() {
+    const std::string name = "/lute-shmLogRing-test-" +
+                             std::to_string(::getpid());
+    {
+        auto ring = Lute::ShmLogRing::create(name, 100 * 1000);
+        assert(ring);
+        assert(ring->capacity() == 128 * 1024);
+        assert(Lute::ShmLogRing::open("/lute-no-such-ring") == nullptr);
+
+        /// the ring is much smaller than what the writers log: it wraps
+        /// many times and they wait for the reader
+        std::vector<pid_t> children;
+        for (int id = 0; id < kWriters; ++id) {
+            const pid_t pid = ::fork();
+            if (pid == 0) {
+                writer(name, id);
+                ::_exit(0);
+            }
+            children.push_back(pid);
+        }
+
+        std::vector<int> next(kWriters, 0);
+        int lines = 0;
+        const auto check = [&](const char* line, int len) {
+            int id = -1;
+            int seq = -1;
+            assert(line[len - 1] == '\n');
+            ::sscanf(line, "%d %d", &id, &seq);
+            assert(id >= 0 && id < kWriters);
+            /// each writer's lines arrive in its order
+            assert(seq == next[static_cast<size_t>(id)]);
+            ++next[static_cast<size_t>(id)];
+            ++lines;
+        };
+        while (lines < kWriters * kLines) {
+            if (ring->drain(check) == 0) ring->waitForData(100);
+        }
+        for (pid_t pid : children) {
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        assert(ring->used() == 0);
+        std::cout << kWriters << " processes, " << lines << " lines, "
+                  << ring->dropped() << " dropped\n";
+
+        /// a full ring drops and counts
+        const std::string big(1000, 'x');
+        int appended = 0;
+        while (ring->append(big.data(), static_cast<int>(big.size())))
+            ++appended;
+        assert(ring->dropped() == 1);
+        std::cout << appended << " 1000-byte lines fill the ring\n";
+        lines = 0;
+        ring->drain([&lines](const char*, int len) {
+            assert(len == 1000);
+            ++lines;
+        });
+        assert(lines == appended && ring->used() == 0);
+
+        /// a writer that dies holding a claim is skipped
+        const pid_t pid = ::fork();
+        if (pid == 0) {
+            auto child = Lute::ShmLogRing::open(name);
+            Lute::Logger::Reservation reservation;
+            child->reserve(100, &reservation);
+            ::_exit(0);
+        }
+        ::waitpid(pid, nullptr, 0);
+        ring->append("after\n", 6);
+        assert(ring->drain([](const char*, int) {}) == 0);
+        assert(ring->skipDeadWriter());
+        std::string last;
+        ring->drain([&last](const char* line, int len) {
+            last.assign(line, static_cast<size_t>(len));
+        });
+        assert(last == "after\n");
+        assert(ring->dropped() == 2);
+
+        /// writers killed anywhere in commit(), shrinking or not, are
+        /// skipped and the ring keeps working
+        for (int round = 0; round < 200; ++round) {
+            const pid_t dying = ::fork();
+            if (dying == 0) dyingWriter(name);
+            for (int i = 0; i < round % 7; ++i) {
+                ring->drain([](const char*, int) {});
+                ::usleep(100);
+            }
+            ::kill(dying, SIGTERM);
+            ::waitpid(dying, nullptr, 0);
+            recover(ring.get());
+            assert(ring->append("alive\n", 6));
+            last.clear();
+            ring->drain([&last](const char* line, int len) {
+                last.assign(line, static_cast<size_t>(len));
+            });
+            assert(last == "alive\n");
+        }
+
+        /// a restarted consumer keeps the ring and what is in it
+        ring->append("kept\n", 5);
+        auto again = Lute::ShmLogRing::create(name, 128 * 1024);
+        last.clear();
+        again->drain([&last](const char* line, int len) {
+            last.assign(line, static_cast<size_t>(len));
+        });
+        assert(last == "kept\n");
+    }
+    assert(Lute::ShmLogRing::unlink(name));
+    std::cout << "shmLogRing test passed\n";
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <Base/split.h>
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> collect(const Lute::Split& range) {
+    std::vector<std::string> pieces;
+    for (Lute::string_view piece : range)
+        pieces.emplace_back(piece.data(), piece.size());
+    return pieces;
+}
+
+int main() {
+    using V = std::vector<std::string>;
+
+    for (Lute::string_view field : Lute::split("a,b,,c", ','))
+        std::cout << "[" << field << "]" << std::endl;
+
+    assert(collect(Lute::split("a,b,,c", ',')) == (V{"a", "b", "", "c"}));
+    assert(collect(Lute::split(",a,", ',')) == (V{"", "a", ""}));
+    assert(collect(Lute::split("", ',')) == (V{""}));
+    assert(collect(Lute::split("abc", ',')) == (V{"abc"}));
+
+    assert(collect(Lute::split("k1 = v1\r\nk2 = v2\r\n", "\r\n")) ==
+           (V{"k1 = v1", "k2 = v2", ""}));
+    assert(collect(Lute::split("a::b", "::")) == (V{"a", "b"}));
+    assert(collect(Lute::split("abc", "")) == (V{"abc"}));
+
+    assert(collect(Lute::tokenize("  hello \t lute\npolaris  ")) ==
+           (V{"hello", "lute", "polaris"}));
+    assert(collect(Lute::tokenize(" \t\n ")).empty());
+    assert(collect(Lute::tokenize("a;b,,c", ",;")) == (V{"a", "b", "c"}));
+
+    /// tokens point into the input, nothing is copied
+    const std::string line = "GET /index.html HTTP/1.1";
+    auto range = Lute::tokenize(line);
+    auto it = range.begin();
+    assert(it->data() == line.data());
+    ++it;
+    assert(*it == "/index.html");
+    assert(it->data() == line.data() + 4);
+    assert(std::distance(range.begin(), range.end()) == 3);
+
+    std::cout << "split_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <Base/exception.h>
+#include <Base/stackTrace.h>
+#include <signal.h>  // signal raise
+#include <unistd.h>  // pipe read
+
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+int g_pipe[2];
+
+/// exported with ENABLE_EXPORTS so dladdr can name them
+__attribute__((noinline)) Lute::StackTrace captureHere() {
+    return Lute::StackTrace::capture();
+}
+
+__attribute__((noinline)) void throwHere() {
+    throw Lute::Exception("oops");
+}
+
+void onSignal(int) { Lute::StackTrace::writeSignalSafe(g_pipe[1]); }
+
+void testCapture() {
+    Lute::StackTrace trace = captureHere();
+    assert(!trace.empty());
+
+    std::string stack = trace.toString();
+    printf("%s\n", stack.c_str());
+    assert(stack.find("captureHere()") != std::string::npos);
+    assert(stack.find("testCapture()") != std::string::npos);
+    assert(trace.toString(false).find("_Z11captureHerev") !=
+           std::string::npos);
+    /// every frame of the trace is cached now
+    const size_t cached = Lute::StackTrace::symbolCacheSize();
+    assert(cached > 0);
+    assert(trace.toString() == stack);
+    assert(Lute::StackTrace::symbolCacheSize() == cached);
+
+    Lute::StackTrace::setSymbolCacheCapacity(1);
+    assert(Lute::StackTrace::symbolCacheSize() == 1);
+    assert(trace.toString() == stack);
+    Lute::StackTrace::setSymbolCacheCapacity(1024);
+}
+
+void testException() {
+    try {
+        throwHere();
+        assert(false);
+    } catch (const Lute::Exception& ex) {
+        assert(!ex.trace().empty());
+        std::string stack = ex.stackTrace();
+        printf("reason: %s\nstack trace:\n%s\n", ex.what(), stack.c_str());
+        assert(stack.find("throwHere()") != std::string::npos);
+        /// formatted once
+        assert(ex.stackTrace() == ex.stackTrace());
+    }
+}
+
+void testSignalSafe() {
+    Lute::StackTrace::prepareSignalSafe();
+    assert(::pipe(g_pipe) == 0);
+    ::signal(SIGUSR1, onSignal);
+    ::raise(SIGUSR1);
+    ::close(g_pipe[1]);
+
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(g_pipe[0], buf, sizeof buf)) > 0)
+        out.append(buf, static_cast<size_t>(n));
+    ::close(g_pipe[0]);
+    printf("signal-safe trace:\n%s\n", out.c_str());
+    assert(out.find("#0 0x") == 0);
+    assert(out.find("stackTrace+0x") != std::string::npos);
+}
+
+int main() {
+    testCapture();
+    testException();
+    testSignalSafe();
+    printf("stackTrace test passed\n");
+    return 0;
+}
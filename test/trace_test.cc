@@ -0,0 +1,95 @@
+#include <Base/mutex.h>
+#include <Base/thread.h>
+#include <Base/trace.h>
+#include <time.h>
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+Lute::MutexLock g_mutex;
+int g_counter = 0;
+
+void worker() {
+    for (int i = 0; i < 1000; ++i) {
+        LUTE_TRACE_SCOPE("worker.loop");
+        {
+            LUTE_TRACE_SCOPE("worker.lock");
+            Lute::MutexLockGuard lock(g_mutex);
+            ++g_counter;
+        }
+    }
+}
+
+int main() {
+    /// Disabled at run time: nothing is recorded
+    worker();
+
+    const char* kFile = "trace_test.json";
+    bool ok = Lute::trace::start(kFile, 0.01);
+    assert(ok);
+    assert(!Lute::trace::start(kFile));
+
+    std::vector<std::unique_ptr<Lute::Thread>> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back(new Lute::Thread(worker, "worker"));
+    for (auto& thread : threads) thread->start();
+    for (auto& thread : threads) thread->join();
+    {
+        LUTE_TRACE_SCOPE("main");
+        Lute::CurrentThread::sleepUsec(1000);
+    }
+    Lute::trace::stop();
+
+    std::ifstream ifs(kFile);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    const std::string json = ss.str();
+
+    size_t events = 0;
+    for (size_t pos = 0;
+         (pos = json.find("\"ph\":\"X\"", pos)) != std::string::npos; ++pos)
+        ++events;
+    printf("events: %zu, dropped: %lu, bytes: %zu\n", events,
+           Lute::trace::droppedEvents(), json.size());
+    assert(events + Lute::trace::droppedEvents() == 4 * 2000 + 1);
+    assert(json.find("\"thread_name\"") != std::string::npos);
+    assert(json.find("\"worker\"") != std::string::npos);
+    assert(json.compare(json.size() - 2, 2, "}\n") == 0);
+    ::remove(kFile);
+
+    /// stop() right after start() doesn't wait out the flush interval
+    struct timespec t0, t1;
+    ::clock_gettime(CLOCK_MONOTONIC, &t0);
+    ok = Lute::trace::start(kFile, 5);
+    assert(ok);
+    Lute::trace::stop();
+    ::clock_gettime(CLOCK_MONOTONIC, &t1);
+    const double stopSeconds = double(t1.tv_sec - t0.tv_sec) +
+                               double(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("start + stop took %.3fs\n", stopSeconds);
+    assert(stopSeconds < 1);
+
+    /// names are escaped
+    ok = Lute::trace::start(kFile, 5);
+    assert(ok);
+    Lute::Thread quoted([] { LUTE_TRACE_SCOPE("say \"hi\" \\ bye"); },
+                        "quo\"te\n");
+    quoted.start();
+    quoted.join();
+    Lute::trace::stop();
+
+    std::ifstream quotedFile(kFile);
+    std::stringstream quotedJson;
+    quotedJson << quotedFile.rdbuf();
+    assert(quotedJson.str().find("\"say \\\"hi\\\" \\\\ bye\"") !=
+           std::string::npos);
+    assert(quotedJson.str().find("\"quo\\\"te\\n\"") != std::string::npos);
+    (void)ok;
+    ::remove(kFile);
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <Base/utils.h>  // toLower, toUpper PING PONG
 #include <unistd.h>      // sleep
 
+#include <cassert>   // assert
+#include <cctype>    // toupper tolower
+#include <cstring>   // strcmp
 #include <iostream>
 
 void toTest() {
@@ -94,6 +97,64 @@ int main() {
         std::cout << "SI: " << Lute::formatSI(i) << std::endl;
         std::cout << "IEC: " << Lute::formatIEC(i) << std::endl;
     }
+    {
+        char buf[Lute::kFormatUnitsSize];
+        assert(Lute::formatSI(buf, 999) == 3 && ::strcmp(buf, "999") == 0);
+        Lute::formatSI(buf, 9994);
+        assert(::strcmp(buf, "9.99k") == 0);
+        Lute::formatSI(buf, 9995);
+        assert(::strcmp(buf, "10.0k") == 0);
+        Lute::formatSI(buf, 1500000000);
+        assert(::strcmp(buf, "1.50G") == 0);
+        Lute::formatSI(buf, INT64_MAX);
+        assert(::strcmp(buf, "9.22E") == 0);
+        Lute::formatSI(buf, INT64_MIN);
+        assert(::strcmp(buf, "-9223372036854775808") == 0);
+        Lute::formatIEC(buf, 1023);
+        assert(::strcmp(buf, "1023") == 0);
+        Lute::formatIEC(buf, 1023 * 1024 + 511);
+        assert(::strcmp(buf, "1023Ki") == 0);
+        Lute::formatIEC(buf, 1023 * 1024 + 512);
+        assert(::strcmp(buf, "1.00Mi") == 0);
+        Lute::formatIEC(buf, INT64_MAX);
+        assert(::strcmp(buf, "8.00Ei") == 0);
+        assert(Lute::formatIEC(1536) == "1.50Ki");
+
+        int64_t v = 0;
+        assert(Lute::parseSI("1500", &v) && v == 1500);
+        assert(Lute::parseSI("1.5k", &v) && v == 1500);
+        assert(Lute::parseSI("1.5Gi", &v) && v == 1610612736);
+        assert(Lute::parseSI(" 64 MiB ", &v) && v == 64 << 20);
+        assert(Lute::parseSI("2M", &v) && v == 2000000);
+        assert(Lute::parseIEC("2M", &v) && v == 2 << 20);
+        assert(Lute::parseIEC("1Gi", &v) && v == 1 << 30);
+        assert(Lute::parseIEC("-1.5K", &v) && v == -1536);
+        assert(Lute::parseSI("0.0005k", &v) && v == 1);
+        assert(Lute::parseSI("9223372036854775807", &v) && v == INT64_MAX);
+        assert(Lute::parseSI("-9223372036854775808", &v) && v == INT64_MIN);
+        v = 42;
+        assert(!Lute::parseSI("", &v) && v == 42);
+        assert(!Lute::parseSI("k", &v));
+        assert(!Lute::parseSI("1.5x", &v));
+        assert(!Lute::parseSI("1..5", &v));
+        assert(!Lute::parseSI("9223372036854775808", &v));
+        assert(!Lute::parseIEC("8Ei", &v));
+        assert(v == 42);
+
+        /// round trip
+        for (int64_t x = 1; x < INT64_MAX / 3; x = x * 3 + 1) {
+            Lute::formatSI(buf, x);
+            assert(Lute::parseSI(buf, &v));
+            assert(v <= x + x / 200 && v >= x - x / 200);
+        }
+    }
+
+    {
+        std::string json;
+        Lute::appendJsonEscaped(&json, "say \"hi\"\\\n\t\x01 ok");
+        assert(json == "say \\\"hi\\\"\\\\\\n\\t\\u0001 ok");
+    }
+
     {
         auto buf = new char[20];
         int v = 9527;
@@ -120,10 +181,71 @@ int main() {
         std::cout << "after trim: " << str << std::endl;
     }
 
+    {
+        /// every byte, every length / alignment against <cctype>
+        char src[80];
+        char dst[80];
+        for (int c = 0; c < 256; ++c) {
+            for (size_t len = 0; len < 70; ++len) {
+                for (size_t i = 0; i < len; ++i)
+                    src[i] = static_cast<char>(i % 3 == 0 ? c : 'a' + i % 26);
+                Lute::toUpper(dst, src, len);
+                for (size_t i = 0; i < len; ++i)
+                    assert(dst[i] == static_cast<char>(::toupper(
+                                         static_cast<unsigned char>(src[i]))));
+                Lute::toLower(dst + 1, src, len);
+                for (size_t i = 0; i < len; ++i)
+                    assert(dst[i + 1] == static_cast<char>(::tolower(
+                                             static_cast<unsigned char>(src[i]))));
+            }
+        }
+
+        char buf[64];
+        Lute::string_view upper = Lute::toUpper("Hello, Lute Polaris!", buf);
+        std::cout << "toUpper view: " << upper << std::endl;
+        assert(upper == "HELLO, LUTE POLARIS!");
+
+        const std::string padded =
+            std::string(20, ' ') + "\t key = value \n" + std::string(17, '\n');
+        Lute::string_view trimmed = Lute::trimView(padded);
+        std::cout << "trimView: [" << trimmed << "]" << std::endl;
+        assert(trimmed == "key = value");
+        assert(Lute::trimView("  \t\n ").empty());
+        assert(Lute::trimView("--a-b--", "-") == "a-b");
+        std::string str = "xx value xx";
+        Lute::trim(str, "x ");
+        assert(str == "value");
+    }
+
     {
         std::string str = "LutePolaris";
         Lute::replace(str, "is", "RIS");
         std::cout << str << std::endl;
+        assert(str == "LutePolarRIS");
+
+        str = "a.b.c..";
+        Lute::replace(str, ".", "");
+        assert(str == "abc");
+        str = "aaaa";
+        Lute::replace(str, "aa", "a");
+        assert(str == "aa");
+        str = "aaa";
+        Lute::replace(str, "a", "aa");
+        assert(str == "aaaaaa");
+        str = "<" + std::string(100, 'a') + ">";
+        Lute::replace(str, "a", "bb");
+        assert(str == "<" + std::string(200, 'b') + ">");
+        str = "x";
+        Lute::replace(str, "xx", "y");
+        assert(str == "x");
+
+        /// embedded NULs, views into src itself
+        str = std::string("a\0b\0c", 5);
+        Lute::replace(str, Lute::string_view("\0", 1), "--");
+        assert(str == "a--b--c");
+        str = "abcabc";
+        Lute::replace(str, Lute::string_view(str.data(), 3), "x");
+        assert(str == "xx");
     }
     return 0;
 }
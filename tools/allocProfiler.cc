@@ -0,0 +1,718 @@
+///
+/// @brief Sampling allocation profiler, loaded with LD_PRELOAD
+/// @usage
+///     LD_PRELOAD=build/lib/libLute_AllocProfiler.so ./program
+///     kill -USR2 <pid>      # dump now, a last dump is written at exit
+///     flamegraph.pl allocprof.<pid>.1.folded > alloc.svg
+///     pprof -sample_index=alloc_space ./program allocprof.<pid>.1.heap
+/// @note Environment:
+///   LUTE_ALLOCPROF_RATE    mean bytes between samples (default 524288,
+///                          1 samples every allocation)
+///   LUTE_ALLOCPROF_OUT     output prefix (default "allocprof")
+///   LUTE_ALLOCPROF_SIGNAL  signal that dumps (default SIGUSR2, 0 for none)
+///   LUTE_ALLOCPROF_UNWIND  "fp" walks frame pointers instead of the libgcc
+///                          unwinder; only for -fno-omit-frame-pointer builds
+///
+///   An allocation of n bytes is sampled with probability 1 - e^(-n/rate):
+///   each thread counts down an exponentially distributed number of bytes,
+///   so an allocation that isn't sampled costs a thread-local subtraction.
+///   A sample captures the stack and is aggregated by call site; frees of
+///   sampled blocks are found through a counting filter, so other frees
+///   cost one relaxed load.
+///
+///   Two files per dump: <prefix>.<pid>.<seq>.heap in the gperftools
+///   heap_v2 format for pprof (in-use and allocated), and .folded with the
+///   estimated allocated bytes per stack for flamegraph.pl.
+///   malloc, calloc, realloc, free, posix_memalign, aligned_alloc,
+///   memalign, valloc and every operator new / delete are covered.
+///
+
+#include <cxxabi.h>   // __cxa_demangle
+#include <dlfcn.h>    // dladdr
+#include <execinfo.h> // backtrace
+#include <fcntl.h>    // open
+#include <pthread.h>  // pthread_mutex_t pthread_create
+#include <signal.h>   // sigaction
+#include <unistd.h>   // write read pipe getpid
+
+#include <atomic>   // atomic
+#include <cerrno>   // errno ENOMEM EINVAL
+#include <cmath>    // exp log
+#include <cstdint>  // uint64_t uintptr_t
+#include <cstdio>   // snprintf
+#include <cstdlib>  // getenv strtoll
+#include <cstring>  // strcmp memcpy
+#include <new>      // bad_alloc nothrow_t align_val_t
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+const int kMaxDepth = 48;
+const size_t kMaxSites = 1 << 14;
+const size_t kMaxLive = 1 << 17;
+const size_t kFilterSize = 1 << 16;
+
+/// Samples aggregated by stack
+struct Site {
+    uint64_t hash;
+    int depth;
+    void* pcs[kMaxDepth];
+    uint64_t allocs;
+    uint64_t allocBytes;
+    uint64_t inuseObjs;
+    uint64_t inuseBytes;
+    double estAllocBytes;
+};
+
+/// A sampled block not freed yet
+struct Live {
+    uintptr_t addr;
+    uint32_t site;
+    uint64_t size;
+};
+
+std::atomic<bool> g_enabled(false);
+int64_t g_rate = 512 * 1024;
+bool g_framePointers = false;
+char g_prefix[256] = "allocprof";
+
+pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+Site g_sites[kMaxSites];
+size_t g_numSites = 0;
+uint64_t g_droppedSamples = 0;
+Live g_live[kMaxLive];
+size_t g_numLive = 0;
+/// How many live samples hash to each slot; zero means "not sampled"
+std::atomic<uint16_t> g_filter[kFilterSize];
+
+pthread_mutex_t g_dumpMutex = PTHREAD_MUTEX_INITIALIZER;
+Site g_snapshot[kMaxSites];
+int g_dumpSeq = 0;
+int g_pipe[2] = {-1, -1};
+
+#define LUTE_TLS __thread __attribute__((tls_model("initial-exec")))
+/// Bytes left before the next sample
+LUTE_TLS int64_t t_countdown = 0;
+LUTE_TLS uint64_t t_rng = 0;
+/// Set while the profiler itself runs: nested allocations pass through
+LUTE_TLS bool t_busy = false;
+
+inline uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+inline size_t filterSlot(uintptr_t addr) {
+    return mix(addr) & (kFilterSize - 1);
+}
+
+/// Exponentially distributed with mean g_rate
+int64_t nextInterval() {
+    if (t_rng == 0) {
+        t_rng = mix(reinterpret_cast<uintptr_t>(&t_rng) ^
+                    static_cast<uint64_t>(::getpid()) << 32) |
+                1;
+    }
+    t_rng ^= t_rng << 13;
+    t_rng ^= t_rng >> 7;
+    t_rng ^= t_rng << 17;
+    /// uniform in (0, 1]
+    const double u = static_cast<double>((t_rng >> 11) + 1) * 0x1p-53;
+    return static_cast<int64_t>(-std::log(u) * static_cast<double>(g_rate)) +
+           1;
+}
+
+/// Expected bytes an allocation of `size` sampled bytes stands for
+double weight(uint64_t size) {
+    if (g_rate <= 1 || size == 0) return static_cast<double>(size);
+    const double s = static_cast<double>(size);
+    return s / (1.0 - std::exp(-s / static_cast<double>(g_rate)));
+}
+
+int walkFramePointers(void** pcs, int max) {
+#if defined(__x86_64__) || defined(__aarch64__)
+    auto** fp = static_cast<void**>(__builtin_frame_address(0));
+    int n = 0;
+    while (n < max && fp != nullptr) {
+        void* ret = fp[1];
+        if (ret == nullptr) break;
+        pcs[n++] = ret;
+        auto** next = static_cast<void**>(fp[0]);
+        /// frames grow upwards, stay on the same stack
+        if (next <= fp || next - fp > (1 << 20) ||
+            (reinterpret_cast<uintptr_t>(next) & (sizeof(void*) - 1)) != 0)
+            break;
+        fp = next;
+    }
+    return n;
+#else
+    return ::backtrace(pcs, max);
+#endif
+}
+
+uint32_t findSite(void** pcs, int depth) {
+    uint64_t hash = static_cast<uint64_t>(depth);
+    for (int i = 0; i < depth; ++i)
+        hash = mix(hash ^ reinterpret_cast<uintptr_t>(pcs[i]));
+
+    size_t i = hash & (kMaxSites - 1);
+    for (size_t probes = 0; probes < kMaxSites; ++probes) {
+        Site& site = g_sites[i];
+        if (site.depth == 0) {
+            if (g_numSites * 4 >= kMaxSites * 3) break;
+            ++g_numSites;
+            site.hash = hash;
+            site.depth = depth;
+            ::memcpy(site.pcs, pcs, sizeof(void*) * static_cast<size_t>(depth));
+            return static_cast<uint32_t>(i);
+        }
+        if (site.hash == hash && site.depth == depth &&
+            ::memcmp(site.pcs, pcs, sizeof(void*) * static_cast<size_t>(depth)) ==
+                0)
+            return static_cast<uint32_t>(i);
+        i = (i + 1) & (kMaxSites - 1);
+    }
+    return UINT32_MAX;
+}
+
+/// @return false if the live table is too full, the block isn't tracked
+bool track(uintptr_t addr, uint32_t site, uint64_t size) {
+    if (g_numLive * 4 >= kMaxLive * 3) return false;
+    size_t i = mix(addr ^ 0x9e3779b97f4a7c15ULL) & (kMaxLive - 1);
+    while (g_live[i].addr != 0) i = (i + 1) & (kMaxLive - 1);
+    g_live[i].addr = addr;
+    g_live[i].site = site;
+    g_live[i].size = size;
+    ++g_numLive;
+    g_filter[filterSlot(addr)].fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/// Forget a freed block and its in-use bytes. Linear probing removal with
+/// backward shift; under g_mutex
+void untrack(uintptr_t addr) {
+    size_t i = mix(addr ^ 0x9e3779b97f4a7c15ULL) & (kMaxLive - 1);
+    while (g_live[i].addr != addr) {
+        if (g_live[i].addr == 0) return;
+        i = (i + 1) & (kMaxLive - 1);
+    }
+    Site& site = g_sites[g_live[i].site];
+    --site.inuseObjs;
+    site.inuseBytes -= g_live[i].size;
+    size_t hole = i;
+    for (size_t j = (i + 1) & (kMaxLive - 1); g_live[j].addr != 0;
+         j = (j + 1) & (kMaxLive - 1)) {
+        const size_t home =
+            mix(g_live[j].addr ^ 0x9e3779b97f4a7c15ULL) & (kMaxLive - 1);
+        /// move j into the hole unless its home lies in (hole, j]
+        if (((j - home) & (kMaxLive - 1)) >= ((j - hole) & (kMaxLive - 1))) {
+            g_live[hole] = g_live[j];
+            hole = j;
+        }
+    }
+    g_live[hole].addr = 0;
+    --g_numLive;
+    g_filter[filterSlot(addr)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+__attribute__((noinline)) void recordSample(void* ptr, size_t size) {
+    t_busy = true;
+    void* pcs[kMaxDepth];
+    const int depth = g_framePointers ? walkFramePointers(pcs, kMaxDepth)
+                                      : ::backtrace(pcs, kMaxDepth);
+    const double est = weight(size);
+
+    ::pthread_mutex_lock(&g_mutex);
+    const uint32_t index = depth > 0 ? findSite(pcs, depth) : UINT32_MAX;
+    if (index == UINT32_MAX) {
+        ++g_droppedSamples;
+    } else {
+        Site& site = g_sites[index];
+        ++site.allocs;
+        site.allocBytes += size;
+        site.estAllocBytes += est;
+        /// an untracked block would never leave the in-use counts
+        if (track(reinterpret_cast<uintptr_t>(ptr), index, size)) {
+            ++site.inuseObjs;
+            site.inuseBytes += size;
+        }
+    }
+    ::pthread_mutex_unlock(&g_mutex);
+    t_busy = false;
+}
+
+inline void onAlloc(void* ptr, size_t size) {
+    if (__builtin_expect(ptr == nullptr, 0)) return;
+    t_countdown -= static_cast<int64_t>(size);
+    if (__builtin_expect(t_countdown >= 0, 1)) return;
+    if (t_busy || !g_enabled.load(std::memory_order_relaxed)) return;
+
+    /// memoryless: a fresh interval after each sample
+    const bool first = t_rng == 0;
+    t_countdown = g_rate <= 1 ? 0 : nextInterval();
+    /// the first crossing only seeds the countdown
+    if (!first || g_rate <= 1) recordSample(ptr, size);
+}
+
+inline void onFree(void* ptr) {
+    if (ptr == nullptr) return;
+    const auto addr = reinterpret_cast<uintptr_t>(ptr);
+    if (__builtin_expect(
+            g_filter[filterSlot(addr)].load(std::memory_order_relaxed) == 0,
+            1))
+        return;
+
+    ::pthread_mutex_lock(&g_mutex);
+    untrack(addr);
+    ::pthread_mutex_unlock(&g_mutex);
+}
+
+void* allocate(size_t size) {
+    void* p = __libc_malloc(size);
+    onAlloc(p, size);
+    return p;
+}
+
+void* allocateAligned(size_t alignment, size_t size) {
+    void* p = __libc_memalign(alignment, size);
+    onAlloc(p, size);
+    return p;
+}
+
+void* newOrThrow(size_t size, size_t alignment) {
+    for (;;) {
+        void* p = alignment != 0 ? allocateAligned(alignment, size)
+                                 : allocate(size);
+        if (p != nullptr) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* newNothrow(size_t size, size_t alignment) noexcept {
+    try {
+        return newOrThrow(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocate(void* ptr) noexcept {
+    onFree(ptr);
+    __libc_free(ptr);
+}
+
+// ---------------------------------------------------------------------------
+// dumps
+
+/// Buffered writes to a file descriptor, no allocation
+class Writer {
+public:
+    explicit Writer(int fd) : fd_(fd), len_(0) {}
+    ~Writer() { flush(); }
+
+    void append(const char* s, size_t n) {
+        while (n > 0) {
+            if (len_ == sizeof buf_) flush();
+            const size_t m = n < sizeof buf_ - len_ ? n : sizeof buf_ - len_;
+            ::memcpy(buf_ + len_, s, m);
+            len_ += m;
+            s += m;
+            n -= m;
+        }
+    }
+
+    void append(const char* s) { append(s, ::strlen(s)); }
+
+    template <typename... Args>
+    void format(const char* fmt, Args... args) {
+        char line[512];
+        const int n = ::snprintf(line, sizeof line, fmt, args...);
+        if (n > 0)
+            append(line, static_cast<size_t>(n) < sizeof line
+                             ? static_cast<size_t>(n)
+                             : sizeof line - 1);
+    }
+
+    void flush() {
+        size_t off = 0;
+        while (off < len_) {
+            const ssize_t n = ::write(fd_, buf_ + off, len_ - off);
+            if (n <= 0 && errno != EINTR) break;
+            if (n > 0) off += static_cast<size_t>(n);
+        }
+        len_ = 0;
+    }
+
+private:
+    int fd_;
+    size_t len_;
+    char buf_[65536];
+};
+
+/// Leading frames inside the profiler itself
+int ownFrames(const Site& site) {
+    static Dl_info self;
+    static bool resolved = ::dladdr(reinterpret_cast<void*>(&recordSample),
+                                    &self) != 0;
+    int skip = 0;
+    for (; skip < site.depth - 1 && resolved; ++skip) {
+        Dl_info info;
+        if (::dladdr(site.pcs[skip], &info) == 0 ||
+            info.dli_fbase != self.dli_fbase)
+            break;
+    }
+    return skip;
+}
+
+/// "function", or "module+0xoffset" without symbols
+void appendFrame(Writer& out, void* pc) {
+    /// a return address, look up the call instruction
+    void* call = static_cast<char*>(pc) - 1;
+    Dl_info info;
+    if (::dladdr(call, &info) != 0 && info.dli_sname != nullptr) {
+        int status = 0;
+        char* demangled =
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        const char* name = status == 0 ? demangled : info.dli_sname;
+        /// ';' separates frames in the folded format
+        for (const char* c = name; *c; ++c) out.append(*c == ';' ? ":" : c, 1);
+        ::free(demangled);
+    } else if (info.dli_fname != nullptr) {
+        const char* base = ::strrchr(info.dli_fname, '/');
+        out.format("%s+0x%zx", base ? base + 1 : info.dli_fname,
+                   static_cast<size_t>(static_cast<char*>(call) -
+                                       static_cast<char*>(info.dli_fbase)));
+    } else {
+        out.format("%p", pc);
+    }
+}
+
+int openOutput(int seq, const char* suffix) {
+    char path[512];
+    ::snprintf(path, sizeof path, "%s.%d.%d.%s", g_prefix, ::getpid(), seq,
+               suffix);
+    return ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+void writeHeap(int fd, size_t numSites) {
+    Writer out(fd);
+    uint64_t inuseObjs = 0, inuseBytes = 0, allocs = 0, allocBytes = 0;
+    for (size_t i = 0; i < numSites; ++i) {
+        inuseObjs += g_snapshot[i].inuseObjs;
+        inuseBytes += g_snapshot[i].inuseBytes;
+        allocs += g_snapshot[i].allocs;
+        allocBytes += g_snapshot[i].allocBytes;
+    }
+    out.format("heap profile: %lu: %lu [%lu: %lu] @ heap_v2/%ld\n", inuseObjs,
+               inuseBytes, allocs, allocBytes, g_rate > 1 ? g_rate : 1L);
+    for (size_t i = 0; i < numSites; ++i) {
+        const Site& site = g_snapshot[i];
+        out.format("%lu: %lu [%lu: %lu] @", site.inuseObjs, site.inuseBytes,
+                   site.allocs, site.allocBytes);
+        for (int f = ownFrames(site); f < site.depth; ++f)
+            out.format(" %p", site.pcs[f]);
+        out.append("\n");
+    }
+
+    out.append("\nMAPPED_LIBRARIES:\n");
+    const int maps = ::open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (maps >= 0) {
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(maps, buf, sizeof buf)) > 0)
+            out.append(buf, static_cast<size_t>(n));
+        ::close(maps);
+    }
+}
+
+void writeFolded(int fd, size_t numSites) {
+    Writer out(fd);
+    for (size_t i = 0; i < numSites; ++i) {
+        const Site& site = g_snapshot[i];
+        /// outermost frame first
+        const int skip = ownFrames(site);
+        for (int f = site.depth - 1; f >= skip; --f) {
+            appendFrame(out, site.pcs[f]);
+            if (f > skip) out.append(";");
+        }
+        out.format(" %.0f\n", site.estAllocBytes);
+    }
+}
+
+void dump() {
+    const bool busy = t_busy;
+    t_busy = true;
+    ::pthread_mutex_lock(&g_dumpMutex);
+
+    size_t numSites = 0;
+    uint64_t dropped;
+    ::pthread_mutex_lock(&g_mutex);
+    for (size_t i = 0; i < kMaxSites; ++i) {
+        if (g_sites[i].depth != 0) g_snapshot[numSites++] = g_sites[i];
+    }
+    dropped = g_droppedSamples;
+    ::pthread_mutex_unlock(&g_mutex);
+
+    const int seq = ++g_dumpSeq;
+    const int heap = openOutput(seq, "heap");
+    if (heap >= 0) {
+        writeHeap(heap, numSites);
+        ::close(heap);
+    }
+    const int folded = openOutput(seq, "folded");
+    if (folded >= 0) {
+        writeFolded(folded, numSites);
+        ::close(folded);
+    }
+    if (dropped != 0) {
+        char line[128];
+        const int n = ::snprintf(line, sizeof line,
+                                 "allocprof: %lu samples dropped, site table "
+                                 "full\n",
+                                 dropped);
+        if (n > 0 && ::write(STDERR_FILENO, line, static_cast<size_t>(n)) < 0) {
+        }
+    }
+
+    ::pthread_mutex_unlock(&g_dumpMutex);
+    t_busy = busy;
+}
+
+void onSignal(int) {
+    const int saved = errno;
+    const char c = 'd';
+    if (::write(g_pipe[1], &c, 1) < 0) {
+    }
+    errno = saved;
+}
+
+/// Dumps on request of the signal handler, outside of signal context
+void* dumperThread(void*) {
+    t_busy = true;
+    char c;
+    for (;;) {
+        const ssize_t n = ::read(g_pipe[0], &c, 1);
+        if (n == 1) {
+            dump();
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+/// @brief The pipe the signal handler writes to and the thread reading it
+bool startDumper() {
+    if (::pipe2(g_pipe, O_CLOEXEC) != 0) return false;
+    /// a full pipe drops the request instead of blocking in the handler
+    ::fcntl(g_pipe[1], F_SETFL, O_NONBLOCK);
+    pthread_t tid;
+    if (::pthread_create(&tid, nullptr, &dumperThread, nullptr) != 0) {
+        ::close(g_pipe[0]);
+        ::close(g_pipe[1]);
+        g_pipe[0] = g_pipe[1] = -1;
+        return false;
+    }
+    ::pthread_detach(tid);
+    return true;
+}
+
+/// fork(): no other thread may hold the locks across it, and the child
+/// gets its own pipe and dumper thread, the parent's are not its own
+void beforeFork() {
+    ::pthread_mutex_lock(&g_dumpMutex);
+    ::pthread_mutex_lock(&g_mutex);
+}
+
+void afterForkParent() {
+    ::pthread_mutex_unlock(&g_mutex);
+    ::pthread_mutex_unlock(&g_dumpMutex);
+}
+
+void afterForkChild() {
+    ::pthread_mutex_unlock(&g_mutex);
+    ::pthread_mutex_unlock(&g_dumpMutex);
+    if (g_pipe[0] < 0) return;
+    const bool busy = t_busy;
+    t_busy = true;
+    ::close(g_pipe[0]);
+    ::close(g_pipe[1]);
+    g_pipe[0] = g_pipe[1] = -1;
+    startDumper();
+    t_busy = busy;
+}
+
+__attribute__((constructor)) void initProfiler() {
+    t_busy = true;
+    if (const char* rate = ::getenv("LUTE_ALLOCPROF_RATE")) {
+        const long long v = ::strtoll(rate, nullptr, 10);
+        if (v > 0) g_rate = v;
+    }
+    if (const char* out = ::getenv("LUTE_ALLOCPROF_OUT")) {
+        ::snprintf(g_prefix, sizeof g_prefix, "%s", out);
+    }
+    if (const char* unwind = ::getenv("LUTE_ALLOCPROF_UNWIND")) {
+        g_framePointers = ::strcmp(unwind, "fp") == 0;
+    }
+    int signo = SIGUSR2;
+    if (const char* sig = ::getenv("LUTE_ALLOCPROF_SIGNAL")) {
+        signo = static_cast<int>(::strtol(sig, nullptr, 10));
+    }
+
+    /// load the unwinder now rather than inside a sampled malloc
+    void* pcs[4];
+    ::backtrace(pcs, 4);
+
+    if (signo > 0 && startDumper()) {
+        struct sigaction sa;
+        ::memset(&sa, 0, sizeof sa);
+        sa.sa_handler = &onSignal;
+        sa.sa_flags = SA_RESTART;
+        ::sigemptyset(&sa.sa_mask);
+        ::sigaction(signo, &sa, nullptr);
+    }
+    ::pthread_atfork(&beforeFork, &afterForkParent, &afterForkChild);
+
+    g_enabled.store(true, std::memory_order_release);
+    t_busy = false;
+}
+
+__attribute__((destructor)) void finishProfiler() {
+    if (!g_enabled.exchange(false)) return;
+    dump();
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// interposed entry points
+
+extern "C" {
+
+void* malloc(size_t size) { return allocate(size); }
+
+void free(void* ptr) { deallocate(ptr); }
+
+void* calloc(size_t n, size_t size) {
+    void* p = __libc_calloc(n, size);
+    if (p != nullptr) onAlloc(p, n * size);
+    return p;
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (ptr == nullptr) return allocate(size);
+    if (size == 0) {
+        deallocate(ptr);
+        return nullptr;
+    }
+    const auto addr = reinterpret_cast<uintptr_t>(ptr);
+    void* p;
+    if (__builtin_expect(
+            g_filter[filterSlot(addr)].load(std::memory_order_relaxed) == 0,
+            1)) {
+        p = __libc_realloc(ptr, size);
+    } else {
+        /// a failed realloc leaves the block live; untrack under the lock
+        /// so the freed address can't be sampled again in between
+        ::pthread_mutex_lock(&g_mutex);
+        p = __libc_realloc(ptr, size);
+        if (p != nullptr) untrack(addr);
+        ::pthread_mutex_unlock(&g_mutex);
+    }
+    onAlloc(p, size);
+    return p;
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment % sizeof(void*) != 0 ||
+        (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void* p = allocateAligned(alignment, size);
+    if (p == nullptr) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return allocateAligned(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    return allocateAligned(alignment, size);
+}
+
+void* valloc(size_t size) {
+    void* p = __libc_valloc(size);
+    onAlloc(p, size);
+    return p;
+}
+
+}  // extern "C"
+
+void* operator new(size_t size) { return newOrThrow(size, 0); }
+void* operator new[](size_t size) { return newOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return newNothrow(size, 0);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return newNothrow(size, 0);
+}
+void* operator new(size_t size, std::align_val_t al) {
+    return newOrThrow(size, static_cast<size_t>(al));
+}
+void* operator new[](size_t size, std::align_val_t al) {
+    return newOrThrow(size, static_cast<size_t>(al));
+}
+void* operator new(size_t size, std::align_val_t al,
+                   const std::nothrow_t&) noexcept {
+    return newNothrow(size, static_cast<size_t>(al));
+}
+void* operator new[](size_t size, std::align_val_t al,
+                     const std::nothrow_t&) noexcept {
+    return newNothrow(size, static_cast<size_t>(al));
+}
+
+void operator delete(void* ptr) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    deallocate(ptr);
+}
+void operator delete(void* ptr, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
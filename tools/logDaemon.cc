@@ -0,0 +1,127 @@
+///
+/// @brief The one log writer of a host: drains a ShmLogRing into LogFiles
+/// @note Processes whose LuteLogger.ini sets `LOG_SHM_RING = /lute-log`
+///       append to the ring instead of running their own AsyncLogger; this
+///       daemon writes their lines, in the order they claimed room in the
+///       ring, to `<basename>.<time>.<host>.<pid>.log`, rolled like
+///       AsyncLogger's files. Start it before them: initLogger() falls back
+///       to a private AsyncLogger when there is no ring. The ring outlives
+///       the daemon, a restarted daemon carries on where it stopped.
+///       SIGINT / SIGTERM drain the ring and exit.
+/// @usage
+///     logDaemon [-c 64M] [-r 1G] [-p 86400] [-f 3] /lute-log Lute
+///       -c  ring capacity, rounded up to a power of 2 (64M)
+///       -r  roll size (1G)
+///       -p  roll period in seconds (86400, 3600 rolls hourly)
+///       -f  flush interval in seconds (3)
+///
+
+#include <Base/logger.h>
+#include <Base/shmLogRing.h>
+#include <Base/timestamp.h>
+#include <Base/utils.h>  // parseIEC
+#include <signal.h>      // sigaction
+#include <unistd.h>      // getopt
+
+#include <cerrno>   // errno
+#include <cstdio>   // fprintf
+#include <cstdlib>  // atoi
+#include <cstring>  // strerror
+
+namespace {
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) { g_stop = 1; }
+
+int usage(const char* name) {
+    ::fprintf(stderr,
+              "usage: %s [-c capacity] [-r rollSize] [-p rollPeriod] "
+              "[-f flushInterval] ring basename\n",
+              name);
+    return 1;
+}
+
+/// @brief Lines lost since the last call, reported in the log itself
+void reportDropped(Lute::LogFile* file, uint64_t dropped, uint64_t* reported) {
+    if (dropped == *reported) return;
+    char buf[256];
+    const int n = ::snprintf(
+        buf, sizeof buf, "Dropped %llu log lines at %s, the ring was full\n",
+        static_cast<unsigned long long>(dropped - *reported),
+        Lute::Timestamp::now().toFormattedString().c_str());
+    ::fputs(buf, stderr);
+    file->append(buf, n);
+    *reported = dropped;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    int64_t capacity = 64 << 20;
+    int64_t rollSize = 1 << 30;
+    int rollPeriod = Lute::LogFile::kDefaultRollPeriod;
+    int flushInterval = 3;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "c:r:p:f:")) != -1) {
+        if (opt == 'c' && Lute::parseIEC(optarg, &capacity) && capacity > 0)
+            continue;
+        if (opt == 'r' && Lute::parseIEC(optarg, &rollSize) && rollSize > 0)
+            continue;
+        if (opt == 'p' && ::atoi(optarg) > 0) {
+            rollPeriod = ::atoi(optarg);
+            continue;
+        }
+        if (opt == 'f' && ::atoi(optarg) > 0) {
+            flushInterval = ::atoi(optarg);
+            continue;
+        }
+        return usage(argv[0]);
+    }
+    if (argc - optind != 2) return usage(argv[0]);
+    const char* name = argv[optind];
+    const char* basename = argv[optind + 1];
+
+    std::unique_ptr<Lute::ShmLogRing> ring =
+        Lute::ShmLogRing::create(name, static_cast<size_t>(capacity));
+    if (!ring) {
+        ::fprintf(stderr, "can't create ring %s: %s\n", name,
+                  ::strerror(errno));
+        return 1;
+    }
+
+    struct sigaction sa;
+    ::memset(&sa, 0, sizeof sa);
+    sa.sa_handler = onSignal;
+    /// no SA_RESTART: the signal ends the futex wait
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+
+    Lute::LogFile file(basename, static_cast<off_t>(rollSize), false,
+                       flushInterval);
+    file.setRollPeriod(rollPeriod);
+    const auto write = [&file](const char* line, int len) {
+        file.append(line, len);
+    };
+    uint64_t reported = ring->dropped();
+    bool dirty = false;
+    while (!g_stop) {
+        if (ring->drain(write) > 0) {
+            dirty = true;
+            continue;
+        }
+        reportDropped(&file, ring->dropped(), &reported);
+        /// caught up: what was written reaches the file before we sleep
+        if (dirty) {
+            file.flush();
+            dirty = false;
+        }
+        /// a claim nobody commits is checked for a dead writer soon
+        const int timeoutMs = ring->used() > 0 ? 100 : flushInterval * 1000;
+        if (!ring->waitForData(timeoutMs) && ring->used() > 0)
+            ring->skipDeadWriter();
+    }
+
+    ring->drain(write);
+    reportDropped(&file, ring->dropped(), &reported);
+    file.flush();
+    return 0;
+}
@@ -0,0 +1,219 @@
+///
+/// @brief Interleave the files of a ShardedAsyncLogger by timestamp
+/// @note A record is a line starting with `YYYY/MM/DD hh:mm:ss[.uuuuuu]`
+///       plus the lines after it that don't, so multi-line messages stay
+///       together. Each file is sorted within a window (-w, milliseconds,
+///       100 by default) that must cover how long a logging thread may be
+///       descheduled, then the files are k-way merged; equal timestamps
+///       keep file order, then the order of the files on the command line.
+///       Logger::setMicroseconds(true), which initLogger() turns on for
+///       LOG_SHARDS > 1, gives the timestamps enough resolution to
+///       interleave within a second.
+/// @usage
+///     logMerge Lute-*.log > merged.log
+///     logMerge -w 500 -o merged.log Lute-0.*.log Lute-1.*.log
+///
+
+#include <unistd.h>  // getopt
+
+#include <algorithm>  // max
+#include <cstdint>    // int64_t
+#include <cstdio>     // FILE getline
+#include <cstdlib>    // free atoi
+#include <cstring>    // memset
+#include <ctime>      // timegm
+#include <map>        // multimap
+#include <queue>      // priority_queue
+#include <string>     // string
+#include <utility>    // move
+#include <vector>     // vector
+
+namespace {
+/// `YYYY/MM/DD hh:mm:ss`
+const size_t kTimeLength = 19;
+
+bool startsWithTime(const char* line, size_t len) {
+    if (len < kTimeLength) return false;
+    for (size_t i = 0; i < kTimeLength; ++i) {
+        const char c = line[i];
+        switch (i) {
+            case 4:
+            case 7:
+                if (c != '/') return false;
+                break;
+            case 10:
+                if (c != ' ') return false;
+                break;
+            case 13:
+            case 16:
+                if (c != ':') return false;
+                break;
+            default:
+                if (c < '0' || c > '9') return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Microseconds since the epoch, as if the timestamp were UTC
+int64_t timeKey(const char* line, size_t len) {
+    const auto number = [line](size_t pos, size_t digits) {
+        int n = 0;
+        for (size_t i = pos; i < pos + digits; ++i) n = n * 10 + line[i] - '0';
+        return n;
+    };
+    struct tm tm;
+    ::memset(&tm, 0, sizeof tm);
+    tm.tm_year = number(0, 4) - 1900;
+    tm.tm_mon = number(5, 2) - 1;
+    tm.tm_mday = number(8, 2);
+    tm.tm_hour = number(11, 2);
+    tm.tm_min = number(14, 2);
+    tm.tm_sec = number(17, 2);
+    int64_t micros = 0;
+    size_t n = kTimeLength;
+    if (n < len && line[n] == '.') {
+        int digits = 0;
+        for (++n; n < len && line[n] >= '0' && line[n] <= '9'; ++n) {
+            if (digits++ < 6) micros = micros * 10 + line[n] - '0';
+        }
+        for (; digits < 6; ++digits) micros *= 10;
+    }
+    return static_cast<int64_t>(::timegm(&tm)) * 1000000 + micros;
+}
+
+///
+/// @brief The records of one file, reordered within a time window.
+///        A thread takes its timestamp before it reserves room in the
+///        shard's buffer, so a thread preempted in between lands behind
+///        lines stamped later: a file is only ordered up to that delay.
+///
+class Input {
+public:
+    Input(FILE* fp, int64_t windowUs)
+        : fp_(fp), windowUs_(windowUs), line_(nullptr), cap_(0), len_(0) {
+        readLine();
+        fill();
+    }
+    ~Input() {
+        ::free(line_);
+        ::fclose(fp_);
+    }
+
+    bool done() const { return pending_.empty(); }
+    int64_t key() const { return pending_.begin()->first; }
+    const std::string& record() const { return pending_.begin()->second; }
+
+    /// @brief Drop the current record
+    void next() {
+        pending_.erase(pending_.begin());
+        fill();
+    }
+
+private:
+    /// @brief Read ahead until the window past the first record is loaded
+    void fill() {
+        while (len_ > 0 &&
+               (pending_.empty() || newest_ - key() <= windowUs_)) {
+            /// lines before the first timestamp sort first
+            int64_t k = 0;
+            if (startsWithTime(line_, len_)) {
+                k = timeKey(line_, len_);
+                newest_ = std::max(newest_, k);
+            }
+            std::string record;
+            do {
+                record.append(line_, len_);
+                readLine();
+            } while (len_ > 0 && !startsWithTime(line_, len_));
+            /// equal keys stay in file order
+            pending_.emplace_hint(pending_.end(), k, std::move(record));
+        }
+    }
+
+    void readLine() {
+        const ssize_t n = ::getline(&line_, &cap_, fp_);
+        len_ = n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    FILE* fp_;
+    const int64_t windowUs_;
+    char* line_;
+    size_t cap_;
+    size_t len_;
+    int64_t newest_ = 0;
+    std::multimap<int64_t, std::string> pending_;
+};
+
+/// @brief Orders the heap: earliest timestamp first, then file order
+struct Later {
+    const std::vector<Input*>* inputs;
+    bool operator()(size_t a, size_t b) const {
+        const int64_t x = (*inputs)[a]->key();
+        const int64_t y = (*inputs)[b]->key();
+        if (x != y) return x > y;
+        return a > b;
+    }
+};
+int usage(const char* name) {
+    ::fprintf(stderr, "usage: %s [-w ms] [-o merged.log] file...\n", name);
+    return 1;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* outName = nullptr;
+    int windowMs = 100;
+    int opt;
+    while ((opt = ::getopt(argc, argv, "o:w:")) != -1) {
+        if (opt == 'o') {
+            outName = optarg;
+        } else if (opt == 'w' && ::atoi(optarg) >= 0) {
+            windowMs = ::atoi(optarg);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (optind >= argc) return usage(argv[0]);
+
+    FILE* out = outName ? ::fopen(outName, "we") : stdout;
+    if (out == nullptr) {
+        ::fprintf(stderr, "can't write %s\n", outName);
+        return 1;
+    }
+    static char outBuffer[1 << 20];
+    ::setvbuf(out, outBuffer, _IOFBF, sizeof outBuffer);
+
+    std::vector<Input*> inputs;
+    for (int i = optind; i < argc; ++i) {
+        FILE* fp = ::fopen(argv[i], "re");
+        if (fp == nullptr) {
+            ::fprintf(stderr, "can't read %s\n", argv[i]);
+            return 1;
+        }
+        inputs.push_back(
+            new Input(fp, static_cast<int64_t>(windowMs) * 1000));
+    }
+
+    std::priority_queue<size_t, std::vector<size_t>, Later> heap(
+        Later{&inputs});
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (!inputs[i]->done()) heap.push(i);
+    }
+    while (!heap.empty()) {
+        const size_t i = heap.top();
+        heap.pop();
+        const std::string& record = inputs[i]->record();
+        ::fwrite(record.data(), 1, record.size(), out);
+        inputs[i]->next();
+        if (!inputs[i]->done()) heap.push(i);
+    }
+
+    for (Input* input : inputs) delete input;
+    if (::fflush(out) != 0) {
+        ::perror("write");
+        return 1;
+    }
+    if (out != stdout) ::fclose(out);
+    return 0;
+}
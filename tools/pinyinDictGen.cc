@@ -0,0 +1,62 @@
+///
+/// @brief Build step: compile pinyin.txt into the tables of
+///        PinyinDict::builtin()
+/// @usage
+///     pinyinDictGen pinyin.txt pinyinDictData.cc
+///
+
+#include <Base/pinyinDict.h>
+
+#include <cinttypes>  // PRIx32
+#include <cstdio>     // FILE fprintf
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        ::fprintf(stderr, "usage: %s pinyin.txt output.cc\n", argv[0]);
+        return 1;
+    }
+
+    Lute::PinyinDict dict;
+    if (dict.load(argv[1]) != 0) {
+        ::fprintf(stderr, "can't read %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* fp = ::fopen(argv[2], "we");
+    if (fp == nullptr) {
+        ::fprintf(stderr, "can't write %s\n", argv[2]);
+        return 1;
+    }
+
+    ::fprintf(fp,
+              "// Generated from %s by pinyinDictGen, do not edit\n\n"
+              "#include <Base/pinyinDict.h>\n\n"
+              "namespace {\n\n"
+              "const char kBlob[] =",
+              argv[1]);
+    const Lute::string_view blob = dict.blob();
+    for (size_t i = 0; i < blob.size(); ++i) {
+        if (i % 64 == 0) ::fputs(i == 0 ? "\n    \"" : "\"\n    \"", fp);
+        const auto c = static_cast<unsigned char>(blob[i]);
+        if (c < 0x20 || c >= 0x7F || c == '"' || c == '\\')
+            ::fprintf(fp, "\\%03o", c);
+        else
+            ::fputc(c, fp);
+    }
+    ::fprintf(fp, "%s;\n\nconst uint32_t kEntries[Lute::PinyinDict::kSize] = {",
+              blob.empty() ? " \"\"" : "\"");
+    const uint32_t* entries = dict.entries();
+    for (uint32_t i = 0; i < Lute::PinyinDict::kSize; ++i) {
+        ::fprintf(fp, "%s0x%" PRIx32 ",", i % 8 == 0 ? "\n    " : " ",
+                  entries[i]);
+    }
+    ::fprintf(fp,
+              "\n};\n\n"
+              "}  // namespace\n\n"
+              "const Lute::PinyinDict& Lute::PinyinDict::builtin() {\n"
+              "    static const PinyinDict dict(kEntries, kBlob, %zu, %zu);\n"
+              "    return dict;\n"
+              "}\n",
+              blob.size(), dict.size());
+    return ::fclose(fp) == 0 ? 0 : 1;
+}